@@ -0,0 +1,297 @@
+/***********************************************************************
+ * Header:
+ *    BOUNDED SET
+ * Summary:
+ *    A hash set with a hard cap on its size, for "recently seen"
+ *    filters. Once the set holds capacity keys, inserting another
+ *    evicts one chosen by the CLOCK algorithm.
+ *
+ *    The buckets are laid out exactly like unordered_set's, linear
+ *    probed from |key| % numBuckets, but never grow: there are always
+ *    twice as many buckets as the capacity. Beside them is one
+ *    reference bit per bucket, set whenever its key is found or
+ *    inserted again. The clock hand sweeps the buckets in order: a key
+ *    with its bit set loses the bit and is passed over, the first key
+ *    without one is evicted. New keys start without the bit, so a burst
+ *    of keys seen only once cannot push out the ones seen repeatedly.
+ *
+ *        buckets: |   |31 |   |   |   |55 |   |67 |   |   |
+ *        refs:      0   1   0   0   0   0   0   1   0   0
+ *                       ^
+ *                      hand     31 loses its bit, 55 is evicted
+ *
+ *    The hand looks at no more than HASH_CLOCK_WINDOW keys per
+ *    eviction. If every one of them has its bit, they all lose it and
+ *    the first is evicted anyway, so even a table where every key was
+ *    just used costs a bounded sweep rather than a lap of the table.
+ *
+ *    This will contain the class definition of:
+ *        bounded_unordered_set : A hash set that evicts at capacity
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>          // for assert()
+#include <cstdint>          // for uint64_t
+#include <cstring>          // for std::memset
+#include "hash.h"           // for HASH_EMPTY_VALUE and unordered_set::iterator
+
+#define HASH_CLOCK_WINDOW 16   // most keys the hand looks at per eviction
+
+class TestBoundedSet;       // forward declaration for BoundedSet unit tests
+
+namespace custom
+{
+/************************************************
+ * BOUNDED UNORDERED SET
+ * A hash that evicts with CLOCK once it is full
+ ************************************************/
+class bounded_unordered_set
+{
+   friend class ::TestBoundedSet;   // give unit tests access to the privates
+public:
+   // walking the buckets is exactly walking an unordered_set's
+   typedef unordered_set::iterator iterator;
+
+   //
+   // Construct
+   //
+   explicit bounded_unordered_set(size_t capacity) : maxElements(capacity), numElements(0),
+                                                     numEvictions(0), hand(0)
+   {
+      assert(capacity > 0);
+      numBuckets = (capacity * 2 < 10) ? 10 : capacity * 2;
+      buckets = new int[numBuckets];
+      refs = new uint64_t[(numBuckets + 63) / 64];
+      clear();
+   }
+   bounded_unordered_set(const bounded_unordered_set& rhs) = delete;
+   ~bounded_unordered_set()
+   {
+      delete [] buckets;
+      delete [] refs;
+   }
+   bounded_unordered_set& operator=(const bounded_unordered_set& rhs) = delete;
+
+   //
+   // Iterator
+   //
+   iterator begin()
+   {
+      iterator it(buckets, buckets + numBuckets);
+      if (buckets[0] == HASH_EMPTY_VALUE)
+         ++it;
+      return it;
+   }
+   iterator end()
+   {
+      return iterator(buckets + numBuckets, buckets + numBuckets);
+   }
+
+   //
+   // Access
+   //
+   size_t bucket(const int& t) const
+   {
+      return simd::fold(t) % numBuckets;
+   }
+   iterator find(const int& t);
+
+   //
+   // Insert: evicts a key first if the set is full
+   //
+   iterator insert(const int& t);
+
+   //
+   // Remove
+   //
+   void clear() noexcept
+   {
+      for (size_t i = 0; i < numBuckets; ++i)
+         buckets[i] = HASH_EMPTY_VALUE;
+      std::memset(refs, 0, (numBuckets + 63) / 64 * sizeof(uint64_t));
+      numElements = 0;
+      hand = 0;
+   }
+   size_t erase(const int& t);
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements;
+   }
+   bool empty() const
+   {
+      return numElements == 0;
+   }
+   size_t capacity() const
+   {
+      return maxElements;
+   }
+   size_t bucket_count() const
+   {
+      return numBuckets;
+   }
+   size_t evictions() const
+   {
+      return numEvictions;
+   }
+
+private:
+   size_t probe(const int& t) const;
+   void removeAt(size_t i);
+   void evict();
+   size_t next(size_t i) const
+   {
+      return (i + 1 == numBuckets) ? 0 : i + 1;
+   }
+
+   // the reference bit of bucket i
+   bool referenced(size_t i) const
+   {
+      return (refs[i / 64] >> (i % 64)) & 1;
+   }
+   void reference(size_t i, bool on)
+   {
+      if (on)
+         refs[i / 64] |= (uint64_t)1 << (i % 64);
+      else
+         refs[i / 64] &= ~((uint64_t)1 << (i % 64));
+   }
+
+   int*      buckets;      // numBuckets buckets, HASH_EMPTY_VALUE when not filled
+   uint64_t* refs;         // one reference bit per bucket
+   size_t    numBuckets;   // twice the capacity, and never more
+   size_t    maxElements;  // the most keys the set will hold
+   size_t    numElements;  // number of keys in the set
+   size_t    numEvictions; // keys evicted so far
+   size_t    hand;         // the bucket the clock looks at next
+};
+
+
+/*****************************************
+ * BOUNDED UNORDERED SET :: PROBE
+ * The bucket holding t, or the empty bucket that ends its run
+ ****************************************/
+inline size_t bounded_unordered_set::probe(const int& t) const
+{
+   size_t i = bucket(t);
+   while (buckets[i] != HASH_EMPTY_VALUE && buckets[i] != t)
+      i = next(i);
+   return i;
+}
+
+/*****************************************
+ * BOUNDED UNORDERED SET :: FIND
+ * Finding a key counts as using it
+ ****************************************/
+inline bounded_unordered_set::iterator bounded_unordered_set::find(const int& t)
+{
+   size_t i = probe(t);
+   if (buckets[i] == HASH_EMPTY_VALUE)
+      return end();
+   reference(i, true);
+   return iterator(buckets + i, buckets + numBuckets);
+}
+
+/*****************************************
+ * BOUNDED UNORDERED SET :: INSERT
+ ****************************************/
+inline bounded_unordered_set::iterator bounded_unordered_set::insert(const int& t)
+{
+   // HASH_EMPTY_VALUE marks a hole, so it cannot be a key
+   assert(t != HASH_EMPTY_VALUE);
+
+   size_t i = probe(t);
+   if (buckets[i] == HASH_EMPTY_VALUE && numElements == maxElements)
+   {
+      // eviction shifts keys around, so look again afterwards
+      evict();
+      i = probe(t);
+   }
+
+   if (buckets[i] == HASH_EMPTY_VALUE)
+   {
+      buckets[i] = t;
+      ++numElements;
+   }
+   else
+      reference(i, true);   // seen again
+   return iterator(buckets + i, buckets + numBuckets);
+}
+
+/*****************************************
+ * BOUNDED UNORDERED SET :: ERASE
+ * Returns the number of keys removed
+ ****************************************/
+inline size_t bounded_unordered_set::erase(const int& t)
+{
+   size_t i = probe(t);
+   if (buckets[i] == HASH_EMPTY_VALUE)
+      return 0;
+   removeAt(i);
+   return 1;
+}
+
+/*****************************************
+ * BOUNDED UNORDERED SET :: EVICT
+ * Advance the hand, clearing reference bits, to the first key that
+ * has not been used since the hand last passed, and remove it. After
+ * HASH_CLOCK_WINDOW keys without one, remove the first of them.
+ ****************************************/
+inline void bounded_unordered_set::evict()
+{
+   size_t first = numBuckets;
+   for (size_t seen = 0;; hand = next(hand))
+   {
+      if (buckets[hand] == HASH_EMPTY_VALUE)
+         continue;
+      if (!referenced(hand))
+         break;
+      reference(hand, false);
+      if (first == numBuckets)
+         first = hand;
+      if (++seen == HASH_CLOCK_WINDOW)
+      {
+         hand = first;
+         break;
+      }
+   }
+
+   // the hand stays put: whatever is shifted into the victim's bucket
+   // has not been looked at yet
+   removeAt(hand);
+   ++numEvictions;
+}
+
+/*****************************************
+ * BOUNDED UNORDERED SET :: REMOVE AT
+ * Backward-shift deletion as in unordered_set::erase(), with each
+ * key's reference bit travelling along with it
+ ****************************************/
+inline void bounded_unordered_set::removeAt(size_t i)
+{
+   --numElements;
+
+   size_t hole = i;
+   for (size_t j = next(i); buckets[j] != HASH_EMPTY_VALUE; j = next(j))
+   {
+      size_t home = bucket(buckets[j]);
+      bool movable = (hole <= j) ? (home <= hole || home > j)
+                                 : (home <= hole && home > j);
+      if (movable)
+      {
+         buckets[hole] = buckets[j];
+         reference(hole, referenced(j));
+         hole = j;
+      }
+   }
+   buckets[hole] = HASH_EMPTY_VALUE;
+   reference(hole, false);
+}
+
+}
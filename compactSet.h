@@ -0,0 +1,394 @@
+/***********************************************************************
+ * Header:
+ *    COMPACT SET
+ * Summary:
+ *    An insertion-ordered hash laid out like Python's dict
+ *
+ *    The keys live densely, in the order they were inserted, in an
+ *    entries array. Hashing goes through a separate index of small
+ *    integers: index slot 0 means empty, anything else is one more
+ *    than the position of a key in entries. The index slots are 1, 2
+ *    or 4 bytes wide, whichever is the smallest that can count every
+ *    entry. Iteration is a linear scan over the entries, so it costs
+ *    O(size) no matter how large the index is.
+ *
+ *        entries:  +----+----+----+
+ *                  | 55 | 67 | 31 |            insertion order
+ *                  +----+----+----+
+ *                    0    1    2
+ *        index:    +---+---+---+---+---+---+---+---+---+---+
+ *                  |   | 3 |   |   |   | 1 |   | 2 |   |   |
+ *                  +---+---+---+---+---+---+---+---+---+---+
+ *                    0   1   2   3   4   5   6   7   8   9
+ *
+ *    Erasing a key leaves a hole (HASH_EMPTY_VALUE) in entries so the
+ *    order of the others is kept. Holes are squeezed out once they
+ *    make up half the entries.
+ *
+ *    This will contain the class definition of:
+ *        compact_unordered_set : An insertion-ordered hash
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>          // for assert()
+#include <cstdint>          // for uint8_t, uint16_t, uint32_t
+#include <cstring>          // for std::memcpy
+#include <initializer_list> // for std::initializer_list
+#include <memory>           // for std::unique_ptr
+#include <utility>          // for std::swap
+#include "hash.h"           // for HASH_EMPTY_VALUE and unordered_set::iterator
+
+class TestCompactSet;       // forward declaration for CompactSet unit tests
+
+namespace custom
+{
+/************************************************
+ * COMPACT UNORDERED SET
+ * A hash that keeps its keys in insertion order
+ ************************************************/
+class compact_unordered_set
+{
+   friend class ::TestCompactSet;   // give unit tests access to the privates
+public:
+   // walking the entries is exactly walking an unordered_set's buckets:
+   // skip the holes, stop at the end
+   typedef unordered_set::iterator iterator;
+
+   //
+   // Construct
+   //
+   compact_unordered_set() : entries(nullptr), index(nullptr), numEntries(0),
+                             numElements(0), numSlots(0), slotWidth(1)
+   {
+      allocate(10);
+   }
+   compact_unordered_set(const compact_unordered_set& rhs) : compact_unordered_set()
+   {
+      *this = rhs;
+   }
+   // not noexcept: the rhs is left with a fresh empty index, which allocates
+   compact_unordered_set(compact_unordered_set&& rhs) : compact_unordered_set()
+   {
+      swap(rhs);
+   }
+   template <class Iterator>
+   compact_unordered_set(Iterator first, Iterator last) : compact_unordered_set()
+   {
+      while (first != last)
+      {
+         insert(*first);
+         ++first;
+      }
+   }
+   ~compact_unordered_set()
+   {
+      delete [] entries;
+      delete [] index;
+   }
+
+   //
+   // Assign
+   //
+   compact_unordered_set& operator=(const compact_unordered_set& rhs);
+   compact_unordered_set& operator=(compact_unordered_set&& rhs) noexcept
+   {
+      clear();
+      swap(rhs);
+      return *this;
+   }
+   void swap(compact_unordered_set& rhs) noexcept
+   {
+      std::swap(entries,     rhs.entries);
+      std::swap(index,       rhs.index);
+      std::swap(numEntries,  rhs.numEntries);
+      std::swap(numElements, rhs.numElements);
+      std::swap(numSlots,    rhs.numSlots);
+      std::swap(slotWidth,   rhs.slotWidth);
+   }
+
+   //
+   // Iterator
+   //
+   iterator begin()
+   {
+      int* pBegin = entries;
+      int* pEnd = entries + numEntries;
+      while (pBegin != pEnd && *pBegin == HASH_EMPTY_VALUE)
+         ++pBegin;
+      return iterator(pBegin, pEnd);
+   }
+   iterator end()
+   {
+      return iterator(entries + numEntries, entries + numEntries);
+   }
+
+   //
+   // Access
+   //
+   size_t bucket(const int& t) const
+   {
+      return simd::fold(t) % numSlots;
+   }
+   iterator find(const int& t);
+
+   //
+   // Insert
+   //
+   iterator insert(const int& t);
+   void insert(const std::initializer_list<int>& il)
+   {
+      for (const int& value : il)
+         insert(value);
+   }
+
+   //
+   // Remove
+   //
+   void clear() noexcept
+   {
+      std::memset(index, 0, numSlots * slotWidth);
+      numEntries = 0;
+      numElements = 0;
+   }
+   size_t erase(const int& t);
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements;
+   }
+   bool empty() const
+   {
+      return numElements == 0;
+   }
+   size_t bucket_count() const
+   {
+      return numSlots;
+   }
+
+private:
+   void allocate(size_t slots);
+   void rebuild(size_t slots);
+   size_t findSlot(const int& t) const;
+   size_t next(size_t i) const
+   {
+      return (i + 1 == numSlots) ? 0 : i + 1;
+   }
+
+   // at most two thirds of the index may be in use, holes included
+   static size_t capacity(size_t slots)
+   {
+      return slots * 2 / 3;
+   }
+
+   // read and write index slot i, whatever its width
+   size_t getSlot(size_t i) const
+   {
+      switch (slotWidth)
+      {
+         case 1:  return ((const uint8_t*)index)[i];
+         case 2:  return ((const uint16_t*)index)[i];
+         default: return ((const uint32_t*)index)[i];
+      }
+   }
+   void setSlot(size_t i, size_t value)
+   {
+      switch (slotWidth)
+      {
+         case 1:  ((uint8_t*)index)[i]  = (uint8_t)value;  break;
+         case 2:  ((uint16_t*)index)[i] = (uint16_t)value; break;
+         default: ((uint32_t*)index)[i] = (uint32_t)value; break;
+      }
+   }
+
+   int*           entries;     // the keys in insertion order, with holes
+   unsigned char* index;       // numSlots slots of slotWidth bytes: 0 or entry+1
+   size_t         numEntries;  // entries used so far, holes included
+   size_t         numElements; // number of keys in the set
+   size_t         numSlots;    // number of slots in the index
+   unsigned char  slotWidth;   // bytes per index slot: 1, 2, or 4
+};
+
+
+/*****************************************
+ * COMPACT UNORDERED SET :: ASSIGN
+ ****************************************/
+inline compact_unordered_set& compact_unordered_set::operator=(const compact_unordered_set& rhs)
+{
+   if (this == &rhs)
+      return *this;
+
+   // same shape, so the index can be copied byte for byte. The old
+   // arrays go only once the new ones are in hand, so a throw leaves
+   // *this intact.
+   int* oldEntries = entries;
+   unsigned char* oldIndex = index;
+   allocate(rhs.numSlots);
+   std::memcpy(entries, rhs.entries, rhs.numEntries * sizeof(int));
+   std::memcpy(index, rhs.index, numSlots * slotWidth);
+   numEntries = rhs.numEntries;
+   numElements = rhs.numElements;
+
+   delete [] oldEntries;
+   delete [] oldIndex;
+   return *this;
+}
+
+/*****************************************
+ * COMPACT UNORDERED SET :: FIND SLOT
+ * The index slot that refers to t, or the empty slot where it
+ * would go
+ ****************************************/
+inline size_t compact_unordered_set::findSlot(const int& t) const
+{
+   size_t i = bucket(t);
+   for (size_t slot = getSlot(i); slot != 0; slot = getSlot(i))
+   {
+      if (entries[slot - 1] == t)
+         return i;
+      i = next(i);
+   }
+   return i;
+}
+
+/*****************************************
+ * COMPACT UNORDERED SET :: FIND
+ ****************************************/
+inline compact_unordered_set::iterator compact_unordered_set::find(const int& t)
+{
+   size_t slot = getSlot(findSlot(t));
+   if (slot == 0)
+      return end();
+   return iterator(entries + slot - 1, entries + numEntries);
+}
+
+/*****************************************
+ * COMPACT UNORDERED SET :: INSERT
+ * Append t to the entries, if it is not already there
+ ****************************************/
+inline compact_unordered_set::iterator compact_unordered_set::insert(const int& t)
+{
+   // HASH_EMPTY_VALUE marks a hole, so it cannot be a key
+   assert(t != HASH_EMPTY_VALUE);
+
+   size_t i = findSlot(t);
+   size_t slot = getSlot(i);
+   if (slot != 0)
+      return iterator(entries + slot - 1, entries + numEntries);
+
+   // out of entries: squeeze out the holes, growing the index unless
+   // that alone frees up enough room
+   if (numEntries == capacity(numSlots))
+   {
+      rebuild((numElements + 1) * 2 > capacity(numSlots) ? numSlots * 2 : numSlots);
+      i = findSlot(t);
+   }
+
+   entries[numEntries] = t;
+   setSlot(i, ++numEntries);
+   ++numElements;
+   return iterator(entries + numEntries - 1, entries + numEntries);
+}
+
+/*****************************************
+ * COMPACT UNORDERED SET :: ERASE
+ * Remove t, leaving a hole in the entries so the order holds.
+ * Returns the number of keys removed.
+ ****************************************/
+inline size_t compact_unordered_set::erase(const int& t)
+{
+   size_t hole = findSlot(t);
+   size_t slot = getSlot(hole);
+   if (slot == 0)
+      return 0;
+
+   // punch the hole in entries; holes at the end can simply be dropped
+   entries[slot - 1] = HASH_EMPTY_VALUE;
+   while (numEntries && entries[numEntries - 1] == HASH_EMPTY_VALUE)
+      --numEntries;
+   --numElements;
+
+   // backward-shift the index cluster so no probe run is cut short
+   for (size_t j = next(hole); getSlot(j) != 0; j = next(j))
+   {
+      size_t home = bucket(entries[getSlot(j) - 1]);
+      bool movable = (hole <= j) ? (home <= hole || home > j)
+                                 : (home <= hole && home > j);
+      if (movable)
+      {
+         setSlot(hole, getSlot(j));
+         hole = j;
+      }
+   }
+   setSlot(hole, 0);
+
+   // once holes are half the entries, squeeze them out
+   if ((numEntries - numElements) * 2 > numEntries)
+      rebuild(numSlots);
+   return 1;
+}
+
+/*****************************************
+ * COMPACT UNORDERED SET :: ALLOCATE
+ * An empty index of the given number of slots, with the narrowest
+ * slot that can refer to every entry it will hold. The old arrays are
+ * the caller's to free; if an allocation throws, nothing has changed.
+ ****************************************/
+inline void compact_unordered_set::allocate(size_t slots)
+{
+   size_t most = capacity(slots);
+   unsigned char width = (most < 0x100) ? 1 : (most < 0x10000) ? 2 : 4;
+   std::unique_ptr<int[]> newEntries(new int[most]);
+   std::unique_ptr<unsigned char[]> newIndex(new unsigned char[slots * width]);
+   std::memset(newIndex.get(), 0, slots * width);
+
+   entries = newEntries.release();
+   index = newIndex.release();
+   slotWidth = width;
+   numSlots = slots;
+   numEntries = 0;
+   numElements = 0;
+}
+
+/*****************************************
+ * COMPACT UNORDERED SET :: REBUILD
+ * Squeeze the holes out of entries, keeping the order, and index
+ * the keys again in an index of the given number of slots
+ ****************************************/
+inline void compact_unordered_set::rebuild(size_t slots)
+{
+   int* oldEntries = entries;
+   unsigned char* oldIndex = index;
+   size_t oldNum = numEntries;
+   allocate(slots);
+
+   for (size_t e = 0; e < oldNum; ++e)
+      if (oldEntries[e] != HASH_EMPTY_VALUE)
+      {
+         size_t i = bucket(oldEntries[e]);
+         while (getSlot(i) != 0)
+            i = next(i);
+         entries[numEntries] = oldEntries[e];
+         setSlot(i, ++numEntries);
+      }
+   numElements = numEntries;
+
+   delete [] oldEntries;
+   delete [] oldIndex;
+}
+
+/*****************************************
+ * SWAP
+ * Stand-alone compact unordered set swap
+ ****************************************/
+inline void swap(compact_unordered_set& lhs, compact_unordered_set& rhs)
+{
+   lhs.swap(rhs);
+}
+
+}
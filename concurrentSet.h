@@ -0,0 +1,524 @@
+/***********************************************************************
+ * Header:
+ *    CONCURRENT SET
+ * Summary:
+ *    A hash set many threads can use at once, laid out like
+ *    unordered_set: one array of buckets, linear probing from
+ *    |key| % numBuckets, doubling once half full.
+ *
+ *    Every bucket is a single 64-bit atomic word holding a state and a
+ *    key, so each change to a bucket is one compare-and-swap:
+ *
+ *        EMPTY  --insert-->  FULL  --erase-->  DELETED
+ *          |                  |                  |
+ *          |               FROZEN                |      (while moving)
+ *          |                  |                  |
+ *          +-------------> MOVED <---------------+
+ *
+ *    Erasing leaves a DELETED marker instead of shifting keys back,
+ *    since a shift cannot be done with one compare-and-swap.
+ *
+ *    Growing is cooperative, as in Java's ConcurrentHashMap transfer,
+ *    and blocking. The thread that notices the table is full links a
+ *    bigger table behind it. From then on, any thread that runs into
+ *    the old table claims the next chunk of HASH_TRANSFER_CHUNK buckets
+ *    and moves it, and once no chunks are left to claim, waits for the
+ *    others to finish theirs before it goes on in the new table. No
+ *    operation takes a lock, but none is lock-free either: a thread
+ *    stalled in the middle of a chunk holds up every thread that needs
+ *    the new table. A key is FROZEN while it is copied so that an erase
+ *    cannot slip in between the copy and the MOVED marker.
+ *
+ *    An old table may still be read by a slow thread. It goes on a
+ *    retired list and is freed by the next thread to leave the set
+ *    when no other thread is inside it, a one-counter form of
+ *    epoch-based reclamation. Under traffic so heavy the set is never
+ *    empty of threads, retired tables wait for the first lull.
+ *
+ *    This will contain the class definition of:
+ *        concurrent_unordered_set : A hash set safe to share between threads
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>           // for std::atomic
+#include <cstdint>          // for uint32_t, uint64_t
+#include <thread>           // for std::this_thread::yield()
+#include "simd.h"           // for simd::fold()
+
+#define HASH_TRANSFER_CHUNK 1024   // buckets a thread claims at a time while growing
+
+class TestConcurrentSet;    // forward declaration for ConcurrentSet unit tests
+
+namespace custom
+{
+/************************************************
+ * CONCURRENT UNORDERED SET
+ * A hash set without locks whose growth is cooperative and blocking
+ ************************************************/
+class concurrent_unordered_set
+{
+   friend class ::TestConcurrentSet;   // give unit tests access to the privates
+
+   // the state of a bucket, kept in the high half of its word
+   enum : uint32_t { SLOT_EMPTY, SLOT_FULL, SLOT_DELETED, SLOT_FROZEN, SLOT_MOVED };
+
+   /************************************************
+    * TABLE
+    * One bucket array, and the bookkeeping for moving out of it
+    ************************************************/
+   struct table
+   {
+      explicit table(size_t n) : slots(new std::atomic<uint64_t>[n]), numBuckets(n),
+                                 used(0), transferIndex(0), chunksDone(0), next(nullptr),
+                                 nextRetired(nullptr)
+      {
+         for (size_t i = 0; i < n; ++i)
+            slots[i].store(0, std::memory_order_relaxed);
+      }
+      ~table()
+      {
+         delete [] slots;
+      }
+      size_t chunks() const
+      {
+         return (numBuckets + HASH_TRANSFER_CHUNK - 1) / HASH_TRANSFER_CHUNK;
+      }
+
+      std::atomic<uint64_t>* slots;         // state << 32 | key
+      size_t                 numBuckets;    // number of slots
+      std::atomic<size_t>    used;          // FULL and DELETED slots
+      std::atomic<size_t>    transferIndex; // next chunk to be claimed
+      std::atomic<size_t>    chunksDone;    // chunks completely moved
+      std::atomic<table*>    next;          // the table we are moving into
+      table*                 nextRetired;   // the next table waiting to be freed
+   };
+
+   /************************************************
+    * OPERATION
+    * Counts a thread into the set for as long as it may hold a table,
+    * and lets the last one out free the retired tables
+    ************************************************/
+   class operation
+   {
+   public:
+      explicit operation(concurrent_unordered_set& set) : set(set)
+      {
+         set.active.fetch_add(1);
+      }
+      ~operation()
+      {
+         set.leave();
+      }
+   private:
+      concurrent_unordered_set& set;
+   };
+
+public:
+   //
+   // Construct
+   //
+   concurrent_unordered_set() : concurrent_unordered_set(10) {}
+   explicit concurrent_unordered_set(size_t numBuckets) : retired(nullptr), active(0),
+      numElements(0), maxLoadFactor(0.5f)
+   {
+      current.store(new table(numBuckets < 10 ? 10 : numBuckets));
+   }
+   concurrent_unordered_set(const concurrent_unordered_set& rhs) = delete;
+   ~concurrent_unordered_set()
+   {
+      // no thread is left inside, so every table can go: the retired
+      // ones, the current one, and any it was still moving into
+      reclaim(retired.exchange(nullptr));
+      for (table* tab = current.load(); tab; )
+      {
+         table* next = tab->next.load();
+         delete tab;
+         tab = next;
+      }
+   }
+   concurrent_unordered_set& operator=(const concurrent_unordered_set& rhs) = delete;
+
+   //
+   // Access
+   //
+   bool contains(const int& t);
+   size_t count(const int& t)
+   {
+      return contains(t) ? 1 : 0;
+   }
+
+   //
+   // Insert and remove: true when the set changed
+   //
+   bool insert(const int& t);
+   bool erase(const int& t);
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements.load();
+   }
+   bool empty() const
+   {
+      return size() == 0;
+   }
+   size_t bucket_count()
+   {
+      operation op(*this);
+      return current.load()->numBuckets;
+   }
+   float max_load_factor() const
+   {
+      return maxLoadFactor;
+   }
+
+private:
+   static uint64_t pack(uint32_t state, int t)
+   {
+      return ((uint64_t)state << 32) | (uint32_t)t;
+   }
+   static uint32_t stateOf(uint64_t v)
+   {
+      return (uint32_t)(v >> 32);
+   }
+   static int keyOf(uint64_t v)
+   {
+      return (int)(uint32_t)v;
+   }
+   static size_t bucket(const table* tab, const int& t)
+   {
+      return simd::fold(t) % tab->numBuckets;
+   }
+   static size_t next(const table* tab, size_t i)
+   {
+      return (i + 1 == tab->numBuckets) ? 0 : i + 1;
+   }
+
+   table* resize(table* tab);
+   table* help(table* tab);
+   bool claim(table* tab);
+   void transfer(table* tab, size_t chunk);
+   static void place(table* tab, int t);
+   void retire(table* first);
+   void leave();
+   static void reclaim(table* first);
+
+   std::atomic<table*> current;      // where new operations start
+   std::atomic<table*> retired;      // tables moved out of, not yet freed
+   std::atomic<size_t> active;       // threads inside an operation
+   std::atomic<size_t> numElements;  // number of keys in the set
+   const float         maxLoadFactor;// grow once this share of the slots is used
+};
+
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: CONTAINS
+ * A FROZEN key is still in the set; a MOVED bucket sends us on to
+ * the next table
+ ****************************************/
+inline bool concurrent_unordered_set::contains(const int& t)
+{
+   operation op(*this);
+   table* tab = current.load();
+   for (;;)
+   {
+      size_t i = bucket(tab, t);
+      bool moved = false;
+      for (size_t n = 0; n < tab->numBuckets && !moved; ++n, i = next(tab, i))
+      {
+         uint64_t v = tab->slots[i].load(std::memory_order_acquire);
+         switch (stateOf(v))
+         {
+            case SLOT_EMPTY:
+               return false;
+            case SLOT_FULL:
+            case SLOT_FROZEN:
+               if (keyOf(v) == t)
+                  return true;
+               break;
+            case SLOT_MOVED:
+               moved = true;
+               break;
+         }
+      }
+      if (!moved)
+         return false;
+      tab = help(tab);
+   }
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: INSERT
+ * Claim the first EMPTY bucket on t's probe run, unless t is
+ * already on it. A table that is being moved is helped along first.
+ ****************************************/
+inline bool concurrent_unordered_set::insert(const int& t)
+{
+   operation op(*this);
+   table* tab = current.load();
+   for (;;)
+   {
+      if (tab->next.load(std::memory_order_acquire))
+      {
+         tab = help(tab);
+         continue;
+      }
+
+      size_t i = bucket(tab, t);
+      bool moving = false;
+      for (size_t n = 0; n < tab->numBuckets && !moving; ++n, i = next(tab, i))
+      {
+         uint64_t v = tab->slots[i].load(std::memory_order_acquire);
+         while (stateOf(v) == SLOT_EMPTY)
+         {
+            if (tab->slots[i].compare_exchange_weak(v, pack(SLOT_FULL, t),
+                                                    std::memory_order_acq_rel))
+            {
+               numElements.fetch_add(1);
+               if (tab->used.fetch_add(1) + 1 > (size_t)(tab->numBuckets * maxLoadFactor))
+                  resize(tab);
+               return true;
+            }
+         }
+
+         uint32_t state = stateOf(v);
+         if (state == SLOT_FROZEN || state == SLOT_MOVED)
+            moving = true;
+         else if (state == SLOT_FULL && keyOf(v) == t)
+            return false;
+      }
+
+      // the table is moving, or so full of DELETED markers that there
+      // was nowhere to go: either way, carry on in the next table
+      tab = resize(tab);
+   }
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: ERASE
+ * Turn t's bucket from FULL to DELETED
+ ****************************************/
+inline bool concurrent_unordered_set::erase(const int& t)
+{
+   operation op(*this);
+   table* tab = current.load();
+   for (;;)
+   {
+      if (tab->next.load(std::memory_order_acquire))
+      {
+         tab = help(tab);
+         continue;
+      }
+
+      size_t i = bucket(tab, t);
+      bool moving = false;
+      for (size_t n = 0; n < tab->numBuckets && !moving; ++n, i = next(tab, i))
+      {
+         uint64_t v = tab->slots[i].load(std::memory_order_acquire);
+         if (stateOf(v) == SLOT_EMPTY)
+            return false;
+         while (stateOf(v) == SLOT_FULL && keyOf(v) == t)
+         {
+            if (tab->slots[i].compare_exchange_weak(v, pack(SLOT_DELETED, t),
+                                                    std::memory_order_acq_rel))
+            {
+               numElements.fetch_sub(1);
+               return true;
+            }
+         }
+
+         // a DELETED t is an earlier copy; a newer one may be further on
+         uint32_t state = stateOf(v);
+         if (state == SLOT_FROZEN || state == SLOT_MOVED)
+            moving = true;
+      }
+      if (!moving)
+         return false;
+      tab = help(tab);
+   }
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: RESIZE
+ * Link a new table behind tab, unless some other thread beat us to
+ * it, then help move into it. The new table normally doubles; when
+ * tab is mostly DELETED markers it keeps its size and the move simply
+ * sweeps them out.
+ ****************************************/
+inline concurrent_unordered_set::table* concurrent_unordered_set::resize(table* tab)
+{
+   if (!tab->next.load(std::memory_order_acquire))
+   {
+      // double unless the move would at least halve the used slots,
+      // so that sweeping never happens again right away
+      double live = (double)numElements.load() + 1.0;
+      size_t n = tab->numBuckets;
+      if (live > n * maxLoadFactor / 2.0)
+         n *= 2;
+      while (live > n * maxLoadFactor)
+         n *= 2;
+
+      table* grown = new table(n);
+      table* expected = nullptr;
+      if (!tab->next.compare_exchange_strong(expected, grown, std::memory_order_acq_rel))
+         delete grown;
+   }
+   return help(tab);
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: HELP
+ * Move chunks of tab until none are left to claim, wait for the
+ * threads still moving theirs, then make the next table current.
+ * Whoever does that retires tab. Returns the next table.
+ ****************************************/
+inline concurrent_unordered_set::table* concurrent_unordered_set::help(table* tab)
+{
+   table* grown = tab->next.load(std::memory_order_acquire);
+   while (claim(tab))
+      ;
+
+   size_t chunks = tab->chunks();
+   while (tab->chunksDone.load(std::memory_order_acquire) < chunks)
+      std::this_thread::yield();
+
+   table* expected = tab;
+   if (current.compare_exchange_strong(expected, grown))
+      retire(tab);
+   return grown;
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: CLAIM
+ * Take the next unclaimed chunk of tab and move it. False once
+ * every chunk has been claimed.
+ ****************************************/
+inline bool concurrent_unordered_set::claim(table* tab)
+{
+   size_t chunk = tab->transferIndex.fetch_add(1);
+   if (chunk >= tab->chunks())
+      return false;
+
+   transfer(tab, chunk);
+   tab->chunksDone.fetch_add(1, std::memory_order_acq_rel);
+   return true;
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: TRANSFER
+ * Move one chunk of tab into the next table. Each bucket ends MOVED;
+ * a FULL one is FROZEN first so its key cannot be erased while it is
+ * being copied.
+ ****************************************/
+inline void concurrent_unordered_set::transfer(table* tab, size_t chunk)
+{
+   table* grown = tab->next.load(std::memory_order_acquire);
+   size_t end = (chunk + 1) * HASH_TRANSFER_CHUNK;
+   if (end > tab->numBuckets)
+      end = tab->numBuckets;
+
+   for (size_t i = chunk * HASH_TRANSFER_CHUNK; i < end; ++i)
+   {
+      uint64_t v = tab->slots[i].load(std::memory_order_acquire);
+      for (;;)
+      {
+         uint32_t state = stateOf(v);
+         if (state == SLOT_FULL)
+         {
+            if (tab->slots[i].compare_exchange_weak(v, pack(SLOT_FROZEN, keyOf(v)),
+                                                    std::memory_order_acq_rel))
+               v = pack(SLOT_FROZEN, keyOf(v));
+         }
+         else if (state == SLOT_FROZEN)
+         {
+            place(grown, keyOf(v));
+            tab->slots[i].store(pack(SLOT_MOVED, 0), std::memory_order_release);
+            break;
+         }
+         else if (state == SLOT_MOVED)
+            break;
+         else if (tab->slots[i].compare_exchange_weak(v, pack(SLOT_MOVED, 0),
+                                                      std::memory_order_acq_rel))
+            break;   // EMPTY or DELETED: nothing to copy
+      }
+   }
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: PLACE
+ * Put a key we know is not there yet into a table nobody else is
+ * inserting into, only moving
+ ****************************************/
+inline void concurrent_unordered_set::place(table* tab, int t)
+{
+   size_t i = bucket(tab, t);
+   for (;;)
+   {
+      uint64_t v = pack(SLOT_EMPTY, 0);
+      if (tab->slots[i].compare_exchange_strong(v, pack(SLOT_FULL, t),
+                                                std::memory_order_acq_rel))
+      {
+         tab->used.fetch_add(1);
+         return;
+      }
+      i = next(tab, i);
+   }
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: RETIRE
+ * Put a chain of tables no new operation can reach on the retired
+ * list, to be freed once the threads that may be reading them leave
+ ****************************************/
+inline void concurrent_unordered_set::retire(table* first)
+{
+   table* last = first;
+   while (last->nextRetired)
+      last = last->nextRetired;
+
+   table* head = retired.load();
+   do
+      last->nextRetired = head;
+   while (!retired.compare_exchange_weak(head, first));
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: LEAVE
+ * Count a thread out of the set. The last one out takes the retired
+ * list: nobody can still be reading those tables unless a thread came
+ * in meanwhile, in which case they go back on the list for later.
+ ****************************************/
+inline void concurrent_unordered_set::leave()
+{
+   if (active.fetch_sub(1) != 1 || retired.load() == nullptr)
+      return;
+
+   table* doomed = retired.exchange(nullptr);
+   if (doomed == nullptr)
+      return;
+   if (active.load() != 0)
+      retire(doomed);
+   else
+      reclaim(doomed);
+}
+
+/*****************************************
+ * CONCURRENT UNORDERED SET :: RECLAIM
+ * Delete a chain of retired tables
+ ****************************************/
+inline void concurrent_unordered_set::reclaim(table* first)
+{
+   while (first)
+   {
+      table* nextRetired = first->nextRetired;
+      delete first;
+      first = nextRetired;
+   }
+}
+
+}
@@ -0,0 +1,449 @@
+/***********************************************************************
+ * Header:
+ *    EXTERNAL SET
+ * Summary:
+ *    Distinct keys of a stream too big to dedup in memory.
+ *
+ *    Keys go into an ordinary unordered_set for as long as its buckets
+ *    fit in the memory budget. When they would not, the set spills:
+ *    every key in it, and every key that comes after, is sent by hash
+ *    to one of numPartitions run files on disk. Equal keys always land
+ *    in the same run, so each run can be deduped on its own with an
+ *    unordered_set, and the results just follow one another. A run
+ *    still too big for the budget is split again the same way, with
+ *    the hash salted so that it splits differently.
+ *
+ *        keys --> unordered_set --(over budget)--> partitionBatch
+ *                                                   |  |  |  |
+ *                                                  run run .. run
+ *                                                   |  |  |  |
+ *                                      unordered_set per run --> distinct
+ *
+ *    Each partition fills a block in memory. A full block is handed to
+ *    a writer thread and the partition goes on filling a spare, so the
+ *    disk writes overlap with hashing the next keys instead of
+ *    stalling it.
+ *
+ *    This will contain the class definition of:
+ *        external_dedup : Distinct keys under a memory budget
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <condition_variable> // for std::condition_variable
+#include <cstdio>             // for FILE, std::fwrite
+#include <deque>              // for std::deque
+#include <mutex>              // for std::mutex
+#include <stdexcept>          // for std::runtime_error, std::logic_error
+#include <string>             // for std::string
+#include <thread>             // for std::thread
+#include <utility>            // for std::pair
+#include <vector>             // for std::vector
+#include "hash.h"             // for unordered_set
+#include "keyFile.h"          // for key_reader, to read the runs back
+
+#define HASH_SPILL_PARTITIONS 64   // run files per spill
+#define HASH_SPILL_LEVELS     4    // most times a run is split again
+
+class TestExternalDedup;      // forward declaration for ExternalDedup unit tests
+
+namespace custom
+{
+/************************************************
+ * EXTERNAL DEDUP
+ * The distinct keys of a stream, spilling to disk when needed
+ ************************************************/
+class external_dedup
+{
+   friend class ::TestExternalDedup;   // give unit tests access to the privates
+public:
+   //
+   // Construct: runs go in directory, or are anonymous temporary files
+   //
+   explicit external_dedup(size_t memoryBudget, const char* directory = nullptr,
+                           size_t numPartitions = HASH_SPILL_PARTITIONS) :
+      external_dedup(memoryBudget, directory, numPartitions, 0) {}
+   external_dedup(const external_dedup& rhs) = delete;
+   ~external_dedup();
+   external_dedup& operator=(const external_dedup& rhs) = delete;
+
+   //
+   // Insert
+   //
+   void insert(const int& t)
+   {
+      insert_batch(&t, 1);
+   }
+   void insert_batch(const int* keys, size_t n);
+
+   //
+   // Access: call visit(key) once for every distinct key, and return
+   // how many there were. Once spilled this reads the runs up, so it
+   // finishes the dedup: insert no more, and call it only once.
+   //
+   template <class Visit>
+   size_t for_each_distinct(Visit visit);
+
+   //
+   // Status
+   //
+   bool spilled() const
+   {
+      return !runs.empty();
+   }
+   size_t spilled_keys() const
+   {
+      return numSpilled;
+   }
+
+private:
+   external_dedup(size_t memoryBudget, const char* directory, size_t numPartitions,
+                  unsigned level);
+
+   void insertChunk(const int* keys, size_t n);
+   void spill();
+   void route(const int* keys, size_t n);
+   void submit(size_t part);
+   void finish();
+   void writeLoop();
+
+   // the key partitionBatch sees at this level: salted after the first
+   int salted(int t) const
+   {
+      uint32_t u = (uint32_t)t;
+      return (int)(((u << (level * 7)) | (u >> ((32 - level * 7) % 32))) ^ (level * 0x9E3779B9u));
+   }
+
+   unordered_set             set;           // the keys, while they fit
+   bool                      hasEmptyValue; // HASH_EMPTY_VALUE, which the set cannot hold
+   size_t                    memoryBudget;  // bytes the buckets may take
+   std::string               directory;     // where runs go, "" for temporary files
+   size_t                    numPartitions; // runs per spill
+   unsigned                  level;         // how many times these keys were split
+   size_t                    blockSize;     // keys per block
+   size_t                    numSpilled;    // keys written to runs
+
+   std::vector<FILE*>        runs;          // one file per partition
+   std::vector<std::string>  paths;         // their names, if named
+   std::vector<std::vector<int>> active;    // the block each partition is filling
+
+   std::thread               writer;        // writes full blocks to their runs
+   std::mutex                mutex;         // guards everything below
+   std::condition_variable   ready;         // a block is queued, or we are done
+   std::condition_variable   returned;      // a block is free again
+   std::deque<std::pair<size_t, std::vector<int>>> queue; // blocks waiting to be written
+   std::vector<std::vector<int>> spare;     // written blocks, ready to be filled
+   bool                      stopping;      // no more blocks will come
+   bool                      failed;        // a write did not complete
+   bool                      consumed;      // the runs have been read up
+};
+
+/*****************************************
+ * EXTERNAL DEDUP :: CONSTRUCTOR
+ ****************************************/
+inline external_dedup::external_dedup(size_t memoryBudget, const char* directory,
+                                      size_t numPartitions, unsigned level) :
+   hasEmptyValue(false), memoryBudget(memoryBudget), directory(directory ? directory : ""),
+   numPartitions(numPartitions < 2 ? 2 : numPartitions), level(level), numSpilled(0),
+   stopping(false), failed(false), consumed(false)
+{
+   // two blocks per partition should take about a quarter of the budget
+   blockSize = memoryBudget / (8 * this->numPartitions * sizeof(int));
+   if (blockSize < 1024)
+      blockSize = 1024;
+   if (blockSize > (1 << 16))
+      blockSize = 1 << 16;
+}
+
+/*****************************************
+ * EXTERNAL DEDUP :: DESTRUCTOR
+ * Stop the writer and throw the runs away
+ ****************************************/
+inline external_dedup::~external_dedup()
+{
+   finish();
+   for (size_t i = 0; i < runs.size(); ++i)
+   {
+      if (runs[i])
+         std::fclose(runs[i]);
+      if (i < paths.size())
+         std::remove(paths[i].c_str());
+   }
+}
+
+/*****************************************
+ * EXTERNAL DEDUP :: INSERT BATCH
+ ****************************************/
+inline void external_dedup::insert_batch(const int* keys, size_t n)
+{
+   if (consumed)
+      throw std::logic_error("external_dedup: insert after the runs were read");
+   for (size_t first = 0; first < n; first += HASH_BATCH_SIZE)
+      insertChunk(keys + first, (n - first < HASH_BATCH_SIZE) ? n - first : HASH_BATCH_SIZE);
+}
+
+/*****************************************
+ * EXTERNAL DEDUP :: INSERT CHUNK
+ * Up to HASH_BATCH_SIZE keys into the set while it fits and into the
+ * runs after
+ ****************************************/
+inline void external_dedup::insertChunk(const int* keys, size_t n)
+{
+   int kept[HASH_BATCH_SIZE];
+   size_t count = 0;
+   for (size_t i = 0; i < n; ++i)
+      if (keys[i] == HASH_EMPTY_VALUE)
+         hasEmptyValue = true;
+      else
+         kept[count++] = keys[i];
+
+   if (!spilled())
+   {
+      // would these keys make the buckets double past the budget?
+      bool grows = (float)(set.size() + count) > set.max_load_factor() * (float)set.bucket_count();
+      if (!grows || set.bucket_count() * 2 * HASH_BUCKET_BYTES <= memoryBudget ||
+          level >= HASH_SPILL_LEVELS)
+      {
+         set.insert_batch(kept, count);
+         return;
+      }
+      spill();
+   }
+   route(kept, count);
+}
+
+/*****************************************
+ * EXTERNAL DEDUP :: SPILL
+ * Open the runs, start the writer, and move the set out to the runs.
+ * If a run cannot be opened nothing changes: the keys stay in the set
+ * and the dedup has not spilled.
+ ****************************************/
+inline void external_dedup::spill()
+{
+   std::vector<FILE*> files;
+   std::vector<std::string> names;
+   std::vector<std::vector<int>> blocks(numPartitions);
+   std::vector<std::vector<int>> spares(numPartitions);
+   for (size_t i = 0; i < numPartitions; ++i)
+   {
+      blocks[i].reserve(blockSize);
+      spares[i].reserve(blockSize);
+   }
+
+   for (size_t i = 0; i < numPartitions; ++i)
+   {
+      FILE* file = nullptr;
+      if (directory.empty())
+         file = std::tmpfile();
+      else
+      {
+         // open exclusively, so another dedup sharing the directory
+         // makes us pick a different name instead of clobbering it
+         for (unsigned attempt = 0; !file && attempt < 100; ++attempt)
+         {
+            std::string path = directory + "/spill-" + std::to_string((uintptr_t)this) +
+                               "-" + std::to_string(level) + "-" + std::to_string(i) +
+                               "-" + std::to_string(attempt) + ".bin";
+            file = std::fopen(path.c_str(), "w+bx");
+            if (file)
+               names.push_back(path);
+         }
+      }
+      if (!file)
+      {
+         for (size_t j = 0; j < files.size(); ++j)
+            std::fclose(files[j]);
+         for (size_t j = 0; j < names.size(); ++j)
+            std::remove(names[j].c_str());
+         throw std::runtime_error("external_dedup: cannot create a run file");
+      }
+      files.push_back(file);
+   }
+
+   // everything is in hand; only now do we count as spilled
+   runs.swap(files);
+   paths.swap(names);
+   active.swap(blocks);
+   spare.swap(spares);
+   try
+   {
+      writer = std::thread(&external_dedup::writeLoop, this);
+   }
+   catch (...)
+   {
+      for (size_t i = 0; i < numPartitions; ++i)
+         std::fclose(runs[i]);
+      for (size_t i = 0; i < paths.size(); ++i)
+         std::remove(paths[i].c_str());
+      runs.clear();
+      paths.clear();
+      active.clear();
+      spare.clear();
+      throw;
+   }
+
+   // the keys so far, then give their memory back
+   int batch[HASH_BATCH_SIZE];
+   size_t count = 0;
+   for (unordered_set::iterator it = set.begin(); it != set.end(); ++it)
+   {
+      batch[count++] = *it;
+      if (count == HASH_BATCH_SIZE)
+      {
+         route(batch, count);
+         count = 0;
+      }
+   }
+   route(batch, count);
+   set = unordered_set();
+}
+
+/*****************************************
+ * EXTERNAL DEDUP :: ROUTE
+ * Append each key to the block of its partition
+ ****************************************/
+inline void external_dedup::route(const int* keys, size_t n)
+{
+   if (n == 0)
+      return;
+
+   int mixed[HASH_BATCH_SIZE];
+   uint32_t parts[HASH_BATCH_SIZE];
+   for (size_t i = 0; i < n; ++i)
+      mixed[i] = salted(keys[i]);
+   simd::partitionBatch(mixed, n, (uint32_t)numPartitions, parts);
+
+   for (size_t i = 0; i < n; ++i)
+   {
+      active[parts[i]].push_back(keys[i]);
+      if (active[parts[i]].size() == blockSize)
+         submit(parts[i]);
+   }
+   numSpilled += n;
+}
+
+/*****************************************
+ * EXTERNAL DEDUP :: SUBMIT
+ * Queue a partition's block for writing and carry on in a spare one,
+ * waiting only if every spare is still being written
+ ****************************************/
+inline void external_dedup::submit(size_t part)
+{
+   std::vector<int> block;
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      returned.wait(lock, [this]() { return !spare.empty(); });
+      block.swap(spare.back());
+      spare.pop_back();
+      queue.emplace_back(part, std::move(active[part]));
+   }
+   ready.notify_one();
+   active[part] = std::move(block);
+}
+
+/*****************************************
+ * EXTERNAL DEDUP :: WRITE LOOP
+ * The writer thread: write queued blocks until told to stop
+ ****************************************/
+inline void external_dedup::writeLoop()
+{
+   std::unique_lock<std::mutex> lock(mutex);
+   for (;;)
+   {
+      ready.wait(lock, [this]() { return stopping || !queue.empty(); });
+      if (queue.empty())
+         return;
+
+      std::pair<size_t, std::vector<int>> item = std::move(queue.front());
+      queue.pop_front();
+      lock.unlock();
+
+      std::vector<int>& block = item.second;
+      bool ok = std::fwrite(block.data(), sizeof(int), block.size(), runs[item.first])
+                == block.size();
+      block.clear();
+
+      lock.lock();
+      failed = failed || !ok;
+      spare.push_back(std::move(block));
+      returned.notify_one();
+   }
+}
+
+/*****************************************
+ * EXTERNAL DEDUP :: FINISH
+ * Queue the partly filled blocks and wait for the writer to drain
+ ****************************************/
+inline void external_dedup::finish()
+{
+   if (!writer.joinable())
+      return;
+   for (size_t i = 0; i < numPartitions; ++i)
+      if (!active[i].empty())
+         submit(i);
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+   }
+   ready.notify_one();
+   writer.join();
+}
+
+/*****************************************
+ * EXTERNAL DEDUP :: FOR EACH DISTINCT
+ * Straight from the set if it never spilled. Otherwise each run in
+ * turn goes through a dedup of its own, one level down.
+ ****************************************/
+template <class Visit>
+size_t external_dedup::for_each_distinct(Visit visit)
+{
+   if (consumed)
+      throw std::logic_error("external_dedup: the runs were already read");
+
+   size_t count = 0;
+   if (hasEmptyValue)
+   {
+      visit(HASH_EMPTY_VALUE);
+      ++count;
+   }
+
+   if (!spilled())
+   {
+      for (unordered_set::iterator it = set.begin(); it != set.end(); ++it)
+         visit(*it);
+      return count + set.size();
+   }
+
+   consumed = true;
+   finish();
+   if (failed)
+      throw std::runtime_error("external_dedup: could not write a run file");
+   std::vector<std::vector<int>>().swap(active);
+   std::vector<std::vector<int>>().swap(spare);
+
+   int batch[HASH_BATCH_SIZE];
+   for (size_t i = 0; i < numPartitions; ++i)
+   {
+      if (std::fflush(runs[i]) != 0)
+         throw std::runtime_error("external_dedup: could not write a run file");
+      std::rewind(runs[i]);
+
+      external_dedup run(memoryBudget, directory.empty() ? nullptr : directory.c_str(),
+                         numPartitions, level + 1);
+      key_reader reader(runs[i], key_reader::BINARY);
+      for (size_t n; (n = reader.read(batch, HASH_BATCH_SIZE)) != 0; )
+         run.insertChunk(batch, n);
+      count += run.for_each_distinct(visit);
+
+      // this run is done with; give back its disk space now
+      std::fclose(runs[i]);
+      runs[i] = nullptr;
+      if (i < paths.size())
+         std::remove(paths[i].c_str());
+   }
+   return count;
+}
+
+}
@@ -0,0 +1,350 @@
+/***********************************************************************
+ * Header:
+ *    GENERATION SET
+ * Summary:
+ *    A hash set for tables that are filled, read and thrown away over
+ *    and over, such as one per request. clear() is O(1) however many
+ *    buckets there are.
+ *
+ *    Each bucket holds its key beside the generation it was written
+ *    in. A bucket whose generation is not the table's is empty, so
+ *    clear() only has to move the table on to the next generation:
+ *    every bucket written before is stale at once.
+ *
+ *        generation 7
+ *        keys:  | 40 | 31 | 12 |    | 55 | 90 |    | 67 |    |    |
+ *        gens:  |  6 |  7 |  6 |  0 |  7 |  6 |  0 |  7 |  0 |  0 |
+ *                 ^         ^              ^
+ *                 stale, as good as empty
+ *
+ *    Otherwise the table is unordered_set's: linear probing from
+ *    |key| % numBuckets, doubling at the load factor, and backward-shift
+ *    erase. With no sentinel key, any int can be stored, HASH_EMPTY_VALUE
+ *    included. Only once every 2^32 clears, when the generation would
+ *    wrap, are the buckets actually wiped.
+ *
+ *    This will contain the class definitions of:
+ *        generation_unordered_set           : A hash with O(1) clear
+ *        generation_unordered_set::iterator : An iterator through it
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>          // for assert()
+#include <cmath>            // for std::ceil
+#include <cstdint>          // for uint32_t
+#include "simd.h"           // for simd::fold
+
+class TestGenerationSet;    // forward declaration for GenerationSet unit tests
+
+namespace custom
+{
+/************************************************
+ * GENERATION UNORDERED SET
+ * A hash whose buckets are tagged with the generation that filled them
+ ************************************************/
+class generation_unordered_set
+{
+   friend class ::TestGenerationSet;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   generation_unordered_set() : slots(nullptr), numBuckets(0), numElements(0),
+                                generation(1), maxLoadFactor(0.5f)
+   {
+      allocate(10);
+   }
+   generation_unordered_set(const generation_unordered_set& rhs) = delete;
+   ~generation_unordered_set()
+   {
+      delete [] slots;
+   }
+   generation_unordered_set& operator=(const generation_unordered_set& rhs) = delete;
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const;
+   iterator end() const;
+
+   //
+   // Access
+   //
+   size_t bucket(const int& t) const
+   {
+      return simd::fold(t) % numBuckets;
+   }
+   iterator find(const int& t) const;
+
+   //
+   // Insert
+   //
+   iterator insert(const int& t);
+
+   //
+   // Remove
+   //
+   void clear() noexcept
+   {
+      numElements = 0;
+      if (++generation == 0)
+      {
+         // the tags are about to be reused, so this once wipe them
+         for (size_t i = 0; i < numBuckets; ++i)
+            slots[i].generation = 0;
+         generation = 1;
+      }
+   }
+   size_t erase(const int& t);
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements;
+   }
+   bool empty() const
+   {
+      return numElements == 0;
+   }
+   size_t bucket_count() const
+   {
+      return numBuckets;
+   }
+   float load_factor() const
+   {
+      return (float)numElements / (float)numBuckets;
+   }
+   float max_load_factor() const
+   {
+      return maxLoadFactor;
+   }
+   void max_load_factor(float f)
+   {
+      assert(f > 0.0f && f < 1.0f);  // open addressing needs an empty bucket
+      maxLoadFactor = f;
+   }
+
+   //
+   // Sizing
+   //
+   void rehash(size_t n);
+   void reserve(size_t n)
+   {
+      rehash((size_t)std::ceil((double)n / maxLoadFactor));
+   }
+
+private:
+   struct slot
+   {
+      int      key;          // meaningful only in the current generation
+      uint32_t generation;   // the generation key was written in
+   };
+
+   void allocate(size_t n);
+   size_t probe(const int& t) const;
+   bool filled(size_t i) const
+   {
+      return slots[i].generation == generation;
+   }
+   size_t next(size_t i) const
+   {
+      return (i + 1 == numBuckets) ? 0 : i + 1;
+   }
+
+   slot*    slots;          // numBuckets buckets, each a key and its generation
+   size_t   numBuckets;     // number of buckets
+   size_t   numElements;    // number of keys in the current generation
+   uint32_t generation;     // the current generation; 0 is never current
+   float    maxLoadFactor;  // grow once numElements / numBuckets would pass this
+};
+
+
+/************************************************
+ * GENERATION UNORDERED SET ITERATOR
+ * Walks the buckets filled in the current generation
+ ************************************************/
+class generation_unordered_set::iterator
+{
+   friend class ::TestGenerationSet;   // give unit tests access to the privates
+public:
+   iterator() : pSlot(nullptr), pSlotEnd(nullptr), generation(0) {}
+   iterator(const slot* pSlot, const slot* pSlotEnd, uint32_t generation) :
+      pSlot(pSlot), pSlotEnd(pSlotEnd), generation(generation) {}
+
+   bool operator != (const iterator& rhs) const
+   {
+      return pSlot != rhs.pSlot;
+   }
+   bool operator == (const iterator& rhs) const
+   {
+      return pSlot == rhs.pSlot;
+   }
+
+   const int& operator * () const
+   {
+      return pSlot->key;
+   }
+
+   iterator& operator ++ ()
+   {
+      do
+         ++pSlot;
+      while (pSlot != pSlotEnd && pSlot->generation != generation);
+      return *this;
+   }
+   iterator operator ++ (int)
+   {
+      iterator tmp(*this);
+      ++(*this);
+      return tmp;
+   }
+
+private:
+   const slot* pSlot;       // the bucket we are on
+   const slot* pSlotEnd;    // one past the last bucket
+   uint32_t    generation;  // which buckets are filled
+};
+
+
+/*****************************************
+ * GENERATION UNORDERED SET :: BEGIN
+ ****************************************/
+inline generation_unordered_set::iterator generation_unordered_set::begin() const
+{
+   iterator it(slots, slots + numBuckets, generation);
+   if (!filled(0))
+      ++it;
+   return it;
+}
+
+/*****************************************
+ * GENERATION UNORDERED SET :: END
+ ****************************************/
+inline generation_unordered_set::iterator generation_unordered_set::end() const
+{
+   return iterator(slots + numBuckets, slots + numBuckets, generation);
+}
+
+/*****************************************
+ * GENERATION UNORDERED SET :: PROBE
+ * The bucket holding t, or the empty or stale bucket that ends its run
+ ****************************************/
+inline size_t generation_unordered_set::probe(const int& t) const
+{
+   size_t i = bucket(t);
+   while (filled(i) && slots[i].key != t)
+      i = next(i);
+   return i;
+}
+
+/*****************************************
+ * GENERATION UNORDERED SET :: FIND
+ ****************************************/
+inline generation_unordered_set::iterator generation_unordered_set::find(const int& t) const
+{
+   size_t i = probe(t);
+   if (!filled(i))
+      return end();
+   return iterator(slots + i, slots + numBuckets, generation);
+}
+
+/*****************************************
+ * GENERATION UNORDERED SET :: INSERT
+ * A stale bucket is claimed just like an empty one
+ ****************************************/
+inline generation_unordered_set::iterator generation_unordered_set::insert(const int& t)
+{
+   size_t i = probe(t);
+   if (!filled(i))
+   {
+      if ((float)(numElements + 1) > maxLoadFactor * (float)numBuckets)
+      {
+         rehash(numBuckets * 2);
+         i = probe(t);
+      }
+      slots[i].key = t;
+      slots[i].generation = generation;
+      ++numElements;
+   }
+   return iterator(slots + i, slots + numBuckets, generation);
+}
+
+/*****************************************
+ * GENERATION UNORDERED SET :: ERASE
+ * Backward-shift deletion as in unordered_set::erase(). The run ends
+ * at the first bucket not filled in this generation.
+ ****************************************/
+inline size_t generation_unordered_set::erase(const int& t)
+{
+   size_t i = probe(t);
+   if (!filled(i))
+      return 0;
+   --numElements;
+
+   size_t hole = i;
+   for (size_t j = next(i); filled(j); j = next(j))
+   {
+      size_t home = bucket(slots[j].key);
+      bool movable = (hole <= j) ? (home <= hole || home > j)
+                                 : (home <= hole && home > j);
+      if (movable)
+      {
+         slots[hole].key = slots[j].key;
+         hole = j;
+      }
+   }
+   slots[hole].generation = 0;
+   return 1;
+}
+
+/*****************************************
+ * GENERATION UNORDERED SET :: REHASH
+ * Move the current generation's keys into at least n fresh buckets
+ ****************************************/
+inline void generation_unordered_set::rehash(size_t n)
+{
+   size_t needed = (size_t)std::ceil((double)numElements / maxLoadFactor) + 1;
+   if (n < needed)
+      n = needed;
+   if (n == numBuckets)
+      return;
+
+   slot* oldSlots = slots;
+   size_t oldNum = numBuckets;
+   uint32_t oldGeneration = generation;
+   allocate(n);
+
+   for (size_t i = 0; i < oldNum; ++i)
+      if (oldSlots[i].generation == oldGeneration)
+      {
+         size_t j = probe(oldSlots[i].key);
+         slots[j].key = oldSlots[i].key;
+         slots[j].generation = generation;
+      }
+
+   delete [] oldSlots;
+}
+
+/*****************************************
+ * GENERATION UNORDERED SET :: ALLOCATE
+ * n buckets, all from generation 0 and so all empty
+ ****************************************/
+inline void generation_unordered_set::allocate(size_t n)
+{
+   slots = new slot[n];
+   for (size_t i = 0; i < n; ++i)
+   {
+      slots[i].key = 0;
+      slots[i].generation = 0;
+   }
+   numBuckets = n;
+   generation = 1;
+}
+
+}
@@ -11,20 +11,40 @@
  *     `.______.'  \______.' /_/
  * 
  *    This will contain the class definition of:
- *        unordered_set           : A class that represents a hash
- *        unordered_set::iterator : An interator through hash
+ *        unordered_set                 : A class that represents a hash
+ *        unordered_set::iterator       : An interator through hash
+ *        unordered_set::local_iterator : An iterator through one bucket
  * Author
  *    Savanna W, Isabel W, Jenna R
  ************************************************************************/
 
 #pragma once
 
-#include <cmath>            // for std::abs
+#include <atomic>           // for std::atomic
+#include <cmath>            // for std::ceil
+#include <cstdint>          // for uint32_t
 #include <cassert>          // for assert()
 #include <initializer_list> // for std::initializer_list
+#include <memory_resource>  // for std::pmr::memory_resource and polymorphic_allocator
+#include <new>              // for placement new
 #include <utility>          // for std::move()
+
+// co_await set.async_find(t) needs the compiler's coroutine support
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define HASH_HAVE_COROUTINES
+#include <coroutine>        // for std::coroutine_handle
+#endif
+#endif
    
 #define HASH_EMPTY_VALUE -1
+#define HASH_BATCH_SIZE  256    // keys hashed per pass by the batch functions
+#define HASH_BUCKET_BYTES (sizeof(int) + sizeof(uint32_t))   // a bucket's key and its home count
+#define HASH_MIN_BUCKETS 10     // no table is ever smaller, not even after shrinking
+#define HASH_MULTIPLIER  2654435761u   // Knuth's multiplicative hashing prime, 1 mod 80
+
+#include "simd.h"           // for simd::probe()
+#include "hyperLogLog.h"    // for hyper_log_log and estimate_distinct
 
 class TestHash;             // forward declaration for Hash unit tests
 
@@ -38,74 +58,150 @@ class unordered_set
 {
    friend class ::TestHash;   // give unit tests access to the privates
 public:
+   // the buckets come from a memory_resource: the global heap unless
+   // the set is given another, such as a per-request arena
+   typedef std::pmr::polymorphic_allocator<int> allocator_type;
+
    //
    // Construct
    //
-   unordered_set()
+   unordered_set() : unordered_set(allocator_type()) {}
+   explicit unordered_set(const allocator_type& alloc) : buckets(nullptr), numBuckets(0),
+      numElements(0), maxLoadFactor(0.5f), minLoadFactor(0.0f), resource(alloc.resource())
    {
-   //set numElements to 0 and choose a value for buckets under 10
-   numElements = 0;
-   buckets[8];
-   for (int i = 0; i < 10; ++i)
-   {
-      buckets[i] = HASH_EMPTY_VALUE; // initialize all buckets to empty
-   }
+      // start with 10 empty buckets; the table doubles as it fills
+      allocate(HASH_MIN_BUCKETS);
+      liveSets.fetch_add(1, std::memory_order_relaxed);
    }
-   unordered_set(unordered_set&  rhs)
+   unordered_set(const unordered_set& rhs) : unordered_set(rhs, allocator_type()) {}
+   unordered_set(const unordered_set& rhs, const allocator_type& alloc) : buckets(emptyTable.keys),
+      numBuckets(HASH_MIN_BUCKETS), numElements(0), maxLoadFactor(0.5f), minLoadFactor(0.0f),
+      resource(alloc.resource())
    {
-      //copy the rhs
+      // start from the empty table, which costs nothing to let go of,
+      // then copy the rhs
       *this = rhs;
+      liveSets.fetch_add(1, std::memory_order_relaxed);
    }
-   unordered_set(unordered_set&& rhs) noexcept
+   unordered_set(unordered_set&& rhs) noexcept : buckets(rhs.buckets), numBuckets(rhs.numBuckets),
+      numElements(rhs.numElements), maxLoadFactor(rhs.maxLoadFactor),
+      minLoadFactor(rhs.minLoadFactor), resource(rhs.resource)
    {
-      //move the rhs
-      *this = std::move(rhs);
+      // take the rhs table as it is and leave the rhs the empty one
+      rhs.buckets = emptyTable.keys;
+      rhs.numBuckets = HASH_MIN_BUCKETS;
+      rhs.numElements = 0;
+      liveSets.fetch_add(1, std::memory_order_relaxed);
    }
    template <class Iterator>
-   unordered_set(Iterator first, Iterator last)
+   unordered_set(Iterator first, Iterator last,
+                 const allocator_type& alloc = allocator_type()) : unordered_set(alloc)
    {
-   // set num elements
-   numElements = 0;
-
-   //iterate from first to last and insert each element
-   while (first != last)
+      //iterate from first to last and insert each element
+      while (first != last)
+      {
+         insert(*first);
+         ++first;
+      }
+   }
+   template <class Iterator>
+   unordered_set(Iterator first, Iterator last, estimate_distinct_t,
+                 const allocator_type& alloc = allocator_type()) : unordered_set(alloc)
    {
-      insert(*first);
-      ++first;
+      // one pass to estimate the distinct keys, so the buckets are sized
+      // once instead of doubling all the way up; the range is walked
+      // twice, so it must be a forward range
+      hyper_log_log sketch(first, last);
+      size_t expected = sketch.upper_bound();
+      if ((float)expected > maxLoadFactor * (float)numBuckets)
+         reserve(expected);
+      for (; first != last; ++first)
+         insert(*first);
+   }
+   ~unordered_set()
+   {
+      release(buckets, numBuckets);
+      liveSets.fetch_sub(1, std::memory_order_relaxed);
    }
-}
 
    //
    // Assign
    //
-   unordered_set& operator=(unordered_set& rhs);
-   unordered_set& operator=(unordered_set&& rhs) noexcept;
+   unordered_set& operator=(const unordered_set& rhs);
+   unordered_set& operator=(unordered_set&& rhs);
    unordered_set& operator=(const std::initializer_list<int>& il);
-   void swap(unordered_set& rhs)
+   void swap(unordered_set& rhs) noexcept
    {
+       // each table goes back to the resource it came from, so the
+       // resource travels with it
        std::swap(numElements, rhs.numElements);
+       std::swap(numBuckets, rhs.numBuckets);
        std::swap(buckets, rhs.buckets);
+       std::swap(maxLoadFactor, rhs.maxLoadFactor);
+       std::swap(minLoadFactor, rhs.minLoadFactor);
+       std::swap(resource, rhs.resource);
+   }
+   allocator_type get_allocator() const
+   {
+       return allocator_type(resource);
    }
 
    // 
    // Iterator
    //
    class iterator;
+   class local_iterator;
+
+   // the hash every bucket index is taken from; see home() for how
+   struct hasher
+   {
+      size_t operator()(const int& t) const
+      {
+         return simd::fold(t);
+      }
+   };
    iterator begin();
    iterator end();
+   local_iterator begin(size_t i);
+   local_iterator end(size_t i);
 
    // Access
-   size_t bucket(const int & t)
+   hasher hash_function() const
    {
-       return std::abs(t) % 10;
+       return hasher();
+   }
+   size_t bucket(const int & t) const
+   {
+       return home(hash_function()(t), numBuckets);
+   }
+   void hash_batch(const int* keys, size_t n, uint32_t* out) const
+   {
+       // bucket() for every key. |key| % numBuckets is taken eight at a
+       // time where the CPU allows, then multiplied by HASH_MULTIPLIER
+       // modulo numBuckets, which lands on the same bucket as home().
+       // The kernel works in 32 bits, so the batch callers go scalar
+       // once the table outgrows that.
+       assert(numBuckets <= UINT32_MAX);
+       simd::bucketBatch(keys, n, (uint32_t)numBuckets, out);
+       uint64_t multiplier = HASH_MULTIPLIER % numBuckets;
+       for (size_t i = 0; i < n; ++i)
+          out[i] = (uint32_t)(out[i] * multiplier % numBuckets);
    }
    iterator find(const int& t);
+   iterator find(const int& t, size_t hash);
+   size_t find_batch(const int* keys, size_t n, bool* found = nullptr);
+#ifdef HASH_HAVE_COROUTINES
+   class find_awaiter;
+   find_awaiter async_find(const int& t);
+#endif // HASH_HAVE_COROUTINES
 
    //   
    // Insert
    //
    iterator insert(const int& t);
+   iterator insert(const int& t, size_t hash);
    void insert(const std::initializer_list<int> & il);
+   void insert_batch(const int* keys, size_t n);
 
 
    // 
@@ -113,13 +209,34 @@ public:
    //
    void clear() noexcept
    {
-       for (int i = 0; i < 10; ++i)
+       if (numElements == 0)
+          return;
+
+       // a shared table is left to the others, not emptied under them.
+       // We take the empty table instead, so clearing never allocates.
+       if (owners(buckets, numBuckets).load(std::memory_order_acquire) != 1)
+       {
+          release(buckets, numBuckets);
+          buckets = emptyTable.keys;
+          numBuckets = HASH_MIN_BUCKETS;
+          numElements = 0;
+          return;
+       }
+
+       uint32_t* counts = homeCounts();
+       for (size_t i = 0; i < numBuckets; ++i)
        {
           buckets[i] = HASH_EMPTY_VALUE;
+          counts[i] = 0;
        }
        numElements = 0;
    }
    iterator erase(const int& t);
+   iterator erase(const int& t, size_t hash);
+   iterator erase(iterator pos);
+   iterator erase(iterator first, iterator last);
+   template <class Predicate>
+   friend size_t erase_if(unordered_set& us, Predicate pred);
 
    //
    // Status
@@ -135,28 +252,171 @@ public:
    }
    size_t bucket_count() const 
    { 
-       return 10;
+       return numBuckets;
    }
    size_t bucket_size(size_t i) const
-    {
-        assert(i < 10);  // safety check
-        return (buckets[i] != HASH_EMPTY_VALUE) ? 1 : 0;
-    }
+   {
+       assert(i < numBuckets);  // safety check
+       return homeCounts()[i];
+   }
+   float load_factor() const
+   {
+       return (float)numElements / (float)numBuckets;
+   }
+   float max_load_factor() const
+   {
+       return maxLoadFactor;
+   }
+   void max_load_factor(float f)
+   {
+       assert(f > 0.0f && f < 1.0f);  // open addressing needs an empty bucket
+       assert(minLoadFactor < f / 2.0f);
+       maxLoadFactor = f;
+   }
+   // erasing below this load shrinks the table; 0, the default, never does
+   float min_load_factor() const
+   {
+       return minLoadFactor;
+   }
+   void min_load_factor(float f)
+   {
+       // under half the maximum, so the load a table has just after
+       // doubling or shrinking is nowhere near either limit
+       assert(f >= 0.0f && f < maxLoadFactor / 2.0f);
+       minLoadFactor = f;
+   }
+
+   //
+   // Sizing
+   //
+   void rehash(size_t n);
+   void reserve(size_t n)
+   {
+       rehash((size_t)std::ceil((double)n / maxLoadFactor));
+   }
+   void shrink_to_fit()
+   {
+       // rehash() stops at the fewest buckets the elements fit in
+       rehash(HASH_MIN_BUCKETS);
+   }
+
+   //
+   // Memory
+   //
+   // where the bytes of a set, or of every set, go
+   struct memory_report
+   {
+      size_t sets;       // how many sets this covers
+      size_t keys;       // the key array, filled buckets and empty
+      size_t metadata;   // the home count beside each bucket, and the sharing count
+      size_t nodes;      // node pools; open addressing has none
+      size_t object;     // the set objects themselves
+      size_t wasted;     // of keys and metadata, what the empty buckets hold
+      size_t total() const
+      {
+         return keys + metadata + nodes + object;
+      }
+   };
+   memory_report memory_usage() const;
+   static memory_report total_memory_usage();
 
 private:
+   void allocate(size_t n);
+   void deallocate(int* p, size_t n)
+   {
+       resource->deallocate(p, tableBytes(n), alignof(int));
+       liveBuckets.fetch_sub(n, std::memory_order_relaxed);
+       liveTables.fetch_sub(1, std::memory_order_relaxed);
+   }
+   void release(int* p, size_t n);
+   void retain(int* p, size_t n)
+   {
+       if (p != emptyTable.keys)
+          owners(p, n).fetch_add(1, std::memory_order_relaxed);
+   }
+   void unshare();
+   static size_t tableBytes(size_t n)
+   {
+       return n * HASH_BUCKET_BYTES + sizeof(std::atomic<uint32_t>);
+   }
+   uint32_t* homeCounts() const
+   {
+       // the counts share the block with the keys, just past them
+       return reinterpret_cast<uint32_t*>(buckets + numBuckets);
+   }
+   static size_t home(size_t hash, size_t n)
+   {
+       // Scatter the hash before reducing it. Taken straight modulo n,
+       // a dense run of keys fills one unbroken run of buckets, and
+       // linear probing from anywhere inside it walks to its end. Times
+       // a large prime, consecutive keys land a fixed stride apart and
+       // wrap around over the whole table instead of side by side. The
+       // prime is 1 mod 80, so tables of 10, 20, 40 and 80 buckets
+       // place every key exactly where |key| % n would.
+       return (size_t)((uint64_t)hash * HASH_MULTIPLIER % n);
+   }
+   static std::atomic<uint32_t>& owners(int* p, size_t n)
+   {
+       // and the number of sets sharing the table comes last
+       return *reinterpret_cast<std::atomic<uint32_t>*>(reinterpret_cast<uint32_t*>(p + n) + n);
+   }
+   size_t probe(const int& t, size_t i) const;
+   iterator insertAt(const int& t, size_t home);
+   iterator eraseAt(size_t i, size_t home);
+   template <class Predicate>
+   size_t sweep(Predicate doomed);
+   void growFor(size_t n);
+   bool shrinkIfSparse();
+   size_t next(size_t i) const
+   {
+       return (i + 1 == numBuckets) ? 0 : i + 1;
+   }
  
-   int buckets[10];     // exactly 10 buckets of pointers. buckets[iBucket] == HASH_EMPTY_VALUE means it is not filled
-   int numElements;     // number of elements in the Hash
+   int*   buckets;       // numBuckets buckets. buckets[iBucket] == HASH_EMPTY_VALUE means it is not filled.
+                         // Followed by numBuckets counts of the elements whose home is each bucket,
+                         // then by how many sets share the table
+   size_t numBuckets;    // number of buckets; collisions are linear probed into the next free one
+   size_t numElements;   // number of elements in the Hash
+   float  maxLoadFactor; // grow once numElements / numBuckets would pass this
+   float  minLoadFactor; // shrink once erasing takes numElements / numBuckets below this
+   std::pmr::memory_resource* resource;   // where buckets come from and go back to
+
+   // every set in the process, for total_memory_usage(). Only
+   // allocations touch these, never inserts or erases.
+   inline static std::atomic<size_t> liveSets{ 0 };      // sets constructed and not destroyed
+   inline static std::atomic<size_t> liveBuckets{ 0 };   // buckets those sets hold
+   inline static std::atomic<size_t> liveTables{ 0 };    // tables, some shared, holding them
+
+   // the table a moved-from set holds: ten empty buckets laid out like
+   // any other, that no set ever writes to or frees. Its owner count
+   // stays above one, so the first write takes a table of its own.
+   struct empty_table
+   {
+      int                   keys[HASH_MIN_BUCKETS] = {};
+      uint32_t              counts[HASH_MIN_BUCKETS] = {};
+      std::atomic<uint32_t> owners{ 2 };
+      constexpr empty_table()
+      {
+         for (size_t i = 0; i < HASH_MIN_BUCKETS; ++i)
+            keys[i] = HASH_EMPTY_VALUE;
+      }
+   };
+   inline static empty_table emptyTable;
 };
 
 
 /************************************************
  * UNORDERED SET ITERATOR
- * Iterator for an unordered set
+ * Iterator for an unordered set. A set shares its table with its
+ * copies until one of them writes, so an insert or erase on a shared
+ * table first moves the set to a table of its own. Like a rehash,
+ * that invalidates every iterator into the set, even when the insert
+ * does not grow it.
  ************************************************/
 class unordered_set::iterator
 {
    friend class ::TestHash;   // give unit tests access to the privates
+   friend class unordered_set;
 public:
    // 
    // Construct
@@ -202,7 +462,9 @@ public:
    // 
    // Access
    //
-   int& operator * ()
+   // const: the table may be shared with copies, and a key changed in
+   // place would also be in the wrong bucket
+   const int& operator * () const
    {
        return *pBucket;  // return first item in the list
    }
@@ -224,30 +486,182 @@ private:
 };
 
 
+/************************************************
+ * UNORDERED SET LOCAL ITERATOR
+ * Iterator through the elements whose home is one bucket. They all
+ * lie in the probe run that starts there, among elements from other
+ * homes; the home's count says when the last has been seen.
+ ************************************************/
+class unordered_set::local_iterator
+{
+   friend class ::TestHash;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   local_iterator() : pBucket(nullptr), buckets(nullptr), numBuckets(0), home(0), remaining(0) {}
+   local_iterator(int* pBucket, int* buckets, size_t numBuckets, size_t home, size_t remaining) :
+      pBucket(pBucket), buckets(buckets), numBuckets(numBuckets), home(home), remaining(remaining) {}
+
+   //
+   // Compare
+   //
+   bool operator != (const local_iterator& rhs) const
+   {
+       return pBucket != rhs.pBucket;
+   }
+   bool operator == (const local_iterator& rhs) const
+   {
+       return pBucket == rhs.pBucket;
+   }
+
+   //
+   // Access
+   //
+   const int& operator * () const
+   {
+       return *pBucket;
+   }
+
+   //
+   // Arithmetic
+   //
+   local_iterator& operator ++ ();
+   local_iterator operator ++ (int postfix)
+   {
+       local_iterator temp = *this;
+       ++(*this);
+       return temp;
+   }
+
+private:
+   int*   pBucket;      // the element we are on; nullptr past the last
+   int*   buckets;      // the whole table, since the run may wrap
+   size_t numBuckets;   // number of buckets in it
+   size_t home;         // the bucket whose elements we walk
+   size_t remaining;    // elements from home, this one included
+};
+
+#ifdef HASH_HAVE_COROUTINES
+/************************************************
+ * UNORDERED SET FIND AWAITER
+ * What co_await set.async_find(t) waits on: prefetch t's home bucket,
+ * let other lookups run while it comes in from memory, then find t.
+ * The awaiting coroutine's promise must have defer(handle), which
+ * queues it to be resumed later; lookup_scheduler's tasks do.
+ ************************************************/
+class unordered_set::find_awaiter
+{
+public:
+   find_awaiter(unordered_set& set, const int& t) :
+      set(set), key(t), hash(set.hash_function()(t)) {}
+
+   bool await_ready() const
+   {
+      simd::prefetch(set.buckets + home(hash, set.numBuckets));
+      return false;
+   }
+   template <class Promise>
+   void await_suspend(std::coroutine_handle<Promise> handle) const
+   {
+      handle.promise().defer(handle);
+   }
+   iterator await_resume() const
+   {
+      // the set may have grown in the meantime; find() starts over
+      return set.find(key, hash);
+   }
+
+private:
+   unordered_set& set;    // where to look
+   int            key;    // what to look for
+   size_t         hash;   // its hash, computed once
+};
+
+/*****************************************
+ * UNORDERED SET :: ASYNC FIND
+ ****************************************/
+inline unordered_set::find_awaiter unordered_set::async_find(const int& t)
+{
+   return find_awaiter(*this, t);
+}
+#endif // HASH_HAVE_COROUTINES
+
+
 /*****************************************
  * UNORDERED SET ::ASSIGN
  ****************************************/
-inline unordered_set& unordered_set::operator=(unordered_set& rhs)
+inline unordered_set& unordered_set::operator=(const unordered_set& rhs)
 {
-    //set numElements to rhs value
-      numElements = rhs.numElements;
-      //iterate through buckets and copy each
-      for (int i = 0; i < 10; ++i)
+   if (this == &rhs)
+      return *this;
+
+   // from the same resource, share the rhs table until one of us
+   // writes to it
+   if (resource == rhs.resource || resource->is_equal(*rhs.resource))
+   {
+      retain(rhs.buckets, rhs.numBuckets);
+      release(buckets, numBuckets);
+      buckets = rhs.buckets;
+      numBuckets = rhs.numBuckets;
+   }
+   else
+   {
+      // make our table the same shape as the rhs so every element
+      // stays in the bucket its probe sequence expects. If allocate()
+      // throws, we still hold our old table and nothing has changed.
+      if (numBuckets != rhs.numBuckets ||
+          owners(buckets, numBuckets).load(std::memory_order_acquire) != 1)
+      {
+         int* oldBuckets = buckets;
+         size_t oldNum = numBuckets;
+         allocate(rhs.numBuckets);
+         release(oldBuckets, oldNum);
+      }
+
+      //iterate through buckets and copy each, with its home count
+      uint32_t* counts = homeCounts();
+      const uint32_t* rhsCounts = rhs.homeCounts();
+      for (size_t i = 0; i < numBuckets; ++i)
       {
          buckets[i] = rhs.buckets[i];
+         counts[i] = rhsCounts[i];
       }
-      return *this;
+   }
+
+   // only once the table is in place do the counts describe it
+   numElements = rhs.numElements;
+   maxLoadFactor = rhs.maxLoadFactor;
+   minLoadFactor = rhs.minLoadFactor;
+   return *this;
 }
-inline unordered_set& unordered_set::operator=(unordered_set&& rhs) noexcept
+inline unordered_set& unordered_set::operator=(unordered_set&& rhs)
 {
-   //move the rhs
-   numElements = rhs.numElements;
-   for (int i = 0; i < 10; ++i)
+   if (this == &rhs)
+      return *this;
+
+   // a set keeps its resource for life, so a table from another
+   // resource cannot be taken over; its elements are copied instead
+   if (resource != rhs.resource && !resource->is_equal(*rhs.resource))
+      *this = rhs;
+   else
    {
-      buckets[i] = std::move(rhs.buckets[i]);
-      rhs.buckets[i] = HASH_EMPTY_VALUE; // clear the moved-from bucket
+      // let our table go and take the rhs table as it is
+      release(buckets, numBuckets);
+      buckets = rhs.buckets;
+      numBuckets = rhs.numBuckets;
+      numElements = rhs.numElements;
+      maxLoadFactor = rhs.maxLoadFactor;
+      minLoadFactor = rhs.minLoadFactor;
+      rhs.buckets = nullptr;
    }
-   rhs.numElements = 0; // clear the moved-from size
+
+   // leave the rhs the empty table, without allocating
+   if (rhs.buckets)
+      rhs.release(rhs.buckets, rhs.numBuckets);
+   rhs.buckets = emptyTable.keys;
+   rhs.numBuckets = HASH_MIN_BUCKETS;
+   rhs.numElements = 0;
    return *this;
 }
 inline unordered_set& unordered_set::operator=(const std::initializer_list<int>& il)
@@ -272,7 +686,7 @@ inline typename unordered_set::iterator  unordered_set::begin()
 {
    // find the first non-empty bucket
     int* pBegin = buckets;
-    int* pEnd = buckets + 10;
+    int* pEnd = buckets + numBuckets;
 
     // skip empty buckets
     while (pBegin != pEnd && *pBegin == HASH_EMPTY_VALUE)
@@ -282,7 +696,32 @@ inline typename unordered_set::iterator  unordered_set::begin()
 }
 inline typename unordered_set::iterator  unordered_set::end()
 {
-    return iterator(buckets + 10, buckets + 10);
+    return iterator(buckets + numBuckets, buckets + numBuckets);
+}
+
+/*****************************************
+ * UNORDERED SET :: BEGIN / END (BUCKET)
+ * The elements whose home is bucket i, without walking the rest
+ * of the table
+ ****************************************/
+inline typename unordered_set::local_iterator unordered_set::begin(size_t i)
+{
+    assert(i < numBuckets);  // safety check
+
+    size_t count = homeCounts()[i];
+    if (count == 0)
+       return end(i);
+
+    // the first of them is somewhere in the run starting at i
+    size_t j = i;
+    while (bucket(buckets[j]) != i)
+       j = next(j);
+    return local_iterator(&buckets[j], buckets, numBuckets, i, count);
+}
+inline typename unordered_set::local_iterator unordered_set::end(size_t i)
+{
+    assert(i < numBuckets);  // safety check
+    return local_iterator(nullptr, buckets, numBuckets, i, 0);
 }
 
 
@@ -292,56 +731,169 @@ inline typename unordered_set::iterator  unordered_set::end()
  ****************************************/
 inline typename unordered_set::iterator unordered_set::erase(const int& t)
 {
-    // Compute the bucket index using the hash function
-    size_t i = std::abs(t) % 10;
+    return erase(t, hash_function()(t));
+}
 
-    // If the bucket contains the value we want to remove
-    if (buckets[i] == t)
+/*****************************************
+ * UNORDERED SET :: ERASE
+ * Remove one element from the unordered set, given its hash. Returns
+ * the element after it, looked up again if the erase shrank the table.
+ ****************************************/
+inline typename unordered_set::iterator unordered_set::erase(const int& t, size_t hash)
+{
+    assert(hash == hash_function()(t));
+
+    // Walk the probe sequence from the home bucket looking for t
+    size_t i = probe(t, home(hash, numBuckets));
+
+    // If the value is not found, return end()
+    if (buckets[i] == HASH_EMPTY_VALUE)
+       return end();
+
+    // A table rebuilt smaller puts the next element somewhere new
+    iterator it = eraseAt(i, home(hash, numBuckets));
+    if (it == end())
     {
-       // Mark the bucket as empty
-       buckets[i] = HASH_EMPTY_VALUE;
+       shrinkIfSparse();
+       return end();
+    }
+    int following = *it;
+    if (shrinkIfSparse())
+       return find(following);
+    return it;
+}
 
-       // Decrement the element count
-       --numElements;
+/*****************************************
+ * UNORDERED SET :: ERASE
+ * Remove the element an iterator points to. Where it is is already
+ * known, so there is nothing to probe for. This never shrinks the
+ * table, so a loop erasing as it iterates sees every element once.
+ ****************************************/
+inline typename unordered_set::iterator unordered_set::erase(iterator pos)
+{
+    if (pos.pBucket == buckets + numBuckets)
+       return pos;
+    return eraseAt(pos.pBucket - buckets, bucket(*pos));
+}
 
-       // Return iterator pointing to the next valid element
-       iterator it(&buckets[i + 1], buckets + 10);
-       ++it;  // this will skip empty buckets if needed
-       return it;
+/*****************************************
+ * UNORDERED SET :: ERASE
+ * Remove the elements in the buckets from first up to last, in one
+ * sweep. Elements from after the range may be shifted back into it,
+ * so the iterator returned is to whatever is now first from where the
+ * range began. Like erase(iterator), this never shrinks the table.
+ ****************************************/
+inline typename unordered_set::iterator unordered_set::erase(iterator first, iterator last)
+{
+    size_t from = first.pBucket - buckets;
+    size_t to = last.pBucket - buckets;
+    if (from >= to)
+       return last;
+
+    sweep([from, to](size_t i) { return from <= i && i < to; });
+
+    iterator it(&buckets[from], buckets + numBuckets);
+    if (buckets[from] == HASH_EMPTY_VALUE)
+       ++it;
+    return it;
+}
+
+/*****************************************
+ * UNORDERED SET :: ERASE AT
+ * Remove the element in bucket i, whose home is the given bucket
+ ****************************************/
+inline typename unordered_set::iterator unordered_set::eraseAt(size_t i, size_t home)
+{
+    unshare();
+
+    // Decrement the element count, and its home's
+    --numElements;
+    --homeCounts()[home];
+
+    // Leaving a plain hole would cut off the rest of the cluster, so pull
+    // back every later element that is allowed to live in the hole
+    size_t hole = i;
+    for (size_t j = next(i); buckets[j] != HASH_EMPTY_VALUE; j = next(j))
+    {
+       // buckets[j] may move only if the hole lies cyclically
+       // between its home bucket and j
+       size_t home = bucket(buckets[j]);
+       bool movable = (hole <= j) ? (home <= hole || home > j)
+                                  : (home <= hole && home > j);
+       if (movable)
+       {
+          buckets[hole] = buckets[j];
+          hole = j;
+       }
     }
 
-    // If the value is not found, return end()
-    return end();
+    // Mark the bucket as empty
+    buckets[hole] = HASH_EMPTY_VALUE;
+
+    // Return iterator pointing to the next valid element. That is bucket i
+    // itself if something was shifted into it.
+    iterator it(&buckets[i], buckets + numBuckets);
+    if (buckets[i] == HASH_EMPTY_VALUE)
+       ++it;  // this will skip empty buckets if needed
+    return it;
 }
 
 
 /*****************************************
  * UNORDERED SET :: INSERT
- * Insert one element into the hash
+ * Insert one element into the hash. Iterators stay valid unless the
+ * table grows or was shared with a copy.
  ****************************************/
 inline custom::unordered_set::iterator unordered_set::insert(const int& t)
 {
-   // find the bucket where the new element is to reside
-   size_t index = bucket(t);
+   return insertAt(t, bucket(t));
+}
+
+/*****************************************
+ * UNORDERED SET :: INSERT
+ * Insert one element whose hash the caller has already computed with
+ * hash_function(), perhaps once for several sets
+ ****************************************/
+inline custom::unordered_set::iterator unordered_set::insert(const int& t, size_t hash)
+{
+   assert(hash == hash_function()(t));
+   return insertAt(t, home(hash, numBuckets));
+}
+
+/*****************************************
+ * UNORDERED SET :: INSERT AT
+ * Insert one element whose home bucket is already known
+ ****************************************/
+inline custom::unordered_set::iterator unordered_set::insertAt(const int& t, size_t home)
+{
+   // HASH_EMPTY_VALUE marks a hole, so it cannot be a key
+   assert(t != HASH_EMPTY_VALUE);
+
+   // find the bucket where the new element is to reside, skipping
+   // over buckets already taken by other elements
+   size_t index = probe(t, home);
 
    // Check if the element already exists
    if (buckets[index] == t)
    {
-      return iterator(&buckets[index], &buckets[10]); // Element already exists, return iterator to it
+      return iterator(&buckets[index], buckets + numBuckets); // Element already exists, return iterator to it
    }
 
-   // If the bucket is empty, insert the new element
-   if (buckets[index] == HASH_EMPTY_VALUE)
+   // Grow first if this element would push us past the load factor.
+   // The bucket we found is no longer valid after that.
+   if ((float)(numElements + 1) > maxLoadFactor * (float)numBuckets)
    {
-      buckets[index] = t; // Insert the element
-      ++numElements;      // Increment the number of elements
-      return iterator(&buckets[index], &buckets[10]); // Return an iterator to the newly inserted element
+      growFor(numElements + 1);
+      home = bucket(t);
+      index = probe(t, home);
    }
    else
-   {
-      buckets[index] = t; // Insert the element
-      return iterator(&buckets[index], &buckets[10]);
-   } // Return an iterator to the newly inserted element
+      unshare();   // a copy, same shape, so index still holds
+
+   buckets[index] = t;     // Insert the element
+   ++numElements;          // Increment the number of elements
+   ++homeCounts()[home];   // and the number at home
+   return iterator(&buckets[index], buckets + numBuckets); // Return an iterator to the newly inserted element
 }
 
 inline void unordered_set::insert(const std::initializer_list<int> & il)
@@ -353,26 +905,279 @@ inline void unordered_set::insert(const std::initializer_list<int> & il)
    }
 }
 
+/*****************************************
+ * UNORDERED SET :: INSERT BATCH
+ * Insert an array of keys. Each chunk of keys is hashed in one
+ * vectorized pass and its buckets are prefetched before any is
+ * touched, so the cache misses overlap instead of queueing up.
+ * A table of 2^32 or more buckets is past what the 32-bit kernel
+ * can address, so there each key takes the scalar insert().
+ ****************************************/
+inline void unordered_set::insert_batch(const int* keys, size_t n)
+{
+   uint32_t homes[HASH_BATCH_SIZE];
+   for (size_t first = 0; first < n; first += HASH_BATCH_SIZE)
+   {
+      size_t count = (n - first < HASH_BATCH_SIZE) ? n - first : HASH_BATCH_SIZE;
+
+      // grow up front so the homes we compute stay valid for the chunk
+      growFor(numElements + count);
+      if (numBuckets > UINT32_MAX)
+      {
+         for (size_t i = 0; i < count; ++i)
+            insert(keys[first + i]);
+         continue;
+      }
+      hash_batch(keys + first, count, homes);
+      for (size_t i = 0; i < count; ++i)
+         simd::prefetch(buckets + homes[i]);
+
+      for (size_t i = 0; i < count; ++i)
+         insertAt(keys[first + i], homes[i]);
+   }
+}
+
 /*****************************************
  * UNORDERED SET :: FIND
  * Find an element in an unordered set
  ****************************************/
 inline typename unordered_set::iterator unordered_set::find(const int& t)
 {
-    // Compute which bucket this value would go into
-    size_t i = std::abs(t) % 10;
+    return find(t, hash_function()(t));
+}
+
+/*****************************************
+ * UNORDERED SET :: FIND
+ * Find an element in an unordered set, given its hash
+ ****************************************/
+inline typename unordered_set::iterator unordered_set::find(const int& t, size_t hash)
+{
+    assert(hash == hash_function()(t));
 
-    // If the value is found in the expected bucket
+    // Walk the probe sequence from the bucket this value would go into.
+    // An empty bucket ends the sequence.
+    size_t i = probe(t, home(hash, numBuckets));
+
+    // If the value is found, return an iterator pointing to that bucket
     if (buckets[i] == t)
+       return iterator(&buckets[i], buckets + numBuckets);
+
+    // Otherwise, the value is not in the set
+    return end();
+}
+
+/*****************************************
+ * UNORDERED SET :: FIND BATCH
+ * Look up an array of keys. found[i] says whether keys[i] is in the
+ * set; the return value is how many were. Like insert_batch(), a
+ * table of 2^32 or more buckets is looked up one key at a time.
+ ****************************************/
+inline size_t unordered_set::find_batch(const int* keys, size_t n, bool* found)
+{
+    uint32_t homes[HASH_BATCH_SIZE];
+    size_t numFound = 0;
+    for (size_t first = 0; first < n; first += HASH_BATCH_SIZE)
     {
-       // Return an iterator pointing to that bucket
-       return iterator(&buckets[i], buckets + 10);
+       size_t count = (n - first < HASH_BATCH_SIZE) ? n - first : HASH_BATCH_SIZE;
+       if (numBuckets > UINT32_MAX)
+       {
+          for (size_t i = 0; i < count; ++i)
+          {
+             bool isFound = (find(keys[first + i]) != end());
+             numFound += isFound ? 1 : 0;
+             if (found)
+                found[first + i] = isFound;
+          }
+          continue;
+       }
+       hash_batch(keys + first, count, homes);
+       for (size_t i = 0; i < count; ++i)
+          simd::prefetch(buckets + homes[i]);
+
+       for (size_t i = 0; i < count; ++i)
+       {
+          bool isFound = (buckets[probe(keys[first + i], homes[i])] == keys[first + i]);
+          numFound += isFound ? 1 : 0;
+          if (found)
+             found[first + i] = isFound;
+       }
     }
-    else
+    return numFound;
+}
+
+/*****************************************
+ * UNORDERED SET :: PROBE
+ * Starting at bucket i, find the first bucket that holds t or is
+ * empty. The vectorized kernel scans to the end of the array and then
+ * wraps around; there is always an empty bucket, so it stops.
+ ****************************************/
+inline size_t unordered_set::probe(const int& t, size_t i) const
+{
+    size_t j = i + simd::probe(buckets + i, numBuckets - i, t);
+    if (j < numBuckets)
+       return j;
+    return simd::probe(buckets, i, t);
+}
+
+/*****************************************
+ * UNORDERED SET :: REHASH
+ * Move every element into a table of at least n buckets
+ ****************************************/
+inline void unordered_set::rehash(size_t n)
+{
+    // never shrink below what the current elements need
+    size_t needed = (size_t)std::ceil((double)numElements / maxLoadFactor) + 1;
+    if (n < needed)
+       n = needed;
+    if (n == numBuckets)
+       return;
+
+    int* oldBuckets = buckets;
+    size_t oldNum = numBuckets;
+    allocate(n);
+
+    // reinsert every element; none of them can be duplicates
+    uint32_t* counts = homeCounts();
+    for (size_t i = 0; i < oldNum; ++i)
+       if (oldBuckets[i] != HASH_EMPTY_VALUE)
+       {
+          size_t home = bucket(oldBuckets[i]);
+          buckets[probe(oldBuckets[i], home)] = oldBuckets[i];
+          ++counts[home];
+       }
+
+    release(oldBuckets, oldNum);
+}
+
+/*****************************************
+ * UNORDERED SET :: GROW FOR
+ * Double the table until n elements fit under the load factor
+ ****************************************/
+inline void unordered_set::growFor(size_t n)
+{
+    size_t size = numBuckets;
+    while ((float)n > maxLoadFactor * (float)size)
+       size *= 2;
+    if (size != numBuckets)
+       rehash(size);
+}
+
+/*****************************************
+ * UNORDERED SET :: MEMORY USAGE
+ * The bytes this set holds. A table copies share is counted in full
+ * by each of them. The resource may round blocks up or keep
+ * bookkeeping of its own; that slack is the resource's to report.
+ ****************************************/
+inline unordered_set::memory_report unordered_set::memory_usage() const
+{
+    memory_report report;
+    report.sets     = 1;
+    if (buckets == emptyTable.keys)
     {
-       // Otherwise, the value is not in the set
-       return end();
+       // moved from: the empty table belongs to no one
+       report.keys = report.metadata = report.nodes = report.wasted = 0;
+       report.object = sizeof(unordered_set);
+       return report;
     }
+
+    report.keys     = numBuckets * sizeof(int);
+    report.metadata = numBuckets * sizeof(uint32_t) + sizeof(std::atomic<uint32_t>);
+    report.nodes    = 0;
+    report.object   = sizeof(unordered_set);
+    report.wasted   = (numBuckets - numElements) * HASH_BUCKET_BYTES;
+    return report;
+}
+
+/*****************************************
+ * UNORDERED SET :: TOTAL MEMORY USAGE
+ * The same for every set alive in the process. Counting elements
+ * everywhere would put an atomic add in every insert, so wasted is
+ * not known here and is left 0.
+ ****************************************/
+inline unordered_set::memory_report unordered_set::total_memory_usage()
+{
+    size_t numBuckets = liveBuckets.load(std::memory_order_relaxed);
+    size_t numTables = liveTables.load(std::memory_order_relaxed);
+    memory_report report;
+    report.sets     = liveSets.load(std::memory_order_relaxed);
+    report.keys     = numBuckets * sizeof(int);
+    report.metadata = numBuckets * sizeof(uint32_t) + numTables * sizeof(std::atomic<uint32_t>);
+    report.nodes    = 0;
+    report.object   = report.sets * sizeof(unordered_set);
+    report.wasted   = 0;
+    return report;
+}
+
+/*****************************************
+ * UNORDERED SET :: SHRINK IF SPARSE
+ * If erasing left the load under the minimum, rehash to land it
+ * halfway between the minimum and the maximum, so a few inserts or
+ * erases either way do not rehash again. Returns whether it did.
+ ****************************************/
+inline bool unordered_set::shrinkIfSparse()
+{
+    if (numBuckets <= HASH_MIN_BUCKETS ||
+        (float)numElements >= minLoadFactor * (float)numBuckets)
+       return false;
+
+    float target = (minLoadFactor + maxLoadFactor) / 2.0f;
+    size_t size = (size_t)std::ceil((double)numElements / target);
+    rehash(size < HASH_MIN_BUCKETS ? HASH_MIN_BUCKETS : size);
+    return true;
+}
+
+/*****************************************
+ * UNORDERED SET :: ALLOCATE
+ * Point buckets at n new empty buckets, each with no elements at home
+ ****************************************/
+inline void unordered_set::allocate(size_t n)
+{
+    // an arena that is out of room throws before anything changes
+    buckets = static_cast<int*>(resource->allocate(tableBytes(n), alignof(int)));
+    numBuckets = n;
+    new (&owners(buckets, n)) std::atomic<uint32_t>(1);
+    liveBuckets.fetch_add(n, std::memory_order_relaxed);
+    liveTables.fetch_add(1, std::memory_order_relaxed);
+    uint32_t* counts = homeCounts();
+    for (size_t i = 0; i < n; ++i)
+    {
+       buckets[i] = HASH_EMPTY_VALUE;
+       counts[i] = 0;
+    }
+}
+
+/*****************************************
+ * UNORDERED SET :: RELEASE
+ * Let go of the table p of n buckets. The last set holding it frees it.
+ ****************************************/
+inline void unordered_set::release(int* p, size_t n)
+{
+    if (p != emptyTable.keys &&
+        owners(p, n).fetch_sub(1, std::memory_order_acq_rel) == 1)
+       deallocate(p, n);
+}
+
+/*****************************************
+ * UNORDERED SET :: UNSHARE
+ * Before writing to a table that copies share, take a copy of our
+ * own. The same shape, so every element keeps its bucket.
+ ****************************************/
+inline void unordered_set::unshare()
+{
+    if (owners(buckets, numBuckets).load(std::memory_order_acquire) == 1)
+       return;
+
+    int* oldBuckets = buckets;
+    const uint32_t* oldCounts = homeCounts();
+    allocate(numBuckets);
+
+    uint32_t* counts = homeCounts();
+    for (size_t i = 0; i < numBuckets; ++i)
+    {
+       buckets[i] = oldBuckets[i];
+       counts[i] = oldCounts[i];
+    }
+    release(oldBuckets, numBuckets);
 }
 
 /*****************************************
@@ -397,6 +1202,107 @@ inline typename unordered_set::iterator & unordered_set::iterator::operator ++ (
     return *this;
 }
 
+/*****************************************
+ * UNORDERED SET :: LOCAL ITERATOR :: INCREMENT
+ * Advance to the next element with the same home, if there is one
+ ****************************************/
+inline typename unordered_set::local_iterator & unordered_set::local_iterator::operator ++ ()
+{
+    // only advance if we are not already at the end.
+    if (pBucket == nullptr)
+       return *this;
+
+    // that was the last one: stop without walking the rest of the run
+    if (--remaining == 0)
+    {
+       pBucket = nullptr;
+       return *this;
+    }
+
+    // skip elements from other homes, wrapping around the table
+    do
+    {
+       if (++pBucket == buckets + numBuckets)
+          pBucket = buckets;
+    }
+    while (unordered_set::home(hasher()(*pBucket), numBuckets) != home);
+
+    return *this;
+}
+
+/*****************************************
+ * UNORDERED SET :: SWEEP
+ * Remove every element for whose bucket doomed(i) is true, in one pass
+ * over the buckets. Each is asked about once, where it stood before
+ * the sweep. Rather than shift a cluster back once per element
+ * removed, each survivor behind a hole moves once, straight to the
+ * first empty bucket on its probe sequence.
+ ****************************************/
+template <class Predicate>
+size_t unordered_set::sweep(Predicate doomed)
+{
+    if (numElements == 0)
+       return 0;
+    unshare();
+
+    // start just past an empty bucket so no cluster is cut in two
+    size_t start = 0;
+    while (buckets[start] != HASH_EMPTY_VALUE)
+       ++start;
+
+    uint32_t* counts = homeCounts();
+    size_t numErased = 0;
+    bool holes = false;   // has this cluster lost anything yet?
+    for (size_t j = next(start), n = 1; n < numBuckets; j = next(j), ++n)
+    {
+       // everything we empty is behind us, so this empty was always
+       // empty: the cluster is over
+       if (buckets[j] == HASH_EMPTY_VALUE)
+       {
+          holes = false;
+          continue;
+       }
+
+       size_t home = bucket(buckets[j]);
+       if (doomed(j))
+       {
+          buckets[j] = HASH_EMPTY_VALUE;
+          --counts[home];
+          ++numErased;
+          holes = true;
+       }
+       else if (holes)
+       {
+          // every survivor before j is settled, so the first empty
+          // bucket from home is where a fresh insert would put this one
+          size_t k = home;
+          while (buckets[k] != HASH_EMPTY_VALUE && k != j)
+             k = next(k);
+          if (k != j)
+          {
+             buckets[k] = buckets[j];
+             buckets[j] = HASH_EMPTY_VALUE;
+          }
+       }
+    }
+
+    numElements -= numErased;
+    return numErased;
+}
+
+/*****************************************
+ * ERASE IF
+ * Remove every element pred is true of, in one sweep over the buckets.
+ * Returns how many were removed.
+ ****************************************/
+template <class Predicate>
+size_t erase_if(unordered_set& us, Predicate pred)
+{
+    size_t numErased = us.sweep([&us, &pred](size_t i) { return pred(static_cast<const int&>(us.buckets[i])); });
+    us.shrinkIfSparse();
+    return numErased;
+}
+
 /*****************************************
  * SWAP
  * Stand-alone unordered set swap
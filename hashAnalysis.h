@@ -0,0 +1,243 @@
+/***********************************************************************
+ * Header:
+ *    HASH ANALYSIS
+ * Summary:
+ *    Whether a hash and a bucket count will cluster on a real set of
+ *    keys, measured before the keys ever go into a set.
+ *
+ *    Each candidate policy is a hash and a way to turn it into a
+ *    bucket, one for each hash this project already uses:
+ *        identity : |key| % numBuckets, what the multiset, compact,
+ *                   bounded, generation and concurrent sets do
+ *        multiply : |key| * golden ratio scaled into the buckets, what
+ *                   simd::partitionBatch does
+ *        scramble : simd::scramble(key) % numBuckets, what
+ *                   hyper_log_log does
+ *        prime    : |key| * HASH_MULTIPLIER % numBuckets, what
+ *                   unordered_set does
+ *
+ *    The analyzer lays the distinct keys into a linear-probed table the
+ *    way unordered_set would and reports, per policy:
+ *        - the variance of how many keys call each bucket home. Keys
+ *          spread at random give a variance equal to the mean.
+ *        - the most keys sharing one home, and the longest probe
+ *        - the buckets a find looks at, for keys that are there and for
+ *          keys that are not (assumed to land on every bucket alike):
+ *          the projected cost of a lookup
+ *        - avalanche: the share of hash bits that change when one key
+ *          bit does, over a sample of the keys. 0.5 is ideal; the bias
+ *          is the worst any one key bit / hash bit pair strays from it.
+ *
+ *    This will contain the class definition of:
+ *        hash_analyzer : Distribution statistics for candidate hashes
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>        // for std::sort, std::unique, std::max
+#include <cassert>          // for assert()
+#include <cmath>            // for std::fabs
+#include <cstdint>          // for uint32_t and uint64_t
+#include <vector>           // for std::vector
+#include "simd.h"           // for simd::fold, simd::scramble, MIX_MULTIPLIER
+#include "hash.h"           // for HASH_MULTIPLIER
+
+#define HASH_AVALANCHE_SAMPLE 1024   // keys whose bits are flipped for avalanche
+
+class TestHashAnalysis;     // forward declaration for HashAnalysis unit tests
+
+namespace custom
+{
+/************************************************
+ * HASH ANALYZER
+ * Statistics for hashing one set of keys
+ ************************************************/
+class hash_analyzer
+{
+   friend class ::TestHashAnalysis;   // give unit tests access to the privates
+public:
+   enum policy { IDENTITY, MULTIPLY, SCRAMBLE, PRIME };
+   static const int NUM_POLICIES = 4;
+
+   struct report
+   {
+      policy hasher;            // which policy this is
+      size_t numKeys;           // distinct keys laid out
+      size_t numBuckets;        // buckets they were laid out in
+      double variance;          // of the keys per home bucket
+      size_t maxHome;           // most keys sharing one home bucket
+      size_t maxProbe;          // most buckets looked at to find a key
+      double hitProbes;         // mean buckets looked at to find a key
+      double missProbes;        // mean buckets looked at for a missing key
+      double avalanche;         // mean share of hash bits one key bit flips
+      double avalancheBias;     // worst |share - 0.5| of one bit pair
+   };
+
+   //
+   // Construct: duplicates are dropped, as a set would
+   //
+   hash_analyzer(const int* keys, size_t n) : keys(keys, keys + n)
+   {
+      std::sort(this->keys.begin(), this->keys.end());
+      this->keys.erase(std::unique(this->keys.begin(), this->keys.end()), this->keys.end());
+   }
+
+   //
+   // Analyze: with no bucket count, the one unordered_set would grow to
+   //
+   report analyze(policy p, size_t numBuckets = 0) const;
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return keys.size();
+   }
+   size_t default_buckets() const
+   {
+      // unordered_set starts with 10 and doubles past a load of 0.5
+      size_t n = 10;
+      while ((float)keys.size() > 0.5f * (float)n)
+         n *= 2;
+      return n;
+   }
+
+   static const char* name(policy p)
+   {
+      return p == IDENTITY ? "identity" : p == MULTIPLY ? "multiply" :
+             p == SCRAMBLE ? "scramble" : "prime";
+   }
+   static uint32_t hash(policy p, int t)
+   {
+      switch (p)
+      {
+         case IDENTITY:
+            return simd::fold(t);
+         case MULTIPLY:
+            return simd::fold(t) * simd::MIX_MULTIPLIER;
+         case SCRAMBLE:
+            return (uint32_t)simd::scramble(t);
+         default:
+            return simd::fold(t);
+      }
+   }
+   static size_t bucket(policy p, uint32_t h, size_t numBuckets)
+   {
+      // the multiplier leaves its best bits at the top, so scale those
+      if (p == MULTIPLY)
+         return (size_t)(((uint64_t)h * numBuckets) >> 32);
+      if (p == PRIME)
+         return (size_t)((uint64_t)h * HASH_MULTIPLIER % numBuckets);
+      return h % numBuckets;
+   }
+
+private:
+   void avalancheOf(policy p, report& r) const;
+
+   std::vector<int> keys;       // the distinct keys, sorted
+};
+
+/*****************************************
+ * HASH ANALYZER :: ANALYZE
+ * Lay the keys out by linear probing and measure the table
+ ****************************************/
+inline hash_analyzer::report hash_analyzer::analyze(policy p, size_t numBuckets) const
+{
+   if (numBuckets == 0)
+      numBuckets = default_buckets();
+   // a miss needs an empty bucket to stop at
+   assert(numBuckets > keys.size());
+
+   report r = {};
+   r.hasher = p;
+   r.numKeys = keys.size();
+   r.numBuckets = numBuckets;
+
+   // how many keys call each bucket home, and where each one lands
+   std::vector<size_t> homes(numBuckets, 0);
+   std::vector<bool> full(numBuckets, false);
+   double sumHit = 0.0;
+   for (int key : keys)
+   {
+      size_t home = bucket(p, hash(p, key), numBuckets);
+      homes[home]++;
+
+      size_t probes = 1;
+      size_t i = home;
+      while (full[i])
+      {
+         i = (i + 1 == numBuckets) ? 0 : i + 1;
+         ++probes;
+      }
+      full[i] = true;
+      sumHit += (double)probes;
+      r.maxProbe = std::max(r.maxProbe, probes);
+   }
+
+   double mean = (double)keys.size() / (double)numBuckets;
+   double sumSquares = 0.0;
+   for (size_t count : homes)
+   {
+      sumSquares += ((double)count - mean) * ((double)count - mean);
+      r.maxHome = std::max(r.maxHome, count);
+   }
+   r.variance = sumSquares / (double)numBuckets;
+   r.hitProbes = keys.empty() ? 0.0 : sumHit / (double)keys.size();
+
+   // a miss starting at bucket i looks at the rest of i's run and the
+   // empty bucket after it. Walk backwards from an empty bucket so each
+   // run length comes from the one after it.
+   size_t empty = 0;
+   while (full[empty])
+      ++empty;
+   double sumMiss = 0.0;
+   size_t run = 0;
+   for (size_t step = 0, i = empty; step < numBuckets; ++step)
+   {
+      run = full[i] ? run + 1 : 0;
+      sumMiss += (double)(run + 1);
+      i = (i == 0) ? numBuckets - 1 : i - 1;
+   }
+   r.missProbes = sumMiss / (double)numBuckets;
+
+   avalancheOf(p, r);
+   return r;
+}
+
+/*****************************************
+ * HASH ANALYZER :: AVALANCHE OF
+ * Flip each bit of a sample of the keys and count which hash bits
+ * change with it
+ ****************************************/
+inline void hash_analyzer::avalancheOf(policy p, report& r) const
+{
+   size_t stride = keys.size() / HASH_AVALANCHE_SAMPLE + 1;
+   size_t samples = 0;
+   std::vector<size_t> flips(32 * 32, 0);   // [key bit][hash bit]
+   for (size_t k = 0; k < keys.size(); k += stride, ++samples)
+   {
+      uint32_t h = hash(p, keys[k]);
+      for (int in = 0; in < 32; ++in)
+      {
+         uint32_t diff = h ^ hash(p, (int)((uint32_t)keys[k] ^ (1u << in)));
+         for (int out = 0; out < 32; ++out)
+            flips[in * 32 + out] += (diff >> out) & 1;
+      }
+   }
+   if (samples == 0)
+      return;
+
+   double total = 0.0;
+   for (size_t count : flips)
+   {
+      double share = (double)count / (double)samples;
+      total += share;
+      r.avalancheBias = std::max(r.avalancheBias, std::fabs(share - 0.5));
+   }
+   r.avalanche = total / (32.0 * 32.0);
+}
+
+}
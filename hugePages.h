@@ -0,0 +1,280 @@
+/***********************************************************************
+ * Header:
+ *    HUGE PAGES
+ * Summary:
+ *    A memory_resource that backs big bucket arrays with 2 MB pages.
+ *    Random finds in a table of hundreds of millions of buckets miss
+ *    the TLB on almost every probe with 4 KB pages; with 2 MB pages
+ *    512 times as much of the table is covered by the same entries.
+ *
+ *        custom::huge_page_resource huge;
+ *        custom::unordered_set us(&huge);
+ *        us.reserve(500000000);
+ *
+ *    Allocations of at least one huge page are rounded up to whole
+ *    huge pages and mapped directly:
+ *        1. from the reserved huge page pool (MAP_HUGETLB), if the
+ *           administrator set one up;
+ *        2. otherwise as ordinary memory aligned to 2 MB and marked
+ *           with madvise(MADV_HUGEPAGE), so transparent huge pages
+ *           can back it. The kernel may still use small pages.
+ *    Anything smaller, and everything on systems without huge pages,
+ *    comes from the upstream resource.
+ *
+ *    unordered_set writes HASH_EMPTY_VALUE into every bucket it
+ *    allocates, so reserve() faults the whole table in up front; with
+ *    the advice in place those faults are when the huge pages are
+ *    handed out. huge_bytes() reports how much actually got them.
+ *
+ *    Like the standard pool resources this is not synchronized: share
+ *    one between threads only behind a lock.
+ *
+ *    This will contain the class definition of:
+ *        huge_page_resource : Bucket memory from 2 MB pages
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>          // for size_t
+#include <cstdint>          // for uintptr_t
+#include <cstdio>           // for std::fopen, std::fgets, std::sscanf
+#include <memory_resource>  // for std::pmr::memory_resource
+#include <new>              // for std::bad_alloc
+#include <vector>           // for std::vector
+
+#if defined(__linux__)
+#define HASH_HAVE_HUGE_PAGES
+#include <sys/mman.h>       // for mmap(), munmap(), madvise()
+#endif
+
+#define HASH_HUGE_PAGE ((size_t)2 << 20)   // bytes in one huge page
+
+class TestHugePages;        // forward declaration for HugePages unit tests
+
+namespace custom
+{
+/************************************************
+ * HUGE PAGE RESOURCE
+ * Large blocks from 2 MB pages, small ones from upstream
+ ************************************************/
+class huge_page_resource : public std::pmr::memory_resource
+{
+   friend class ::TestHugePages;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   explicit huge_page_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) :
+      upstream(upstream) {}
+   huge_page_resource(const huge_page_resource& rhs) = delete;
+   ~huge_page_resource();
+   huge_page_resource& operator=(const huge_page_resource& rhs) = delete;
+
+   //
+   // Status
+   //
+   // bytes mapped for large blocks, from the pool or advised
+   size_t mapped_bytes() const;
+   // of those, bytes from the reserved huge page pool
+   size_t reserved_bytes() const;
+   // bytes now backed by huge pages, reserved or transparent
+   size_t huge_bytes() const;
+   std::pmr::memory_resource* upstream_resource() const
+   {
+      return upstream;
+   }
+
+private:
+   struct region
+   {
+      void*  p;          // start of the mapping, 2 MB aligned
+      size_t length;     // bytes mapped, whole huge pages
+      bool   reserved;   // from the MAP_HUGETLB pool
+   };
+
+   void* do_allocate(size_t bytes, size_t alignment) override;
+   void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+   bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+   {
+      return this == &other;
+   }
+
+   static size_t roundUp(size_t bytes)
+   {
+      return (bytes + HASH_HUGE_PAGE - 1) / HASH_HUGE_PAGE * HASH_HUGE_PAGE;
+   }
+   void* map(size_t length, bool& reserved);
+   static size_t transparentBytes(const region& r);
+
+   std::pmr::memory_resource* upstream;   // where small blocks come from
+   std::vector<region>        regions;    // the large blocks handed out
+};
+
+/*****************************************
+ * HUGE PAGE RESOURCE :: DESTRUCTOR
+ * Blocks not given back are unmapped; like the standard pool
+ * resources, memory does not outlive the resource
+ ****************************************/
+inline huge_page_resource::~huge_page_resource()
+{
+#ifdef HASH_HAVE_HUGE_PAGES
+   for (const region& r : regions)
+      munmap(r.p, r.length);
+#endif // HASH_HAVE_HUGE_PAGES
+}
+
+/*****************************************
+ * HUGE PAGE RESOURCE :: ALLOCATE
+ ****************************************/
+inline void* huge_page_resource::do_allocate(size_t bytes, size_t alignment)
+{
+#ifdef HASH_HAVE_HUGE_PAGES
+   if (bytes >= HASH_HUGE_PAGE && alignment <= HASH_HUGE_PAGE)
+   {
+      region r;
+      r.length = roundUp(bytes);
+      r.p = map(r.length, r.reserved);
+      regions.push_back(r);
+      return r.p;
+   }
+#endif // HASH_HAVE_HUGE_PAGES
+   return upstream->allocate(bytes, alignment);
+}
+
+/*****************************************
+ * HUGE PAGE RESOURCE :: DEALLOCATE
+ ****************************************/
+inline void huge_page_resource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+#ifdef HASH_HAVE_HUGE_PAGES
+   if (bytes >= HASH_HUGE_PAGE && alignment <= HASH_HUGE_PAGE)
+   {
+      for (size_t i = 0; i < regions.size(); ++i)
+         if (regions[i].p == p)
+         {
+            munmap(p, regions[i].length);
+            regions[i] = regions.back();
+            regions.pop_back();
+            return;
+         }
+   }
+#endif // HASH_HAVE_HUGE_PAGES
+   upstream->deallocate(p, bytes, alignment);
+}
+
+/*****************************************
+ * HUGE PAGE RESOURCE :: MAP
+ * length bytes from the huge page pool if there is one, else ordinary
+ * pages trimmed to a 2 MB boundary and advised to become huge
+ ****************************************/
+inline void* huge_page_resource::map(size_t length, bool& reserved)
+{
+#ifdef HASH_HAVE_HUGE_PAGES
+#ifdef MAP_HUGETLB
+   void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+   if (p != MAP_FAILED)
+   {
+      reserved = true;
+      return p;
+   }
+#endif // MAP_HUGETLB
+
+   // map one huge page extra so a 2 MB boundary falls inside, then
+   // give back what lies before and after it
+   size_t padded = length + HASH_HUGE_PAGE;
+   char* raw = (char*)mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (raw == (char*)MAP_FAILED)
+      throw std::bad_alloc();
+   char* aligned = (char*)(((uintptr_t)raw + HASH_HUGE_PAGE - 1) / HASH_HUGE_PAGE * HASH_HUGE_PAGE);
+   if (aligned != raw)
+      munmap(raw, aligned - raw);
+   if (aligned + length != raw + padded)
+      munmap(aligned + length, raw + padded - (aligned + length));
+
+#ifdef MADV_HUGEPAGE
+   madvise(aligned, length, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+   reserved = false;
+   return aligned;
+#else
+   (void)length;
+   reserved = false;
+   throw std::bad_alloc();
+#endif // HASH_HAVE_HUGE_PAGES
+}
+
+/*****************************************
+ * HUGE PAGE RESOURCE :: MAPPED BYTES
+ ****************************************/
+inline size_t huge_page_resource::mapped_bytes() const
+{
+   size_t total = 0;
+   for (const region& r : regions)
+      total += r.length;
+   return total;
+}
+
+/*****************************************
+ * HUGE PAGE RESOURCE :: RESERVED BYTES
+ ****************************************/
+inline size_t huge_page_resource::reserved_bytes() const
+{
+   size_t total = 0;
+   for (const region& r : regions)
+      if (r.reserved)
+         total += r.length;
+   return total;
+}
+
+/*****************************************
+ * HUGE PAGE RESOURCE :: HUGE BYTES
+ * Pool blocks are huge pages by definition. For the advised ones,
+ * ask the kernel.
+ ****************************************/
+inline size_t huge_page_resource::huge_bytes() const
+{
+   size_t total = 0;
+   for (const region& r : regions)
+      total += r.reserved ? r.length : transparentBytes(r);
+   return total;
+}
+
+/*****************************************
+ * HUGE PAGE RESOURCE :: TRANSPARENT BYTES
+ * The AnonHugePages line /proc/self/smaps gives for the mapping that
+ * holds r. The kernel may have merged r with a neighbouring mapping,
+ * so no more than r's own length is counted. 0 where there is no
+ * /proc to ask.
+ ****************************************/
+inline size_t huge_page_resource::transparentBytes(const region& r)
+{
+   size_t found = 0;
+#ifdef HASH_HAVE_HUGE_PAGES
+   FILE* smaps = std::fopen("/proc/self/smaps", "r");
+   if (!smaps)
+      return 0;
+
+   char line[512];
+   bool inside = false;
+   uintptr_t p = (uintptr_t)r.p;
+   while (std::fgets(line, sizeof(line), smaps))
+   {
+      unsigned long start, end, kb;
+      if (std::sscanf(line, "%lx-%lx ", &start, &end) == 2)
+         inside = (start <= p && p < end);
+      else if (inside && std::sscanf(line, "AnonHugePages: %lu kB", &kb) == 1)
+      {
+         found = (size_t)kb * 1024;
+         break;
+      }
+   }
+   std::fclose(smaps);
+#endif // HASH_HAVE_HUGE_PAGES
+   return found < r.length ? found : r.length;
+}
+
+}
@@ -0,0 +1,345 @@
+/***********************************************************************
+ * Header:
+ *    KEY FILE
+ * Summary:
+ *    Reading and writing streams of integer keys for the command line
+ *    driver, fast enough for multi-gigabyte inputs.
+ *
+ *    A key_reader hands out keys a batch at a time. Where the platform
+ *    has mmap() a named file is mapped and parsed in place, with no
+ *    copy at all. Standard input, and files that cannot be mapped, are
+ *    streamed through one fixed buffer: a key cut in two by the end of
+ *    the buffer is moved to the front before the next read.
+ *
+ *    Text input is any run of optionally negative decimal numbers with
+ *    anything else between them, so one key per line, CSV columns and
+ *    whitespace all work. A number too large for an int is skipped and
+ *    counted. Binary input is raw native-endian 32-bit ints.
+ *
+ *    This will contain the class definitions of:
+ *        key_reader : Parses keys out of a file or standard input
+ *        key_writer : Buffered decimal output of keys
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>          // for ptrdiff_t
+#include <cstdint>          // for int64_t, INT32_MIN, INT32_MAX
+#include <cstdio>           // for FILE, std::fread, std::fwrite
+#include <cstring>          // for std::memcpy, std::memmove, std::strcmp
+#include <vector>           // for std::vector
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HASH_HAVE_MMAP
+#include <fcntl.h>          // for open()
+#include <sys/mman.h>       // for mmap(), madvise()
+#include <sys/stat.h>       // for fstat()
+#include <unistd.h>         // for close()
+#endif
+
+#define HASH_READ_BUFFER (1 << 20)   // bytes per read when streaming
+
+class TestKeyFile;          // forward declaration for KeyFile unit tests
+
+namespace custom
+{
+/************************************************
+ * KEY READER
+ * Keys out of a mapped file or a stream
+ ************************************************/
+class key_reader
+{
+   friend class ::TestKeyFile;   // give unit tests access to the privates
+public:
+   enum format { TEXT, BINARY };
+
+   //
+   // Construct: "-" is standard input
+   //
+   key_reader(const char* path, format f, size_t bufferSize = HASH_READ_BUFFER);
+   key_reader(FILE* file, format f, size_t bufferSize = HASH_READ_BUFFER) :
+      fmt(f), p(nullptr), pEnd(nullptr), map(nullptr), mapSize(0),
+      file(file), ownsFile(false), eof(false), numSkipped(0)
+   {
+      buffer.resize(bufferSize < 16 ? 16 : bufferSize);
+      p = pEnd = buffer.data();
+   }
+   key_reader(const key_reader& rhs) = delete;
+   ~key_reader();
+   key_reader& operator=(const key_reader& rhs) = delete;
+
+   //
+   // Access
+   //
+   size_t read(int* keys, size_t max);
+
+   //
+   // Status
+   //
+   bool is_open() const
+   {
+      return map != nullptr || file != nullptr;
+   }
+   bool mapped() const
+   {
+      return map != nullptr;
+   }
+   size_t skipped() const
+   {
+      return numSkipped;
+   }
+
+private:
+   bool refill(const char* keep);
+   bool parseText(int& key);
+   bool parseBinary(int& key);
+   static bool isDigit(char c)
+   {
+      return c >= '0' && c <= '9';
+   }
+
+   format            fmt;        // how the keys are written
+   const char*       p;          // the next byte to parse
+   const char*       pEnd;       // one past the last byte available
+   char*             map;        // the mapped file, if mapped
+   size_t            mapSize;    // bytes mapped
+   FILE*             file;       // the stream, if streaming
+   bool              ownsFile;   // we opened it, so we close it
+   bool              eof;        // nothing more will come from file
+   std::vector<char> buffer;     // where streamed bytes land
+   size_t            numSkipped; // numbers that did not fit in an int
+};
+
+/*****************************************
+ * KEY READER :: CONSTRUCTOR
+ * Map the file if we can, stream it if we cannot
+ ****************************************/
+inline key_reader::key_reader(const char* path, format f, size_t bufferSize) :
+   key_reader((FILE*)nullptr, f, bufferSize)
+{
+   if (std::strcmp(path, "-") == 0)
+   {
+      file = stdin;
+      return;
+   }
+
+#ifdef HASH_HAVE_MMAP
+   int fd = open(path, O_RDONLY);
+   if (fd >= 0)
+   {
+      struct stat st;
+      if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+      {
+         void* m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (m != MAP_FAILED)
+         {
+            madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+            map = (char*)m;
+            mapSize = (size_t)st.st_size;
+            p = map;
+            pEnd = map + mapSize;
+            eof = true;
+         }
+      }
+      close(fd);
+      if (map)
+         return;
+   }
+#endif // HASH_HAVE_MMAP
+
+   file = std::fopen(path, f == BINARY ? "rb" : "r");
+   ownsFile = (file != nullptr);
+}
+
+/*****************************************
+ * KEY READER :: DESTRUCTOR
+ ****************************************/
+inline key_reader::~key_reader()
+{
+#ifdef HASH_HAVE_MMAP
+   if (map)
+      munmap(map, mapSize);
+#endif // HASH_HAVE_MMAP
+   if (ownsFile)
+      std::fclose(file);
+}
+
+/*****************************************
+ * KEY READER :: READ
+ * Fill keys with up to max keys. Returns how many, 0 at the end.
+ ****************************************/
+inline size_t key_reader::read(int* keys, size_t max)
+{
+   size_t n = 0;
+   if (fmt == TEXT)
+      while (n < max && parseText(keys[n]))
+         ++n;
+   else
+      while (n < max && parseBinary(keys[n]))
+         ++n;
+   return n;
+}
+
+/*****************************************
+ * KEY READER :: REFILL
+ * Slide the bytes from keep on to the front of the buffer and read
+ * more behind them. False when the stream has nothing more to give.
+ ****************************************/
+inline bool key_reader::refill(const char* keep)
+{
+   if (eof || !file)
+      return false;
+
+   size_t offset = keep - buffer.data();
+   size_t kept = pEnd - keep;
+   if (kept == buffer.size())
+      buffer.resize(buffer.size() * 2);   // one absurdly long token
+   std::memmove(buffer.data(), buffer.data() + offset, kept);
+
+   size_t got = std::fread(buffer.data() + kept, 1, buffer.size() - kept, file);
+   if (got == 0)
+      eof = true;
+   p = buffer.data();
+   pEnd = buffer.data() + kept + got;
+   return got != 0;
+}
+
+/*****************************************
+ * KEY READER :: PARSE TEXT
+ * The next number in the input. The digits are read straight out of
+ * the map or the buffer; only a number the buffer cuts in two is moved.
+ ****************************************/
+inline bool key_reader::parseText(int& key)
+{
+   for (;;)
+   {
+      // skip to the start of a number, stopping at a '-' the buffer
+      // cuts off from whatever follows it
+      while (p != pEnd && !isDigit(*p))
+      {
+         if (*p == '-' && (p + 1 == pEnd || isDigit(p[1])))
+            break;
+         ++p;
+      }
+      if (p == pEnd || (*p == '-' && p + 1 == pEnd))
+      {
+         if (!refill(p))
+            return false;
+         continue;
+      }
+
+      // find its end; if that is the end of the buffer, there may be more
+      const char* start = p;
+      const char* q = (*p == '-') ? p + 1 : p;
+      while (q != pEnd && isDigit(*q))
+         ++q;
+      if (q == pEnd && !eof && file)
+      {
+         // the token moves to the front of the buffer, so start it over
+         refill(start);
+         continue;
+      }
+
+      bool negative = (*start == '-');
+      int64_t value = 0;
+      bool fits = true;
+      for (const char* d = negative ? start + 1 : start; d != q; ++d)
+      {
+         value = value * 10 + (*d - '0');
+         if (value > (int64_t)1 << 31)
+         {
+            fits = false;
+            value = (int64_t)1 << 31;   // keep the arithmetic from overflowing
+         }
+      }
+      p = q;
+
+      if (negative)
+         value = -value;
+      if (fits && value >= INT32_MIN && value <= INT32_MAX)
+      {
+         key = (int)value;
+         return true;
+      }
+      ++numSkipped;
+   }
+}
+
+/*****************************************
+ * KEY READER :: PARSE BINARY
+ * The next four bytes as an int. A few bytes left over at the very
+ * end are not a key, and are counted as skipped.
+ ****************************************/
+inline bool key_reader::parseBinary(int& key)
+{
+   while (pEnd - p < (ptrdiff_t)sizeof(int))
+   {
+      if (!refill(p))
+      {
+         if (p != pEnd)
+            ++numSkipped;
+         p = pEnd;
+         return false;
+      }
+   }
+   std::memcpy(&key, p, sizeof(int));
+   p += sizeof(int);
+   return true;
+}
+
+
+/************************************************
+ * KEY WRITER
+ * Keys out as decimal text, one per line, through one big buffer
+ ************************************************/
+class key_writer
+{
+public:
+   explicit key_writer(FILE* file) : file(file), used(0) {}
+   key_writer(const key_writer& rhs) = delete;
+   ~key_writer()
+   {
+      flush();
+   }
+   key_writer& operator=(const key_writer& rhs) = delete;
+
+   // one key, followed by suffix (if any) and a newline
+   void write(int key, const char* suffix = nullptr)
+   {
+      if (used + 32 > sizeof(buffer))
+         flush();
+
+      char digits[12];
+      size_t n = 0;
+      uint32_t magnitude = (key < 0) ? 0u - (uint32_t)key : (uint32_t)key;
+      do
+      {
+         digits[n++] = (char)('0' + magnitude % 10);
+         magnitude /= 10;
+      } while (magnitude);
+
+      if (key < 0)
+         buffer[used++] = '-';
+      while (n)
+         buffer[used++] = digits[--n];
+      if (suffix)
+         for (; *suffix && used + 2 < sizeof(buffer); ++suffix)
+            buffer[used++] = *suffix;
+      buffer[used++] = '\n';
+   }
+
+   void flush()
+   {
+      std::fwrite(buffer, 1, used, file);
+      used = 0;
+   }
+
+private:
+   FILE*  file;              // where the text goes
+   size_t used;              // bytes of buffer waiting to be written
+   char   buffer[1 << 16];   // the text not yet written
+};
+
+}
@@ -0,0 +1,202 @@
+/***********************************************************************
+ * Header:
+ *    LOOKUP SCHEDULER
+ * Summary:
+ *    Interleaves many independent lookups on one thread so their
+ *    cache misses overlap, for callers that look keys up one at a time
+ *    and so cannot use find_batch(). This is asynchronous memory access
+ *    chaining (Kocberber et al., "Asynchronous Memory Access Chaining",
+ *    VLDB 2015) with C++20 coroutines doing the bookkeeping.
+ *
+ *    Each lookup is a coroutine returning a lookup_scheduler::task.
+ *    co_await set.async_find(key) prefetches the key's bucket and
+ *    suspends; the scheduler resumes the other tasks in turn, and by
+ *    the time it comes back around the bucket is in the cache.
+ *
+ *        custom::lookup_scheduler scheduler;
+ *        auto handle = [&](int key) -> custom::lookup_scheduler::task
+ *        {
+ *           custom::unordered_set::iterator it = co_await us.async_find(key);
+ *           if (it != us.end())
+ *              ++hits;
+ *        };
+ *        for (int key : requests)
+ *           scheduler.spawn(handle(key));
+ *        scheduler.run();
+ *
+ *    spawn() keeps at most HASH_LOOKUPS_IN_FLIGHT tasks going, running
+ *    the ones it has before taking on more: enough lookups to cover a
+ *    trip to DRAM, few enough that their buckets all stay cached.
+ *
+ *    Without compiler support for coroutines this header is empty.
+ *
+ *    This will contain the class definitions of:
+ *        lookup_scheduler       : Round-robin runner of lookup tasks
+ *        lookup_scheduler::task : A coroutine the scheduler can run
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include "hash.h"           // for HASH_HAVE_COROUTINES and async_find()
+
+#ifdef HASH_HAVE_COROUTINES
+
+#include <coroutine>        // for std::coroutine_handle, std::suspend_always
+#include <deque>            // for std::deque
+#include <exception>        // for std::exception_ptr
+#include <utility>          // for std::exchange
+
+#define HASH_LOOKUPS_IN_FLIGHT 32   // lookups the scheduler interleaves
+
+class TestLookupScheduler;  // forward declaration for LookupScheduler unit tests
+
+namespace custom
+{
+/************************************************
+ * LOOKUP SCHEDULER
+ * Runs lookup tasks a step at a time, round robin
+ ************************************************/
+class lookup_scheduler
+{
+   friend class ::TestLookupScheduler;   // give unit tests access to the privates
+public:
+   class task;
+
+   //
+   // Construct
+   //
+   explicit lookup_scheduler(size_t maxInFlight = HASH_LOOKUPS_IN_FLIGHT) :
+      maxInFlight(maxInFlight ? maxInFlight : 1), numLive(0) {}
+   lookup_scheduler(const lookup_scheduler& rhs) = delete;
+   ~lookup_scheduler()
+   {
+      // tasks never finished are simply dropped
+      for (std::coroutine_handle<> handle : ready)
+         handle.destroy();
+   }
+   lookup_scheduler& operator=(const lookup_scheduler& rhs) = delete;
+
+   //
+   // Run
+   //
+   void spawn(task t);
+   void run()
+   {
+      while (!ready.empty())
+         step();
+   }
+
+   //
+   // Status
+   //
+   size_t in_flight() const
+   {
+      return numLive;
+   }
+
+private:
+   void step();
+   void defer(std::coroutine_handle<> handle)
+   {
+      ready.push_back(handle);
+   }
+
+   std::deque<std::coroutine_handle<>> ready;   // tasks waiting for their turn
+   size_t maxInFlight;   // tasks running at once, at most
+   size_t numLive;       // tasks started and not yet finished
+};
+
+/************************************************
+ * LOOKUP SCHEDULER TASK
+ * The return type of a coroutine the scheduler runs. It does nothing
+ * until spawned, and then belongs to the scheduler.
+ ************************************************/
+class lookup_scheduler::task
+{
+   friend class lookup_scheduler;
+public:
+   struct promise_type
+   {
+      lookup_scheduler*  scheduler = nullptr;   // who resumes us
+      std::exception_ptr error;                 // what the body threw
+
+      task get_return_object()
+      {
+         return task(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+      std::suspend_always initial_suspend() noexcept
+      {
+         return {};
+      }
+      std::suspend_always final_suspend() noexcept
+      {
+         return {};
+      }
+      void return_void() {}
+      void unhandled_exception()
+      {
+         error = std::current_exception();
+      }
+      // an awaiter is waiting on memory: come back to us later
+      void defer(std::coroutine_handle<> handle)
+      {
+         scheduler->defer(handle);
+      }
+   };
+
+   task(task&& rhs) noexcept : handle(std::exchange(rhs.handle, nullptr)) {}
+   task(const task& rhs) = delete;
+   ~task()
+   {
+      if (handle)
+         handle.destroy();
+   }
+   task& operator=(const task& rhs) = delete;
+
+private:
+   explicit task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+   std::coroutine_handle<promise_type> handle;   // the coroutine, until spawned
+};
+
+/*****************************************
+ * LOOKUP SCHEDULER :: SPAWN
+ * Take over t and queue it, first making room if enough are running
+ ****************************************/
+inline void lookup_scheduler::spawn(task t)
+{
+   while (numLive >= maxInFlight && !ready.empty())
+      step();
+
+   std::coroutine_handle<task::promise_type> handle = std::exchange(t.handle, nullptr);
+   handle.promise().scheduler = this;
+   ready.push_back(handle);
+   ++numLive;
+}
+
+/*****************************************
+ * LOOKUP SCHEDULER :: STEP
+ * Resume the task at the front of the queue. Either it awaits again,
+ * and queues itself at the back, or it is done and goes away.
+ ****************************************/
+inline void lookup_scheduler::step()
+{
+   std::coroutine_handle<> handle = ready.front();
+   ready.pop_front();
+   handle.resume();
+   if (!handle.done())
+      return;
+
+   --numLive;
+   std::exception_ptr error =
+      std::coroutine_handle<task::promise_type>::from_address(handle.address()).promise().error;
+   handle.destroy();
+   if (error)
+      std::rethrow_exception(error);
+}
+
+}
+
+#endif // HASH_HAVE_COROUTINES
@@ -0,0 +1,508 @@
+/***********************************************************************
+ * Header:
+ *    MULTISET
+ * Summary:
+ *    Our custom counting variant of std::unordered_multiset
+ *
+ *    Every distinct key is stored once in an open-addressed bucket
+ *    array. Alongside each bucket is a small inline counter holding the
+ *    number of times that key was inserted. Counters start out one byte
+ *    wide and the whole counter array is widened (1 -> 2 -> 4 -> 8 bytes)
+ *    the first time any key overflows its counter.
+ *
+ *    This will contain the class definition of:
+ *        unordered_multiset           : A counting hash
+ *        unordered_multiset::iterator : An interator through the hash
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>          // for assert()
+#include <cstdint>          // for uint8_t and friends
+#include <cstring>          // for std::memcpy
+#include <memory>           // for std::unique_ptr
+#include <initializer_list> // for std::initializer_list
+#include <utility>          // for std::swap
+#include "hash.h"           // for HASH_EMPTY_VALUE
+#include "simd.h"           // for simd::probe()
+
+class TestMultiset;         // forward declaration for Multiset unit tests
+
+namespace custom
+{
+/************************************************
+ * UNORDERED MULTISET
+ * A hash that counts how many times each key was inserted
+ ************************************************/
+class unordered_multiset
+{
+   friend class ::TestMultiset;   // give unit tests access to the privates
+public:
+   //
+   // Construct
+   //
+   unordered_multiset() : buckets(nullptr), counts(nullptr), numBuckets(0),
+                          numDistinct(0), numElements(0), countWidth(1)
+   {
+      allocate(10);
+   }
+   unordered_multiset(const unordered_multiset& rhs) : unordered_multiset()
+   {
+      *this = rhs;
+   }
+   // not noexcept: the rhs is left with a fresh empty table, which allocates
+   unordered_multiset(unordered_multiset&& rhs) : unordered_multiset()
+   {
+      swap(rhs);
+   }
+   template <class Iterator>
+   unordered_multiset(Iterator first, Iterator last) : unordered_multiset()
+   {
+      while (first != last)
+      {
+         insert(*first);
+         ++first;
+      }
+   }
+   ~unordered_multiset()
+   {
+      delete [] buckets;
+      delete [] counts;
+   }
+
+   //
+   // Assign
+   //
+   unordered_multiset& operator=(const unordered_multiset& rhs);
+   unordered_multiset& operator=(unordered_multiset&& rhs) noexcept
+   {
+      clear();
+      swap(rhs);
+      return *this;
+   }
+   void swap(unordered_multiset& rhs) noexcept
+   {
+      std::swap(buckets,     rhs.buckets);
+      std::swap(counts,      rhs.counts);
+      std::swap(numBuckets,  rhs.numBuckets);
+      std::swap(numDistinct, rhs.numDistinct);
+      std::swap(numElements, rhs.numElements);
+      std::swap(countWidth,  rhs.countWidth);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin();
+   iterator end();
+
+   //
+   // Access
+   //
+   size_t bucket(const int& t) const
+   {
+      return simd::fold(t) % numBuckets;
+   }
+   iterator find(const int& t);
+   size_t count(const int& t) const;
+
+   //
+   // Insert
+   //
+   iterator insert(const int& t);
+   void insert(const std::initializer_list<int>& il);
+
+   //
+   // Remove
+   //
+   void clear() noexcept
+   {
+      for (size_t i = 0; i < numBuckets; ++i)
+         buckets[i] = HASH_EMPTY_VALUE;
+      numDistinct = 0;
+      numElements = 0;
+   }
+   iterator erase(const int& t);
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      // every occurrence counts, just like std::unordered_multiset
+      return numElements;
+   }
+   size_t distinct() const
+   {
+      return numDistinct;
+   }
+   bool empty() const
+   {
+      return numElements == 0;
+   }
+   size_t bucket_count() const
+   {
+      return numBuckets;
+   }
+
+private:
+   size_t findIndex(const int& t) const;
+   size_t probe(const int& t) const;
+   void allocate(size_t n);
+   void rehash(size_t n);
+   void widen();
+
+   // read and write the counter next to bucket i, whatever its width
+   uint64_t getCount(size_t i) const;
+   void     setCount(size_t i, uint64_t value);
+   static uint64_t readCount(const unsigned char* p, unsigned char width);
+   static void     writeCount(unsigned char* p, unsigned char width, uint64_t value);
+   uint64_t maxCount() const
+   {
+      return (countWidth == 8) ? UINT64_MAX : ((uint64_t)1 << (8 * countWidth)) - 1;
+   }
+
+   int*           buckets;     // buckets[i] == HASH_EMPTY_VALUE means it is not filled
+   unsigned char* counts;      // numBuckets counters, each countWidth bytes wide
+   size_t         numBuckets;  // number of buckets in the table
+   size_t         numDistinct; // number of distinct keys in the table
+   size_t         numElements; // total number of occurrences in the table
+   unsigned char  countWidth;  // bytes per counter: 1, 2, 4, or 8
+};
+
+
+/************************************************
+ * UNORDERED MULTISET ITERATOR
+ * Iterator through the distinct keys of a multiset
+ ************************************************/
+class unordered_multiset::iterator
+{
+   friend class ::TestMultiset;   // give unit tests access to the privates
+   friend class unordered_multiset;
+public:
+   //
+   // Construct
+   //
+   iterator() : pBucket(nullptr), pBucketEnd(nullptr), pSet(nullptr) {}
+   iterator(int* pBucket, int* pBucketEnd, const unordered_multiset* pSet) :
+      pBucket(pBucket), pBucketEnd(pBucketEnd), pSet(pSet) {}
+
+   //
+   // Compare
+   //
+   bool operator != (const iterator& rhs) const { return pBucket != rhs.pBucket; }
+   bool operator == (const iterator& rhs) const { return pBucket == rhs.pBucket; }
+
+   //
+   // Access
+   //
+   const int& operator * () const
+   {
+      return *pBucket;
+   }
+   size_t count() const
+   {
+      // how many times the key under the iterator was inserted
+      return (size_t)pSet->getCount(pBucket - pSet->buckets);
+   }
+
+   //
+   // Arithmetic
+   //
+   iterator& operator ++ ()
+   {
+      if (pBucket == pBucketEnd)
+         return *this;
+      ++pBucket;
+      while (pBucket != pBucketEnd && *pBucket == HASH_EMPTY_VALUE)
+         ++pBucket;
+      return *this;
+   }
+   iterator operator ++ (int postfix)
+   {
+      iterator temp = *this;
+      ++(*this);
+      return temp;
+   }
+
+private:
+   int* pBucket;
+   int* pBucketEnd;
+   const unordered_multiset* pSet;
+};
+
+
+/*****************************************
+ * UNORDERED MULTISET :: ASSIGN
+ ****************************************/
+inline unordered_multiset& unordered_multiset::operator=(const unordered_multiset& rhs)
+{
+   if (this == &rhs)
+      return *this;
+
+   // take on the exact shape of the rhs so the counters line up. Copy
+   // into new arrays first: if either allocation throws, *this is intact.
+   std::unique_ptr<int[]> newBuckets(new int[rhs.numBuckets]);
+   std::unique_ptr<unsigned char[]> newCounts(new unsigned char[rhs.numBuckets * rhs.countWidth]);
+   std::memcpy(newBuckets.get(), rhs.buckets, rhs.numBuckets * sizeof(int));
+   std::memcpy(newCounts.get(),  rhs.counts,  rhs.numBuckets * rhs.countWidth);
+
+   delete [] buckets;
+   delete [] counts;
+   buckets    = newBuckets.release();
+   counts     = newCounts.release();
+   numBuckets = rhs.numBuckets;
+   countWidth = rhs.countWidth;
+   numDistinct = rhs.numDistinct;
+   numElements = rhs.numElements;
+   return *this;
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: BEGIN / END
+ ****************************************/
+inline unordered_multiset::iterator unordered_multiset::begin()
+{
+   int* pBegin = buckets;
+   int* pEnd = buckets + numBuckets;
+   while (pBegin != pEnd && *pBegin == HASH_EMPTY_VALUE)
+      ++pBegin;
+   return iterator(pBegin, pEnd, this);
+}
+inline unordered_multiset::iterator unordered_multiset::end()
+{
+   return iterator(buckets + numBuckets, buckets + numBuckets, this);
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: FIND INDEX
+ * Linear probe for the bucket holding t. Returns numBuckets when
+ * the key is not present.
+ ****************************************/
+inline size_t unordered_multiset::findIndex(const int& t) const
+{
+   size_t i = probe(t);
+   return (buckets[i] == t) ? i : numBuckets;
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: PROBE
+ * The first bucket on t's probe sequence that holds t or is empty
+ ****************************************/
+inline size_t unordered_multiset::probe(const int& t) const
+{
+   size_t home = bucket(t);
+   size_t i = home + simd::probe(buckets + home, numBuckets - home, t);
+   return (i < numBuckets) ? i : simd::probe(buckets, home, t);
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: FIND and COUNT
+ ****************************************/
+inline unordered_multiset::iterator unordered_multiset::find(const int& t)
+{
+   size_t i = findIndex(t);
+   return (i == numBuckets) ? end() : iterator(buckets + i, buckets + numBuckets, this);
+}
+inline size_t unordered_multiset::count(const int& t) const
+{
+   size_t i = findIndex(t);
+   return (i == numBuckets) ? 0 : (size_t)getCount(i);
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: INSERT
+ * Add one occurrence of t
+ ****************************************/
+inline unordered_multiset::iterator unordered_multiset::insert(const int& t)
+{
+   assert(t != HASH_EMPTY_VALUE);
+
+   // keep the load factor under one half so probe runs stay short
+   if ((numDistinct + 1) * 2 > numBuckets)
+      rehash(numBuckets * 2);
+
+   // walk the probe sequence until we find the key or a hole
+   size_t i = probe(t);
+
+   if (buckets[i] == t)
+   {
+      // the counter is full: widen all the counters, then bump
+      uint64_t value = getCount(i);
+      if (value == maxCount())
+         widen();
+      setCount(i, value + 1);
+   }
+   else
+   {
+      buckets[i] = t;
+      setCount(i, 1);
+      ++numDistinct;
+   }
+
+   ++numElements;
+   return iterator(buckets + i, buckets + numBuckets, this);
+}
+
+inline void unordered_multiset::insert(const std::initializer_list<int>& il)
+{
+   for (const int& value : il)
+      insert(value);
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: ERASE
+ * Remove one occurrence of t. Returns an iterator to t if some
+ * occurrences remain, otherwise to the element after it.
+ ****************************************/
+inline unordered_multiset::iterator unordered_multiset::erase(const int& t)
+{
+   size_t i = findIndex(t);
+   if (i == numBuckets)
+      return end();
+
+   --numElements;
+   uint64_t value = getCount(i);
+   if (value > 1)
+   {
+      setCount(i, value - 1);
+      return iterator(buckets + i, buckets + numBuckets, this);
+   }
+
+   // last occurrence: backward-shift the rest of the cluster into the hole
+   --numDistinct;
+   size_t hole = i;
+   size_t j = i;
+   for (;;)
+   {
+      j = (j + 1 == numBuckets) ? 0 : j + 1;
+      if (buckets[j] == HASH_EMPTY_VALUE)
+         break;
+
+      // can buckets[j] legally live in the hole? only if the hole lies
+      // cyclically between its home bucket and j
+      size_t home = bucket(buckets[j]);
+      bool movable = (hole <= j) ? (home <= hole || home > j)
+                                 : (home <= hole && home > j);
+      if (movable)
+      {
+         buckets[hole] = buckets[j];
+         setCount(hole, getCount(j));
+         hole = j;
+      }
+   }
+   buckets[hole] = HASH_EMPTY_VALUE;
+
+   // an element may have been shifted into i; otherwise skip ahead
+   iterator it(buckets + i, buckets + numBuckets, this);
+   if (buckets[i] == HASH_EMPTY_VALUE)
+      ++it;
+   return it;
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: ALLOCATE
+ * Allocate n empty buckets and their counters
+ ****************************************/
+inline void unordered_multiset::allocate(size_t n)
+{
+   numBuckets = n;
+   buckets = new int[n];
+   counts = new unsigned char[n * countWidth];
+   for (size_t i = 0; i < n; ++i)
+      buckets[i] = HASH_EMPTY_VALUE;
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: REHASH
+ * Move every key and its counter into n buckets
+ ****************************************/
+inline void unordered_multiset::rehash(size_t n)
+{
+   int* oldBuckets = buckets;
+   unsigned char* oldCounts = counts;
+   size_t oldNum = numBuckets;
+   allocate(n);
+
+   for (size_t i = 0; i < oldNum; ++i)
+      if (oldBuckets[i] != HASH_EMPTY_VALUE)
+      {
+         size_t j = probe(oldBuckets[i]);
+         buckets[j] = oldBuckets[i];
+         std::memcpy(counts + j * countWidth, oldCounts + i * countWidth, countWidth);
+      }
+
+   delete [] oldBuckets;
+   delete [] oldCounts;
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: WIDEN
+ * Double the width of every counter. This only happens the first
+ * time some key overflows, so the cost is amortized away.
+ ****************************************/
+inline void unordered_multiset::widen()
+{
+   assert(countWidth < 8);
+   unsigned char newWidth = countWidth * 2;
+
+   // read every counter at the old width, write it at the new one. Only
+   // then take the new counters on, so a throw leaves the multiset intact.
+   std::unique_ptr<unsigned char[]> newCounts(new unsigned char[numBuckets * newWidth]);
+   for (size_t i = 0; i < numBuckets; ++i)
+      if (buckets[i] != HASH_EMPTY_VALUE)
+      {
+         writeCount(newCounts.get() + i * newWidth, newWidth,
+                    readCount(counts + i * countWidth, countWidth));
+      }
+
+   delete [] counts;
+   counts = newCounts.release();
+   countWidth = newWidth;
+}
+
+/*****************************************
+ * UNORDERED MULTISET :: GET / SET COUNT
+ ****************************************/
+inline uint64_t unordered_multiset::getCount(size_t i) const
+{
+   return readCount(counts + i * countWidth, countWidth);
+}
+inline uint64_t unordered_multiset::readCount(const unsigned char* p, unsigned char width)
+{
+   switch (width)
+   {
+      case 1:  return *p;
+      case 2:  { uint16_t v; std::memcpy(&v, p, 2); return v; }
+      case 4:  { uint32_t v; std::memcpy(&v, p, 4); return v; }
+      default: { uint64_t v; std::memcpy(&v, p, 8); return v; }
+   }
+}
+inline void unordered_multiset::setCount(size_t i, uint64_t value)
+{
+   writeCount(counts + i * countWidth, countWidth, value);
+}
+inline void unordered_multiset::writeCount(unsigned char* p, unsigned char width, uint64_t value)
+{
+   switch (width)
+   {
+      case 1:  *p = (unsigned char)value; break;
+      case 2:  { uint16_t v = (uint16_t)value; std::memcpy(p, &v, 2); break; }
+      case 4:  { uint32_t v = (uint32_t)value; std::memcpy(p, &v, 4); break; }
+      default: std::memcpy(p, &value, 8); break;
+   }
+}
+
+/*****************************************
+ * SWAP
+ * Stand-alone unordered multiset swap
+ ****************************************/
+inline void swap(unordered_multiset& lhs, unordered_multiset& rhs)
+{
+   lhs.swap(rhs);
+}
+
+}
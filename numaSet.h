@@ -0,0 +1,516 @@
+/***********************************************************************
+ * Header:
+ *    NUMA SET
+ * Summary:
+ *    A hash set spread over the memory of every NUMA node, so that on
+ *    a multi-socket machine no one socket's memory takes all of the
+ *    traffic and, for sets that are mostly read, every find can stay
+ *    on the local node.
+ *
+ *    The set is one unordered_set per node, each allocating from a
+ *    numa_node_resource that binds its pages to that node. There are
+ *    two placements:
+ *        SHARDED    : each key lives in one shard, picked by a mix of
+ *                     the key. Memory and bandwidth are split between
+ *                     the nodes; node_of(key) tells a caller which
+ *                     node's threads should handle that key.
+ *        REPLICATED : every shard holds every key. Inserts and erases
+ *                     go to all of them, finds only to the shard of
+ *                     the node the calling thread is running on.
+ *
+ *    reserve() grows each shard from a thread pinned to its node, so
+ *    the buckets are first touched where they will be used even where
+ *    the memory policy cannot be set.
+ *
+ *    The topology comes from /sys/devices/system/node, the thread's
+ *    node from sched_getcpu(), binding from the mbind() system call and
+ *    pinning from sched_setaffinity(): no libnuma needed. On a machine
+ *    with one node, or one that is not Linux, there is one shard and
+ *    the set behaves like a plain unordered_set.
+ *
+ *    Like unordered_set, concurrent finds are safe but inserts and
+ *    erases need the caller's own locking.
+ *
+ *    This will contain the class definitions of:
+ *        numa_topology      : Which CPUs belong to which node
+ *        numa_node_resource : Memory bound to one node
+ *        numa_unordered_set : A hash set with one shard per node
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>          // for uint32_t and uint64_t
+#include <cstdio>           // for std::fopen, std::fgets, std::snprintf
+#include <cstdlib>          // for std::strtol
+#include <memory>           // for std::unique_ptr
+#include <memory_resource>  // for std::pmr::memory_resource
+#include <new>              // for std::bad_alloc
+#include <thread>           // for std::thread
+#include <vector>           // for std::vector
+#include "hash.h"           // for unordered_set
+
+#if defined(__linux__)
+#define HASH_HAVE_NUMA
+#include <sched.h>          // for sched_getcpu(), sched_setaffinity()
+#include <sys/mman.h>       // for mmap(), munmap()
+#include <sys/syscall.h>    // for SYS_mbind
+#include <unistd.h>         // for syscall(), sysconf()
+#endif
+
+#define HASH_MPOL_PREFERRED 1   // mbind() mode: this node if it has room
+
+class TestNumaSet;          // forward declaration for NumaSet unit tests
+
+namespace custom
+{
+/************************************************
+ * NUMA TOPOLOGY
+ * The nodes of the machine and the CPUs in each
+ ************************************************/
+class numa_topology
+{
+   friend class ::TestNumaSet;   // give unit tests access to the privates
+public:
+   // one node, holding every CPU
+   numa_topology() : ids(1, 0), cpus(1) {}
+   // nodes 0, 1, ... with the given CPUs; cpus[node] may be empty
+   explicit numa_topology(const std::vector<std::vector<int>>& cpus);
+
+   static numa_topology detect();
+
+   size_t nodes() const
+   {
+      return cpus.size();
+   }
+   int id(size_t node) const
+   {
+      return ids[node];
+   }
+   const std::vector<int>& cpus_of(size_t node) const
+   {
+      return cpus[node];
+   }
+   size_t node_of_cpu(int cpu) const
+   {
+      return (cpu >= 0 && (size_t)cpu < cpuNode.size()) ? cpuNode[cpu] : 0;
+   }
+   size_t current_node() const;
+   bool pin(size_t node) const;
+
+private:
+   static std::vector<int> parseList(const char* text);
+   void index();
+
+   std::vector<int>              ids;      // the kernel's number for each node
+   std::vector<std::vector<int>> cpus;     // the CPUs of each node
+   std::vector<size_t>           cpuNode;  // the node of each CPU
+};
+
+/*****************************************
+ * NUMA TOPOLOGY :: CONSTRUCTOR
+ ****************************************/
+inline numa_topology::numa_topology(const std::vector<std::vector<int>>& cpus) : cpus(cpus)
+{
+   if (this->cpus.empty())
+      this->cpus.resize(1);
+   for (size_t node = 0; node < this->cpus.size(); ++node)
+      ids.push_back((int)node);
+   index();
+}
+
+/*****************************************
+ * NUMA TOPOLOGY :: DETECT
+ * Read the online nodes and their CPU lists out of sysfs. Anything
+ * missing means one node.
+ ****************************************/
+inline numa_topology numa_topology::detect()
+{
+   numa_topology topology;
+#ifdef HASH_HAVE_NUMA
+   char line[4096];
+   FILE* online = std::fopen("/sys/devices/system/node/online", "r");
+   if (!online)
+      return topology;
+   bool read = std::fgets(line, sizeof(line), online) != nullptr;
+   std::fclose(online);
+   if (!read)
+      return topology;
+
+   std::vector<int> ids = parseList(line);
+   if (ids.size() < 2)
+      return topology;
+
+   topology.ids.clear();
+   topology.cpus.clear();
+   for (int id : ids)
+   {
+      char path[64];
+      std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+      std::vector<int> cpus;
+      FILE* list = std::fopen(path, "r");
+      if (list)
+      {
+         if (std::fgets(line, sizeof(line), list))
+            cpus = parseList(line);
+         std::fclose(list);
+      }
+      topology.ids.push_back(id);
+      topology.cpus.push_back(cpus);
+   }
+   topology.index();
+#endif // HASH_HAVE_NUMA
+   return topology;
+}
+
+/*****************************************
+ * NUMA TOPOLOGY :: CURRENT NODE
+ * The node of the CPU the calling thread is on right now
+ ****************************************/
+inline size_t numa_topology::current_node() const
+{
+#ifdef HASH_HAVE_NUMA
+   if (nodes() > 1)
+      return node_of_cpu(sched_getcpu());
+#endif // HASH_HAVE_NUMA
+   return 0;
+}
+
+/*****************************************
+ * NUMA TOPOLOGY :: PIN
+ * Keep the calling thread on the CPUs of node. False if it could not
+ * be done, in which case the thread runs wherever it did before.
+ ****************************************/
+inline bool numa_topology::pin(size_t node) const
+{
+#ifdef HASH_HAVE_NUMA
+   if (cpus[node].empty())
+      return false;
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   for (int cpu : cpus[node])
+      if (cpu < CPU_SETSIZE)
+         CPU_SET(cpu, &set);
+   return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+   (void)node;
+   return false;
+#endif // HASH_HAVE_NUMA
+}
+
+/*****************************************
+ * NUMA TOPOLOGY :: PARSE LIST
+ * A sysfs list such as "0-3,8,10-11"
+ ****************************************/
+inline std::vector<int> numa_topology::parseList(const char* text)
+{
+   std::vector<int> values;
+   const char* p = text;
+   while (*p >= '0' && *p <= '9')
+   {
+      char* end;
+      int first = (int)std::strtol(p, &end, 10);
+      int last = first;
+      if (*end == '-')
+         last = (int)std::strtol(end + 1, &end, 10);
+      for (int value = first; value <= last; ++value)
+         values.push_back(value);
+      p = (*end == ',') ? end + 1 : end;
+   }
+   return values;
+}
+
+/*****************************************
+ * NUMA TOPOLOGY :: INDEX
+ * Build the CPU to node table
+ ****************************************/
+inline void numa_topology::index()
+{
+   cpuNode.clear();
+   for (size_t node = 0; node < cpus.size(); ++node)
+      for (int cpu : cpus[node])
+      {
+         if ((size_t)cpu >= cpuNode.size())
+            cpuNode.resize(cpu + 1, 0);
+         cpuNode[cpu] = node;
+      }
+}
+
+
+/************************************************
+ * NUMA NODE RESOURCE
+ * Whole pages, with the policy that they come from one node
+ ************************************************/
+class numa_node_resource : public std::pmr::memory_resource
+{
+public:
+   explicit numa_node_resource(int id) : id(id), bound(false) {}
+
+   // whether the last allocation was bound to the node; if not, its
+   // pages land wherever they are first touched
+   bool bound_last() const
+   {
+      return bound;
+   }
+
+private:
+   void* do_allocate(size_t bytes, size_t alignment) override;
+   void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+   bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+   {
+      return this == &other;
+   }
+
+   int  id;       // the kernel's number for the node
+   bool bound;    // the last allocation's policy was set
+};
+
+/*****************************************
+ * NUMA NODE RESOURCE :: ALLOCATE
+ ****************************************/
+inline void* numa_node_resource::do_allocate(size_t bytes, size_t alignment)
+{
+#ifdef HASH_HAVE_NUMA
+   size_t page = (size_t)sysconf(_SC_PAGESIZE);
+   size_t length = (bytes + page - 1) / page * page;
+   if (alignment <= page)
+   {
+      void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED)
+         throw std::bad_alloc();
+
+      // nothing is touched yet, so the policy decides where every page goes
+      unsigned long mask[4] = {};
+      bound = false;
+      if (id >= 0 && id < (int)(sizeof(mask) * 8))
+      {
+         mask[id / (8 * sizeof(unsigned long))] |= 1ul << (id % (8 * sizeof(unsigned long)));
+         bound = syscall(SYS_mbind, p, length, HASH_MPOL_PREFERRED, mask,
+                         sizeof(mask) * 8, 0) == 0;
+      }
+      return p;
+   }
+#endif // HASH_HAVE_NUMA
+   bound = false;
+   return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+/*****************************************
+ * NUMA NODE RESOURCE :: DEALLOCATE
+ ****************************************/
+inline void numa_node_resource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+#ifdef HASH_HAVE_NUMA
+   size_t page = (size_t)sysconf(_SC_PAGESIZE);
+   if (alignment <= page)
+   {
+      munmap(p, (bytes + page - 1) / page * page);
+      return;
+   }
+#endif // HASH_HAVE_NUMA
+   std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+
+/************************************************
+ * NUMA UNORDERED SET
+ * One unordered_set per node
+ ************************************************/
+class numa_unordered_set
+{
+   friend class ::TestNumaSet;   // give unit tests access to the privates
+public:
+   enum placement { SHARDED, REPLICATED };
+
+   //
+   // Construct
+   //
+   explicit numa_unordered_set(placement where = SHARDED) :
+      numa_unordered_set(where, numa_topology::detect()) {}
+   numa_unordered_set(placement where, const numa_topology& topology);
+   numa_unordered_set(const numa_unordered_set& rhs) = delete;
+   numa_unordered_set& operator=(const numa_unordered_set& rhs) = delete;
+
+   //
+   // Access
+   //
+   bool contains(const int& t)
+   {
+      unordered_set& shard = shards[node_of(t)];
+      return shard.find(t) != shard.end();
+   }
+   size_t count(const int& t)
+   {
+      return contains(t) ? 1 : 0;
+   }
+   // the shard find(t) would look in: for SHARDED, the node whose
+   // threads should handle t; for REPLICATED, the caller's own node
+   size_t node_of(const int& t) const
+   {
+      if (where == REPLICATED)
+         return topology.current_node();
+      uint32_t mixed = simd::fold(t) * simd::MIX_MULTIPLIER;
+      return (size_t)(((uint64_t)mixed * shards.size()) >> 32);
+   }
+
+   //
+   // Insert: true if t was not there before
+   //
+   bool insert(const int& t);
+
+   //
+   // Remove
+   //
+   size_t erase(const int& t);
+   void clear() noexcept
+   {
+      for (unordered_set& shard : shards)
+         shard.clear();
+   }
+
+   //
+   // Status
+   //
+   size_t size() const;
+   bool empty() const
+   {
+      return size() == 0;
+   }
+   size_t node_count() const
+   {
+      return shards.size();
+   }
+   const unordered_set& shard(size_t node) const
+   {
+      return shards[node];
+   }
+   const numa_topology& topology_of() const
+   {
+      return topology;
+   }
+
+   //
+   // Sizing: each shard is grown by a thread on its own node
+   //
+   void reserve(size_t n);
+
+private:
+   template <class Function>
+   void onEveryNode(Function f);
+
+   placement                                        where;      // one copy, or one per node
+   numa_topology                                    topology;   // the nodes and their CPUs
+   std::vector<std::unique_ptr<numa_node_resource>> resources;  // memory of each node
+   std::vector<unordered_set>                       shards;     // the set on each node
+};
+
+/*****************************************
+ * NUMA UNORDERED SET :: CONSTRUCTOR
+ * An empty shard for every node, each allocating from its node
+ ****************************************/
+inline numa_unordered_set::numa_unordered_set(placement where, const numa_topology& topology) :
+   where(where), topology(topology)
+{
+   shards.reserve(topology.nodes());
+   for (size_t node = 0; node < topology.nodes(); ++node)
+   {
+      if (topology.nodes() > 1)
+      {
+         resources.emplace_back(new numa_node_resource(topology.id(node)));
+         shards.emplace_back(unordered_set::allocator_type(resources.back().get()));
+      }
+      else
+         shards.emplace_back();
+   }
+}
+
+/*****************************************
+ * NUMA UNORDERED SET :: INSERT
+ ****************************************/
+inline bool numa_unordered_set::insert(const int& t)
+{
+   if (where == SHARDED)
+   {
+      unordered_set& shard = shards[node_of(t)];
+      size_t before = shard.size();
+      shard.insert(t);
+      return shard.size() != before;
+   }
+
+   size_t before = shards[0].size();
+   for (unordered_set& shard : shards)
+      shard.insert(t);
+   return shards[0].size() != before;
+}
+
+/*****************************************
+ * NUMA UNORDERED SET :: ERASE
+ ****************************************/
+inline size_t numa_unordered_set::erase(const int& t)
+{
+   if (where == SHARDED)
+   {
+      unordered_set& shard = shards[node_of(t)];
+      size_t before = shard.size();
+      shard.erase(t);
+      return before - shard.size();
+   }
+
+   size_t before = shards[0].size();
+   for (unordered_set& shard : shards)
+      shard.erase(t);
+   return before - shards[0].size();
+}
+
+/*****************************************
+ * NUMA UNORDERED SET :: SIZE
+ ****************************************/
+inline size_t numa_unordered_set::size() const
+{
+   if (where == REPLICATED)
+      return shards[0].size();
+   size_t total = 0;
+   for (const unordered_set& shard : shards)
+      total += shard.size();
+   return total;
+}
+
+/*****************************************
+ * NUMA UNORDERED SET :: RESERVE
+ * Room for n keys in all. Sharded, each node gets its share.
+ ****************************************/
+inline void numa_unordered_set::reserve(size_t n)
+{
+   size_t each = (where == REPLICATED) ? n : (n + shards.size() - 1) / shards.size();
+   onEveryNode([this, each](size_t node) { shards[node].reserve(each); });
+}
+
+/*****************************************
+ * NUMA UNORDERED SET :: ON EVERY NODE
+ * Run f(node) for every node at once, each on a thread pinned to
+ * that node, so whatever f touches first is placed there. With one
+ * node there is nothing to place, and f runs right here.
+ ****************************************/
+template <class Function>
+void numa_unordered_set::onEveryNode(Function f)
+{
+   if (shards.size() == 1)
+   {
+      f(0);
+      return;
+   }
+
+   std::vector<std::thread> threads;
+   for (size_t node = 0; node < shards.size(); ++node)
+      threads.emplace_back([this, &f, node]()
+      {
+         topology.pin(node);
+         f(node);
+      });
+   for (std::thread& thread : threads)
+      thread.join();
+}
+
+}
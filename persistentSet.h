@@ -0,0 +1,469 @@
+/***********************************************************************
+ * Header:
+ *    PERSISTENT SET
+ * Summary:
+ *    An immutable hash set with structural sharing: a hash array mapped
+ *    trie (HAMT) in the compressed CHAMP layout.
+ *
+ *    insert() and erase() never change a set. They return a new version
+ *    that shares every node the change did not touch with the old one,
+ *    so an update copies at most one node per level, O(log32 n), and
+ *    taking a snapshot is just copying the set: O(1). Nodes are never
+ *    modified once built, so any number of threads may read a version
+ *    while another thread builds the next one.
+ *
+ *    Each node uses five bits of the key's hash to pick one of 32 slots.
+ *    A slot holds either a key or a child node, recorded in two bitmaps:
+ *
+ *        keyMap   0000 0000 0000 0000 0000 0000 1000 0010
+ *        childMap 0000 0000 0000 0000 0000 0000 0000 1000
+ *        keys     [ 33, 7 ]          slots 1 and 7
+ *        children [ -> ]             slot 3
+ *
+ *    Keys are hashed exactly as unordered_set hashes them, |key|, so key
+ *    and -key always collide. Once all 32 bits are used up such keys
+ *    share a collision node that simply lists them.
+ *
+ *    This will contain the class definition of:
+ *        persistent_set           : An immutable hash set
+ *        persistent_set::iterator : An interator through the set
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>          // for uint32_t
+#include <memory>           // for std::shared_ptr
+#include <vector>           // for std::vector
+#include <utility>          // for std::pair
+#include <initializer_list> // for std::initializer_list
+#include "simd.h"           // for simd::fold(), the hash unordered_set uses
+
+class TestPersistentSet;    // forward declaration for PersistentSet unit tests
+
+namespace custom
+{
+/************************************************
+ * PERSISTENT SET
+ * An immutable hash set; updates return new versions
+ ************************************************/
+class persistent_set
+{
+   friend class ::TestPersistentSet;   // give unit tests access to the privates
+
+   struct node;
+   typedef std::shared_ptr<const node> pointer;
+
+   /************************************************
+    * NODE
+    * One level of the trie. A node with both maps empty and keys in
+    * it is a collision node: every key in it has the same hash.
+    ************************************************/
+   struct node
+   {
+      uint32_t keyMap = 0;            // slot i holds a key
+      uint32_t childMap = 0;          // slot i holds a child
+      std::vector<int> keys;          // in slot order
+      std::vector<pointer> children;  // in slot order
+
+      bool isCollision() const { return keyMap == 0 && childMap == 0; }
+   };
+
+public:
+   //
+   // Construct
+   //
+   persistent_set() : numElements(0) {}
+   persistent_set(const persistent_set& rhs) = default;   // O(1) snapshot
+   template <class Iterator>
+   persistent_set(Iterator first, Iterator last) : numElements(0)
+   {
+      for (; first != last; ++first)
+         *this = insert(*first);
+   }
+   persistent_set(const std::initializer_list<int>& il) :
+      persistent_set(il.begin(), il.end()) {}
+
+   //
+   // Assign
+   //
+   persistent_set& operator=(const persistent_set& rhs) = default;
+   void swap(persistent_set& rhs) noexcept
+   {
+      std::swap(root, rhs.root);
+      std::swap(numElements, rhs.numElements);
+   }
+
+   //
+   // Iterator
+   //
+   class iterator;
+   iterator begin() const;
+   iterator end() const;
+
+   //
+   // Access
+   //
+   static uint32_t hash(const int& t)
+   {
+      return simd::fold(t);
+   }
+   bool contains(const int& t) const;
+   size_t count(const int& t) const
+   {
+      return contains(t) ? 1 : 0;
+   }
+
+   //
+   // Update: each returns a new version and leaves this one alone
+   //
+   persistent_set insert(const int& t) const;
+   persistent_set erase(const int& t) const;
+
+   //
+   // Status
+   //
+   size_t size() const
+   {
+      return numElements;
+   }
+   bool empty() const
+   {
+      return numElements == 0;
+   }
+
+private:
+   persistent_set(pointer root, size_t numElements) :
+      root(root), numElements(numElements) {}
+
+   // position of slot bit among the set bits of map
+   static size_t rank(uint32_t map, uint32_t bit)
+   {
+      uint32_t below = map & (bit - 1);
+      size_t count = 0;
+      for (; below; below &= below - 1)
+         ++count;
+      return count;
+   }
+
+   static pointer insert(const pointer& p, int t, uint32_t h, unsigned shift);
+   static pointer erase(const pointer& p, int t, uint32_t h, unsigned shift);
+   static pointer merge(int a, uint32_t ha, int b, uint32_t hb, unsigned shift);
+
+   pointer root;          // nullptr when the set is empty
+   size_t  numElements;   // number of keys in this version
+};
+
+
+/************************************************
+ * PERSISTENT SET ITERATOR
+ * Depth-first walk: the keys of a node, then its children
+ ************************************************/
+class persistent_set::iterator
+{
+   friend class persistent_set;
+public:
+   //
+   // Construct
+   //
+   iterator() {}
+
+   //
+   // Compare
+   //
+   bool operator == (const iterator& rhs) const { return stack == rhs.stack; }
+   bool operator != (const iterator& rhs) const { return stack != rhs.stack; }
+
+   //
+   // Access
+   //
+   const int& operator * () const
+   {
+      return stack.back().first->keys[stack.back().second];
+   }
+
+   //
+   // Arithmetic
+   //
+   iterator& operator ++ ()
+   {
+      ++stack.back().second;
+      settle();
+      return *this;
+   }
+   iterator operator ++ (int postfix)
+   {
+      iterator temp = *this;
+      ++(*this);
+      return temp;
+   }
+
+private:
+   // each frame is a node and a position in it: first over its keys,
+   // then keys.size() + i for child i
+   std::vector<std::pair<const node*, size_t>> stack;
+
+   // move forward until the top frame sits on a key, or the stack is empty
+   void settle()
+   {
+      while (!stack.empty())
+      {
+         const node* p = stack.back().first;
+         size_t pos = stack.back().second;
+         if (pos < p->keys.size())
+            return;
+         if (pos - p->keys.size() < p->children.size())
+         {
+            ++stack.back().second;
+            stack.push_back(std::make_pair(p->children[pos - p->keys.size()].get(), 0));
+         }
+         else
+         {
+            stack.pop_back();
+         }
+      }
+   }
+};
+
+/*****************************************
+ * PERSISTENT SET :: BEGIN / END
+ ****************************************/
+inline persistent_set::iterator persistent_set::begin() const
+{
+   iterator it;
+   if (root)
+   {
+      it.stack.push_back(std::make_pair(root.get(), 0));
+      it.settle();
+   }
+   return it;
+}
+inline persistent_set::iterator persistent_set::end() const
+{
+   return iterator();
+}
+
+/*****************************************
+ * PERSISTENT SET :: CONTAINS
+ * Follow five hash bits per level down to a key or a hole
+ ****************************************/
+inline bool persistent_set::contains(const int& t) const
+{
+   uint32_t h = hash(t);
+   const node* p = root.get();
+   for (unsigned shift = 0; p; shift += 5)
+   {
+      if (p->isCollision())
+      {
+         for (int key : p->keys)
+            if (key == t)
+               return true;
+         return false;
+      }
+
+      uint32_t bit = 1u << ((h >> shift) & 31);
+      if (p->keyMap & bit)
+         return p->keys[rank(p->keyMap, bit)] == t;
+      if (!(p->childMap & bit))
+         return false;
+      p = p->children[rank(p->childMap, bit)].get();
+   }
+   return false;
+}
+
+/*****************************************
+ * PERSISTENT SET :: INSERT
+ ****************************************/
+inline persistent_set persistent_set::insert(const int& t) const
+{
+   pointer newRoot = insert(root, t, hash(t), 0);
+   if (newRoot == root)
+      return *this;   // already there: share the whole version
+   return persistent_set(newRoot, numElements + 1);
+}
+
+/*****************************************
+ * PERSISTENT SET :: INSERT (NODE)
+ * A copy of p with t added, or p itself if t is already there
+ ****************************************/
+inline persistent_set::pointer persistent_set::insert(const pointer& p, int t,
+                                                      uint32_t h, unsigned shift)
+{
+   if (!p)
+   {
+      std::shared_ptr<node> leaf = std::make_shared<node>();
+      leaf->keyMap = 1u << (h & 31);
+      leaf->keys.push_back(t);
+      return leaf;
+   }
+
+   // out of hash bits: every key down here collides
+   if (p->isCollision())
+   {
+      for (int key : p->keys)
+         if (key == t)
+            return p;
+      std::shared_ptr<node> copy = std::make_shared<node>(*p);
+      copy->keys.push_back(t);
+      return copy;
+   }
+
+   uint32_t bit = 1u << ((h >> shift) & 31);
+   if (p->keyMap & bit)
+   {
+      size_t i = rank(p->keyMap, bit);
+      int existing = p->keys[i];
+      if (existing == t)
+         return p;
+
+      // two keys want the slot: push both down a level
+      std::shared_ptr<node> copy = std::make_shared<node>(*p);
+      copy->keyMap &= ~bit;
+      copy->keys.erase(copy->keys.begin() + i);
+      copy->childMap |= bit;
+      copy->children.insert(copy->children.begin() + rank(copy->childMap, bit),
+                            merge(existing, hash(existing), t, h, shift + 5));
+      return copy;
+   }
+
+   if (p->childMap & bit)
+   {
+      size_t i = rank(p->childMap, bit);
+      pointer child = insert(p->children[i], t, h, shift + 5);
+      if (child == p->children[i])
+         return p;
+      std::shared_ptr<node> copy = std::make_shared<node>(*p);
+      copy->children[i] = child;
+      return copy;
+   }
+
+   // an open slot
+   std::shared_ptr<node> copy = std::make_shared<node>(*p);
+   copy->keyMap |= bit;
+   copy->keys.insert(copy->keys.begin() + rank(copy->keyMap, bit), t);
+   return copy;
+}
+
+/*****************************************
+ * PERSISTENT SET :: MERGE
+ * The smallest subtree holding two keys that collided at shift - 5
+ ****************************************/
+inline persistent_set::pointer persistent_set::merge(int a, uint32_t ha, int b, uint32_t hb,
+                                                     unsigned shift)
+{
+   std::shared_ptr<node> p = std::make_shared<node>();
+   if (shift >= 32)
+   {
+      p->keys.push_back(a);
+      p->keys.push_back(b);
+      return p;
+   }
+
+   uint32_t ia = (ha >> shift) & 31;
+   uint32_t ib = (hb >> shift) & 31;
+   if (ia == ib)
+   {
+      p->childMap = 1u << ia;
+      p->children.push_back(merge(a, ha, b, hb, shift + 5));
+   }
+   else
+   {
+      p->keyMap = (1u << ia) | (1u << ib);
+      p->keys.push_back(ia < ib ? a : b);
+      p->keys.push_back(ia < ib ? b : a);
+   }
+   return p;
+}
+
+/*****************************************
+ * PERSISTENT SET :: ERASE
+ ****************************************/
+inline persistent_set persistent_set::erase(const int& t) const
+{
+   pointer newRoot = erase(root, t, hash(t), 0);
+   if (newRoot == root)
+      return *this;   // not there: share the whole version
+   return persistent_set(newRoot, numElements - 1);
+}
+
+/*****************************************
+ * PERSISTENT SET :: ERASE (NODE)
+ * A copy of p without t, p itself if t is not there, or nullptr when
+ * nothing is left. A child left holding a single key is pulled up into
+ * its parent so equal sets keep the same shape.
+ ****************************************/
+inline persistent_set::pointer persistent_set::erase(const pointer& p, int t,
+                                                     uint32_t h, unsigned shift)
+{
+   if (!p)
+      return p;
+
+   if (p->isCollision())
+   {
+      for (size_t i = 0; i < p->keys.size(); ++i)
+         if (p->keys[i] == t)
+         {
+            if (p->keys.size() == 1)
+               return nullptr;
+            std::shared_ptr<node> copy = std::make_shared<node>(*p);
+            copy->keys.erase(copy->keys.begin() + i);
+            return copy;
+         }
+      return p;
+   }
+
+   uint32_t bit = 1u << ((h >> shift) & 31);
+   if (p->keyMap & bit)
+   {
+      size_t i = rank(p->keyMap, bit);
+      if (p->keys[i] != t)
+         return p;
+      if (p->keys.size() == 1 && p->children.empty())
+         return nullptr;
+      std::shared_ptr<node> copy = std::make_shared<node>(*p);
+      copy->keyMap &= ~bit;
+      copy->keys.erase(copy->keys.begin() + i);
+      return copy;
+   }
+
+   if (p->childMap & bit)
+   {
+      size_t i = rank(p->childMap, bit);
+      pointer child = erase(p->children[i], t, h, shift + 5);
+      if (child == p->children[i])
+         return p;
+
+      std::shared_ptr<node> copy = std::make_shared<node>(*p);
+      if (child && !(child->keys.size() == 1 && child->children.empty()))
+      {
+         copy->children[i] = child;
+         return copy;
+      }
+
+      // the child is gone or down to one key
+      copy->childMap &= ~bit;
+      copy->children.erase(copy->children.begin() + i);
+      if (child)
+      {
+         copy->keyMap |= bit;
+         copy->keys.insert(copy->keys.begin() + rank(copy->keyMap, bit), child->keys[0]);
+      }
+      if (copy->keys.empty() && copy->children.empty())
+         return nullptr;
+      return copy;
+   }
+
+   return p;
+}
+
+/*****************************************
+ * SWAP
+ * Stand-alone persistent set swap
+ ****************************************/
+inline void swap(persistent_set& lhs, persistent_set& rhs)
+{
+   lhs.swap(rhs);
+}
+
+}
@@ -0,0 +1,383 @@
+/***********************************************************************
+ * Header:
+ *    SIMD
+ * Summary:
+ *    Vectorized kernels shared by the hashes in this project
+ *
+ *    The probe kernel scans a run of int buckets for the first one that
+ *    holds a key or is empty. With AVX2 it compares 8 buckets per
+ *    instruction, with SSE2 4, and without either one at a time. The
+ *    best version the CPU supports is picked once, at the first call.
+ *
+ *    The batch kernels hash a whole array of keys at once, 8 per
+ *    instruction with AVX2. bucketBatch gives the same answer as
+ *    |key| % numBuckets but does the division as a multiply and a
+ *    shift by a precomputed reciprocal. partitionBatch scrambles the
+ *    key with a multiplicative mixer and scales it into [0, numParts).
+ *
+ *    This will contain the definitions of:
+ *        simd::probe          : first bucket holding key or empty
+ *        simd::probeScalar    : the same, one bucket at a time
+ *        simd::probeSse2      : the same, 4 buckets at a time
+ *        simd::probeAvx2      : the same, 8 buckets at a time
+ *        simd::bucketBatch    : |key| % numBuckets for an array of keys
+ *        simd::partitionBatch : which of numParts partitions each key is in
+ *        simd::scramble       : a one-to-one mix of a key, and its inverse
+ *        simd::prefetch       : start pulling a bucket into the cache
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>          // for size_t
+#include <cstdint>          // for uint32_t and uint64_t
+
+#ifndef HASH_EMPTY_VALUE
+#define HASH_EMPTY_VALUE -1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HASH_SIMD_X86
+#include <immintrin.h>      // for the SSE2 and AVX2 intrinsics
+#ifdef _MSC_VER
+#include <intrin.h>         // for __cpuid and _xgetbv
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 inside functions that ask for it, which
+// lets the rest of the program run on CPUs without it. MSVC needs no help.
+#if defined(HASH_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define HASH_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HASH_TARGET_AVX2
+#endif
+
+namespace custom
+{
+namespace simd
+{
+
+/*****************************************
+ * LOWEST BIT
+ * Index of the lowest set bit of a non-zero mask
+ ****************************************/
+inline unsigned lowestBit(unsigned mask)
+{
+#if defined(_MSC_VER)
+   unsigned long index;
+   _BitScanForward(&index, mask);
+   return (unsigned)index;
+#else
+   return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+/*****************************************
+ * PROBE SCALAR
+ * Index of the first of the n buckets starting at p that holds key
+ * or is empty. n if there is none.
+ ****************************************/
+inline size_t probeScalar(const int* p, size_t n, int key)
+{
+   for (size_t i = 0; i < n; ++i)
+      if (p[i] == key || p[i] == HASH_EMPTY_VALUE)
+         return i;
+   return n;
+}
+
+#ifdef HASH_SIMD_X86
+/*****************************************
+ * PROBE SSE2
+ * probeScalar, four buckets per compare
+ ****************************************/
+inline size_t probeSse2(const int* p, size_t n, int key)
+{
+   const __m128i vKey   = _mm_set1_epi32(key);
+   const __m128i vEmpty = _mm_set1_epi32(HASH_EMPTY_VALUE);
+
+   size_t i = 0;
+   for (; i + 4 <= n; i += 4)
+   {
+      __m128i group = _mm_loadu_si128((const __m128i*)(p + i));
+      __m128i hit = _mm_or_si128(_mm_cmpeq_epi32(group, vKey),
+                                 _mm_cmpeq_epi32(group, vEmpty));
+      unsigned mask = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(hit));
+      if (mask)
+         return i + lowestBit(mask);
+   }
+   return i + probeScalar(p + i, n - i, key);
+}
+
+/*****************************************
+ * PROBE AVX2
+ * probeScalar, eight buckets per compare
+ ****************************************/
+HASH_TARGET_AVX2
+inline size_t probeAvx2(const int* p, size_t n, int key)
+{
+   const __m256i vKey   = _mm256_set1_epi32(key);
+   const __m256i vEmpty = _mm256_set1_epi32(HASH_EMPTY_VALUE);
+
+   size_t i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      __m256i group = _mm256_loadu_si256((const __m256i*)(p + i));
+      __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi32(group, vKey),
+                                    _mm256_cmpeq_epi32(group, vEmpty));
+      unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(hit));
+      if (mask)
+         return i + lowestBit(mask);
+   }
+   return i + probeSse2(p + i, n - i, key);
+}
+
+/*****************************************
+ * HAS AVX2
+ * Does both the CPU and the operating system support AVX2?
+ ****************************************/
+inline bool hasAvx2()
+{
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 0);
+   if (info[0] < 7)
+      return false;
+   __cpuid(info, 1);
+   bool osxsave = (info[2] & (1 << 27)) != 0;
+   bool avx     = (info[2] & (1 << 28)) != 0;
+   if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+      return false;
+   __cpuidex(info, 7, 0);
+   return (info[1] & (1 << 5)) != 0;
+#else
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif // HASH_SIMD_X86
+
+/*****************************************
+ * PROBE
+ * Dispatch to the widest probe kernel this CPU can run
+ ****************************************/
+typedef size_t (*probeFunction)(const int* p, size_t n, int key);
+
+inline probeFunction selectProbe()
+{
+#ifdef HASH_SIMD_X86
+   if (hasAvx2())
+      return probeAvx2;
+   return probeSse2;
+#else
+   return probeScalar;
+#endif
+}
+
+inline size_t probe(const int* p, size_t n, int key)
+{
+   static const probeFunction kernel = selectProbe();
+   return kernel(p, n, key);
+}
+
+/*****************************************
+ * FOLD
+ * |t| as an unsigned number. Unlike std::abs this is defined for
+ * INT_MIN, which becomes 2^31.
+ ****************************************/
+inline uint32_t fold(int t)
+{
+   return (t < 0) ? 0u - (uint32_t)t : (uint32_t)t;
+}
+
+/*****************************************
+ * SCRAMBLE / UNSCRAMBLE
+ * A one-to-one mix of all 32 bits (the MurmurHash3 finalizer) and its
+ * inverse. Scrambled keys are spread evenly however dense the
+ * originals were, and unscramble() gets the originals back.
+ ****************************************/
+inline int scramble(int t)
+{
+   uint32_t h = (uint32_t)t;
+   h ^= h >> 16;
+   h *= 0x85EBCA6Bu;
+   h ^= h >> 13;
+   h *= 0xC2B2AE35u;
+   h ^= h >> 16;
+   return (int)h;
+}
+inline int unscramble(int t)
+{
+   uint32_t h = (uint32_t)t;
+   h ^= h >> 16;
+   h *= 0x7ED1B41Du;   // the inverse of 0xC2B2AE35 mod 2^32
+   h ^= (h >> 13) ^ (h >> 26);
+   h *= 0xA5CB9243u;   // the inverse of 0x85EBCA6B mod 2^32
+   h ^= h >> 16;
+   return (int)h;
+}
+
+/*****************************************
+ * RECIPROCAL
+ * The multiplier M that lets a % d be computed as the high 64 bits
+ * of (M * a mod 2^64) * d. See Lemire, Kaser and Kurz, "Faster
+ * Remainder by Direct Computation" (2019).
+ ****************************************/
+inline uint64_t reciprocal(uint32_t d)
+{
+   return UINT64_MAX / d + 1;
+}
+
+/*****************************************
+ * MIX
+ * Multiplicative mixer for partitioning: the golden ratio multiplier
+ * spreads nearby keys far apart in the high bits
+ ****************************************/
+const uint32_t MIX_MULTIPLIER = 0x9E3779B1u;
+
+/*****************************************
+ * BUCKET BATCH SCALAR
+ * out[i] = |keys[i]| % numBuckets
+ ****************************************/
+inline void bucketBatchScalar(const int* keys, size_t n, uint32_t numBuckets, uint32_t* out)
+{
+   for (size_t i = 0; i < n; ++i)
+      out[i] = fold(keys[i]) % numBuckets;
+}
+
+/*****************************************
+ * PARTITION BATCH SCALAR
+ * out[i] = the partition, in [0, numParts), that keys[i] belongs to
+ ****************************************/
+inline void partitionBatchScalar(const int* keys, size_t n, uint32_t numParts, uint32_t* out)
+{
+   for (size_t i = 0; i < n; ++i)
+   {
+      uint32_t mixed = fold(keys[i]) * MIX_MULTIPLIER;
+      out[i] = (uint32_t)(((uint64_t)mixed * numParts) >> 32);
+   }
+}
+
+#ifdef HASH_SIMD_X86
+/*****************************************
+ * BUCKET BATCH AVX2
+ * bucketBatchScalar, eight keys at a time. Each half of the eight is
+ * widened to 64 bit lanes so the reciprocal multiply stays exact.
+ ****************************************/
+HASH_TARGET_AVX2
+inline __m256i remainderAvx2(__m256i a, __m256i mLow, __m256i mHigh, __m256i d)
+{
+   // lowbits = M * a mod 2^64, built from two 32x32->64 multiplies
+   __m256i lowbits = _mm256_add_epi64(_mm256_mul_epu32(mLow, a),
+                                      _mm256_slli_epi64(_mm256_mul_epu32(mHigh, a), 32));
+
+   // high 64 bits of lowbits * d, again from two 32x32->64 multiplies
+   __m256i low  = _mm256_mul_epu32(lowbits, d);
+   __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(lowbits, 32), d);
+   return _mm256_srli_epi64(_mm256_add_epi64(high, _mm256_srli_epi64(low, 32)), 32);
+}
+
+HASH_TARGET_AVX2
+inline void bucketBatchAvx2(const int* keys, size_t n, uint32_t numBuckets, uint32_t* out)
+{
+   uint64_t m = reciprocal(numBuckets);
+   const __m256i mLow  = _mm256_set1_epi64x((long long)(m & 0xFFFFFFFFu));
+   const __m256i mHigh = _mm256_set1_epi64x((long long)(m >> 32));
+   const __m256i d     = _mm256_set1_epi64x((long long)numBuckets);
+   const __m256i pack  = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+   size_t i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      __m256i a = _mm256_abs_epi32(_mm256_loadu_si256((const __m256i*)(keys + i)));
+
+      // the remainders of the low four and high four keys
+      __m256i r0 = remainderAvx2(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(a)),
+                                 mLow, mHigh, d);
+      __m256i r1 = remainderAvx2(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(a, 1)),
+                                 mLow, mHigh, d);
+
+      // gather the eight 32 bit answers back together
+      __m128i lo = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(r0, pack));
+      __m128i hi = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(r1, pack));
+      _mm256_storeu_si256((__m256i*)(out + i),
+                          _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1));
+   }
+   bucketBatchScalar(keys + i, n - i, numBuckets, out + i);
+}
+
+/*****************************************
+ * PARTITION BATCH AVX2
+ * partitionBatchScalar, eight keys at a time
+ ****************************************/
+HASH_TARGET_AVX2
+inline void partitionBatchAvx2(const int* keys, size_t n, uint32_t numParts, uint32_t* out)
+{
+   const __m256i multiplier = _mm256_set1_epi32((int)MIX_MULTIPLIER);
+   const __m256i parts      = _mm256_set1_epi64x((long long)numParts);
+   const __m256i pack       = _mm256_setr_epi32(1, 3, 5, 7, 0, 2, 4, 6);
+
+   size_t i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      __m256i a = _mm256_abs_epi32(_mm256_loadu_si256((const __m256i*)(keys + i)));
+      __m256i mixed = _mm256_mullo_epi32(a, multiplier);
+
+      // (mixed * numParts) >> 32 for the even lanes, then the odd ones
+      __m256i even = _mm256_mul_epu32(mixed, parts);
+      __m256i odd  = _mm256_mul_epu32(_mm256_srli_epi64(mixed, 32), parts);
+
+      // the answers are the high halves of each 64 bit product
+      __m128i e = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(even, pack));
+      __m128i o = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(odd, pack));
+      __m256i lo = _mm256_castsi128_si256(_mm_unpacklo_epi32(e, o));
+      _mm256_storeu_si256((__m256i*)(out + i),
+                          _mm256_inserti128_si256(lo, _mm_unpackhi_epi32(e, o), 1));
+   }
+   partitionBatchScalar(keys + i, n - i, numParts, out + i);
+}
+#endif // HASH_SIMD_X86
+
+/*****************************************
+ * BUCKET BATCH and PARTITION BATCH
+ * Dispatch to the widest kernel this CPU can run
+ ****************************************/
+typedef void (*batchFunction)(const int* keys, size_t n, uint32_t divisor, uint32_t* out);
+
+inline void bucketBatch(const int* keys, size_t n, uint32_t numBuckets, uint32_t* out)
+{
+#ifdef HASH_SIMD_X86
+   static const batchFunction kernel = hasAvx2() ? bucketBatchAvx2 : bucketBatchScalar;
+#else
+   static const batchFunction kernel = bucketBatchScalar;
+#endif
+   kernel(keys, n, numBuckets, out);
+}
+
+inline void partitionBatch(const int* keys, size_t n, uint32_t numParts, uint32_t* out)
+{
+#ifdef HASH_SIMD_X86
+   static const batchFunction kernel = hasAvx2() ? partitionBatchAvx2 : partitionBatchScalar;
+#else
+   static const batchFunction kernel = partitionBatchScalar;
+#endif
+   kernel(keys, n, numParts, out);
+}
+
+/*****************************************
+ * PREFETCH
+ * Hint that p will be read soon
+ ****************************************/
+inline void prefetch(const void* p)
+{
+#ifdef HASH_SIMD_X86
+   _mm_prefetch((const char*)p, _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+   __builtin_prefetch(p);
+#else
+   (void)p;
+#endif
+}
+
+} // namespace simd
+} // namespace custom
@@ -0,0 +1,328 @@
+/***********************************************************************
+ * Header:
+ *    TEST BOUNDED SET
+ * Summary:
+ *    Unit tests for the bounded set and its CLOCK eviction
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "boundedSet.h"
+#include "unitTest.h"
+
+#include <random>
+
+
+class TestBoundedSet : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_small();
+      test_construct_large();
+
+      // Insert
+      test_insert_belowCapacity();
+      test_insert_duplicate();
+      test_insert_evict();
+      test_insert_secondChance();
+      test_insert_neverExceeds();
+      test_insert_hotKeySurvives();
+      test_insert_boundedSweep();
+
+      // Access
+      test_find_references();
+
+      // Remove
+      test_erase_shiftsReference();
+      test_erase_missing();
+      test_clear_standard();
+
+      report("BoundedSet");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // a small capacity still gets the usual 10 buckets
+   void test_construct_small()
+   {  // setup
+      // exercise
+      custom::bounded_unordered_set bs(3);
+      // verify
+      assertUnit(bs.maxElements == 3);
+      assertUnit(bs.numBuckets == 10);
+      assertUnit(bs.numElements == 0);
+      assertUnit(bs.hand == 0);
+      for (size_t i = 0; i < 10; i++)
+      {
+         assertUnit(bs.buckets[i] == HASH_EMPTY_VALUE);
+         assertUnit(!bs.referenced(i));
+      }
+   }  // teardown
+
+   // there are always twice as many buckets as the capacity
+   void test_construct_large()
+   {  // setup
+      // exercise
+      custom::bounded_unordered_set bs(100);
+      // verify
+      assertUnit(bs.capacity() == 100);
+      assertUnit(bs.bucket_count() == 200);
+      assertUnit(bs.begin() == bs.end());
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // with room to spare, insert behaves like unordered_set's
+   void test_insert_belowCapacity()
+   {  // setup
+      custom::bounded_unordered_set bs(5);
+      setupStandardFixture(bs);
+      // exercise
+      custom::bounded_unordered_set::iterator it = bs.insert(12);
+      // verify
+      assertUnit(*it == 12);
+      assertUnit(bs.buckets[2] == 12);
+      assertUnit(!bs.referenced(2));   // not used yet, only seen once
+      assertUnit(bs.numElements == 4);
+      assertUnit(bs.numEvictions == 0);
+   }  // teardown
+
+   // inserting a key already there marks it used
+   void test_insert_duplicate()
+   {  // setup
+      custom::bounded_unordered_set bs(5);
+      setupStandardFixture(bs);
+      // exercise
+      bs.insert(55);
+      // verify
+      assertUnit(bs.numElements == 3);
+      assertUnit(bs.buckets[5] == 55);
+      assertUnit(bs.referenced(5));
+   }  // teardown
+
+   // at capacity the hand clears bits until it reaches an unused key
+   void test_insert_evict()
+   {  // setup
+      custom::bounded_unordered_set bs(5);
+      setupStandardFixture(bs);
+      bs.insert(12);
+      bs.insert(13);
+      // exercise
+      bs.insert(14);
+      // verify
+      //    buckets: |   |31 |   |13 |14 |55 |   |67 |   |   |
+      //    refs:      0   0   0   0   0   0   0   1   0   0
+      //                       ^ hand
+      assertUnit(bs.numElements == 5);
+      assertUnit(bs.numEvictions == 1);
+      assertUnit(bs.hand == 2);
+      assertUnit(bs.buckets[2] == HASH_EMPTY_VALUE);
+      assertUnit(bs.buckets[4] == 14);
+      assertUnit(!bs.referenced(1));
+      assertUnit(bs.referenced(7));
+      assertUnit(bs.find(12) == bs.end());
+   }  // teardown
+
+   // a key used since the hand last passed gets a second chance
+   void test_insert_secondChance()
+   {  // setup
+      custom::bounded_unordered_set bs(5);
+      setupStandardFixture(bs);
+      bs.insert(12);
+      bs.insert(13);
+      bs.find(12);
+      // exercise
+      bs.insert(14);
+      // verify
+      assertUnit(bs.numEvictions == 1);
+      assertUnit(bs.hand == 3);
+      assertUnit(bs.buckets[2] == 12);
+      assertUnit(!bs.referenced(2));
+      assertUnit(bs.buckets[3] == HASH_EMPTY_VALUE);
+      assertUnit(bs.find(13) == bs.end());
+   }  // teardown
+
+   // however many keys go in, the size stays at the capacity
+   void test_insert_neverExceeds()
+   {  // setup
+      custom::bounded_unordered_set bs(100);
+      std::mt19937 rng(34);
+      // exercise
+      for (int i = 0; i < 10000; i++)
+         bs.insert((int)(rng() % 1000000));
+      // verify
+      assertUnit(bs.size() == 100);
+      assertUnit(bs.bucket_count() == 200);
+      size_t visited = 0;
+      size_t missing = 0;
+      for (custom::bounded_unordered_set::iterator it = bs.begin(); it != bs.end(); ++it)
+      {
+         visited++;
+         if (bs.find(*it) == bs.end())
+            missing++;
+      }
+      assertUnit(visited == 100);
+      assertUnit(missing == 0);
+      assertUnit(bs.evictions() + bs.size() <= 10000);
+   }  // teardown
+
+   // a key used between every insert is never evicted
+   void test_insert_hotKeySurvives()
+   {  // setup
+      custom::bounded_unordered_set bs(100);
+      for (int i = 0; i < 100; i++)
+         bs.insert(i);
+      // exercise
+      for (int i = 0; i < 1000; i++)
+      {
+         bs.find(0);
+         bs.insert(1000 + i);
+      }
+      // verify
+      assertUnit(bs.size() == 100);
+      assertUnit(bs.evictions() == 1000);
+      assertUnit(bs.find(0) != bs.end());
+   }  // teardown
+
+   // with every key just used the hand still stops after a window
+   void test_insert_boundedSweep()
+   {  // setup
+      custom::bounded_unordered_set bs(100);
+      for (int i = 0; i < 100; i++)
+         bs.insert(i * 2);   // homes 0, 2, 4, ... of the 200 buckets
+      for (int i = 0; i < 100; i++)
+         bs.find(i * 2);
+      // exercise
+      bs.insert(1);
+      // verify
+      size_t cleared = 0;   // old keys that lost their bit and survived
+      for (size_t i = 0; i < bs.numBuckets; i++)
+         if (bs.buckets[i] != HASH_EMPTY_VALUE && bs.buckets[i] != 1 && !bs.referenced(i))
+            cleared++;
+      assertUnit(bs.numEvictions == 1);
+      assertUnit(bs.size() == 100);
+      assertUnit(bs.find(0) == bs.end());
+      assertUnit(bs.find(1) != bs.end());
+      assertUnit(cleared == HASH_CLOCK_WINDOW - 1);
+      assertUnit(bs.hand == 0);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // finding a key sets its reference bit
+   void test_find_references()
+   {  // setup
+      custom::bounded_unordered_set bs(5);
+      setupStandardFixture(bs);
+      // exercise
+      custom::bounded_unordered_set::iterator it = bs.find(55);
+      // verify
+      assertUnit(*it == 55);
+      assertUnit(bs.referenced(5));
+      assertUnit(bs.find(77) == bs.end());
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // a key pulled back by erase takes its reference bit along
+   void test_erase_shiftsReference()
+   {  // setup
+      custom::bounded_unordered_set bs(5);
+      setupStandardFixture(bs);
+      bs.insert(65);   // home 5, lands in 6
+      bs.find(65);
+      // exercise
+      size_t count = bs.erase(55);
+      // verify
+      assertUnit(count == 1);
+      assertUnit(bs.numElements == 3);
+      assertUnit(bs.buckets[5] == 65);
+      assertUnit(bs.referenced(5));
+      assertUnit(bs.buckets[6] == HASH_EMPTY_VALUE);
+      assertUnit(!bs.referenced(6));
+   }  // teardown
+
+   // erasing a key that is not there changes nothing
+   void test_erase_missing()
+   {  // setup
+      custom::bounded_unordered_set bs(5);
+      setupStandardFixture(bs);
+      // exercise
+      size_t count = bs.erase(77);
+      // verify
+      assertUnit(count == 0);
+      assertStandardFixture(bs);
+   }  // teardown
+
+   // clear empties the buckets and the reference bits
+   void test_clear_standard()
+   {  // setup
+      custom::bounded_unordered_set bs(5);
+      setupStandardFixture(bs);
+      bs.hand = 6;
+      // exercise
+      bs.clear();
+      // verify
+      assertUnit(bs.numElements == 0);
+      assertUnit(bs.hand == 0);
+      for (size_t i = 0; i < 10; i++)
+      {
+         assertUnit(bs.buckets[i] == HASH_EMPTY_VALUE);
+         assertUnit(!bs.referenced(i));
+      }
+   }  // teardown
+
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *    buckets: |   |31 |   |   |   |55 |   |67 |   |   |
+    *    refs:      0   1   0   0   0   0   0   1   0   0
+    *    capacity 5, hand at 0
+    *************************************************************/
+   void setupStandardFixture(custom::bounded_unordered_set& bs)
+   {
+      bs.clear();
+      bs.buckets[5] = 55;
+      bs.buckets[7] = 67;
+      bs.buckets[1] = 31;
+      bs.reference(7, true);
+      bs.reference(1, true);
+      bs.numElements = 3;
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE
+    *************************************************************/
+   void assertStandardFixtureParameters(custom::bounded_unordered_set& bs, int line, const char* function)
+   {
+      assertIndirect(bs.numBuckets == 10);
+      assertIndirect(bs.maxElements == 5);
+      assertIndirect(bs.numElements == 3);
+      assertIndirect(bs.hand == 0);
+      for (size_t i = 0; i < 10; i++)
+      {
+         int expected = (i == 1) ? 31 : (i == 5) ? 55 : (i == 7) ? 67 : HASH_EMPTY_VALUE;
+         assertIndirect(bs.buckets[i] == expected);
+         assertIndirect(bs.referenced(i) == (i == 1 || i == 7));
+      }
+   }
+};
+
+#endif // DEBUG
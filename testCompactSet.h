@@ -0,0 +1,333 @@
+/***********************************************************************
+ * Header:
+ *    TEST COMPACT SET
+ * Summary:
+ *    Unit tests for the insertion-ordered compact set
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "compactSet.h"
+#include "unitTest.h"
+
+#include <vector>
+
+
+class TestCompactSet : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_constructIterator_standard();
+      test_constructCopy_standard();
+
+      // Insert
+      test_insert_duplicate();
+      test_insert_collision();
+      test_insert_grow();
+      test_insert_wideSlots();
+
+      // Access
+      test_find_standard();
+      test_find_missing();
+      test_iterator_insertionOrder();
+
+      // Remove
+      test_erase_middle();
+      test_erase_last();
+      test_erase_compact();
+      test_clear_standard();
+
+      report("CompactSet");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // create an empty compact set
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::compact_unordered_set cs;
+      // verify
+      assertUnit(cs.numSlots == 10);
+      assertUnit(cs.slotWidth == 1);
+      assertUnit(cs.numEntries == 0);
+      assertUnit(cs.numElements == 0);
+      for (size_t i = 0; i < 10; i++)
+         assertUnit(cs.getSlot(i) == 0);
+   }  // teardown
+
+   // build the standard fixture from a range
+   void test_constructIterator_standard()
+   {  // setup
+      std::vector<int> v{ 55, 67, 31 };
+      // exercise
+      custom::compact_unordered_set cs(v.begin(), v.end());
+      // verify
+      assertStandardFixture(cs);
+   }  // teardown
+
+   // copy a standard compact set
+   void test_constructCopy_standard()
+   {  // setup
+      custom::compact_unordered_set csSrc;
+      setupStandardFixture(csSrc);
+      // exercise
+      custom::compact_unordered_set csDes(csSrc);
+      // verify
+      assertStandardFixture(csSrc);
+      assertStandardFixture(csDes);
+      assertUnit(csSrc.entries != csDes.entries);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // inserting a key already there changes nothing
+   void test_insert_duplicate()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      // exercise
+      custom::compact_unordered_set::iterator it = cs.insert(67);
+      // verify
+      assertStandardFixture(cs);
+      assertUnit(&*it == cs.entries + 1);
+   }  // teardown
+
+   // a key whose home slot is taken goes in the next slot
+   void test_insert_collision()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      // exercise
+      custom::compact_unordered_set::iterator it = cs.insert(77);
+      // verify
+      //    entries:  +----+----+----+----+
+      //              | 55 | 67 | 31 | 77 |
+      //              +----+----+----+----+
+      //    index:    +---+---+---+---+---+---+---+---+---+---+
+      //              |   | 3 |   |   |   | 1 |   | 2 | 4 |   |
+      //              +---+---+---+---+---+---+---+---+---+---+
+      assertUnit(cs.numElements == 4);
+      assertUnit(cs.numEntries == 4);
+      assertUnit(cs.entries[3] == 77);
+      assertUnit(cs.getSlot(7) == 2);
+      assertUnit(cs.getSlot(8) == 4);
+      assertUnit(&*it == cs.entries + 3);
+   }  // teardown
+
+   // filling the entries doubles the index and keeps the order
+   void test_insert_grow()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      // exercise
+      cs.insert(12);
+      cs.insert(13);
+      cs.insert(14);
+      cs.insert(15);   // the seventh key does not fit in six entries
+      // verify
+      assertUnit(cs.numSlots == 20);
+      assertUnit(cs.numElements == 7);
+      std::vector<int> order;
+      for (custom::compact_unordered_set::iterator it = cs.begin(); it != cs.end(); ++it)
+         order.push_back(*it);
+      assertUnit(order == std::vector<int>({ 55, 67, 31, 12, 13, 14, 15 }));
+   }  // teardown
+
+   // past 255 entries the index slots widen to two bytes
+   void test_insert_wideSlots()
+   {  // setup
+      custom::compact_unordered_set cs;
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         cs.insert(i * 7);
+      // verify
+      assertUnit(cs.slotWidth == 2);
+      assertUnit(cs.size() == 1000);
+      size_t missing = 0;
+      for (int i = 0; i < 1000; i++)
+         if (cs.find(i * 7) == cs.end())
+            missing++;
+      assertUnit(missing == 0);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // find every key of the standard fixture
+   void test_find_standard()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      // exercise and verify
+      assertUnit(&*cs.find(55) == cs.entries + 0);
+      assertUnit(&*cs.find(67) == cs.entries + 1);
+      assertUnit(&*cs.find(31) == cs.entries + 2);
+      assertStandardFixture(cs);
+   }  // teardown
+
+   // find a key that is not there
+   void test_find_missing()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      // exercise
+      custom::compact_unordered_set::iterator it = cs.find(77);
+      // verify
+      assertUnit(it == cs.end());
+      assertStandardFixture(cs);
+   }  // teardown
+
+   // iteration follows insertion order, not bucket order
+   void test_iterator_insertionOrder()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      std::vector<int> order;
+      // exercise
+      for (custom::compact_unordered_set::iterator it = cs.begin(); it != cs.end(); ++it)
+         order.push_back(*it);
+      // verify
+      assertUnit(order == std::vector<int>({ 55, 67, 31 }));
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // erasing from the middle leaves a hole that iteration skips
+   void test_erase_middle()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      cs.insert(12);
+      // exercise
+      size_t count = cs.erase(67);
+      // verify
+      //    entries:  +----+----+----+----+
+      //              | 55 |    | 31 | 12 |
+      //              +----+----+----+----+
+      assertUnit(count == 1);
+      assertUnit(cs.numElements == 3);
+      assertUnit(cs.numEntries == 4);
+      assertUnit(cs.entries[1] == HASH_EMPTY_VALUE);
+      assertUnit(cs.getSlot(7) == 0);
+      std::vector<int> order;
+      for (custom::compact_unordered_set::iterator it = cs.begin(); it != cs.end(); ++it)
+         order.push_back(*it);
+      assertUnit(order == std::vector<int>({ 55, 31, 12 }));
+   }  // teardown
+
+   // erasing the newest key just shortens the entries
+   void test_erase_last()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      // exercise
+      cs.erase(31);
+      // verify
+      assertUnit(cs.numElements == 2);
+      assertUnit(cs.numEntries == 2);
+      assertUnit(cs.getSlot(1) == 0);
+      assertUnit(cs.find(31) == cs.end());
+   }  // teardown
+
+   // once half the entries are holes they are squeezed out
+   void test_erase_compact()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      cs.insert(12);
+      cs.insert(13);
+      // exercise
+      cs.erase(55);
+      cs.erase(67);
+      cs.erase(31);   // three holes out of five entries
+      // verify
+      assertUnit(cs.numElements == 2);
+      assertUnit(cs.numEntries == 2);
+      assertUnit(cs.entries[0] == 12);
+      assertUnit(cs.entries[1] == 13);
+      assertUnit(&*cs.find(12) == cs.entries + 0);
+      assertUnit(&*cs.find(13) == cs.entries + 1);
+   }  // teardown
+
+   // clear a standard compact set
+   void test_clear_standard()
+   {  // setup
+      custom::compact_unordered_set cs;
+      setupStandardFixture(cs);
+      // exercise
+      cs.clear();
+      // verify
+      assertUnit(cs.numElements == 0);
+      assertUnit(cs.numEntries == 0);
+      assertUnit(cs.begin() == cs.end());
+      for (size_t i = 0; i < 10; i++)
+         assertUnit(cs.getSlot(i) == 0);
+   }  // teardown
+
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *    entries:  +----+----+----+
+    *              | 55 | 67 | 31 |
+    *              +----+----+----+
+    *    index:    +---+---+---+---+---+---+---+---+---+---+
+    *              |   | 3 |   |   |   | 1 |   | 2 |   |   |
+    *              +---+---+---+---+---+---+---+---+---+---+
+    *************************************************************/
+   void setupStandardFixture(custom::compact_unordered_set& cs)
+   {
+      cs.clear();
+      cs.entries[0] = 55;
+      cs.entries[1] = 67;
+      cs.entries[2] = 31;
+      cs.setSlot(5, 1);
+      cs.setSlot(7, 2);
+      cs.setSlot(1, 3);
+      cs.numEntries = 3;
+      cs.numElements = 3;
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE
+    *************************************************************/
+   void assertStandardFixtureParameters(custom::compact_unordered_set& cs, int line, const char* function)
+   {
+      assertIndirect(cs.numSlots == 10);
+      assertIndirect(cs.numElements == 3);
+      assertIndirect(cs.numEntries == 3);
+      assertIndirect(cs.entries[0] == 55);
+      assertIndirect(cs.entries[1] == 67);
+      assertIndirect(cs.entries[2] == 31);
+
+      assertIndirect(cs.getSlot(0) == 0);
+      assertIndirect(cs.getSlot(1) == 3);
+      assertIndirect(cs.getSlot(2) == 0);
+      assertIndirect(cs.getSlot(3) == 0);
+      assertIndirect(cs.getSlot(4) == 0);
+      assertIndirect(cs.getSlot(5) == 1);
+      assertIndirect(cs.getSlot(6) == 0);
+      assertIndirect(cs.getSlot(7) == 2);
+      assertIndirect(cs.getSlot(8) == 0);
+      assertIndirect(cs.getSlot(9) == 0);
+   }
+};
+
+#endif // DEBUG
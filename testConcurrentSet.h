@@ -0,0 +1,477 @@
+/***********************************************************************
+ * Header:
+ *    TEST CONCURRENT SET
+ * Summary:
+ *    Unit tests for the concurrent set and its cooperative resize
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "concurrentSet.h"
+#include "unitTest.h"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+
+
+class TestConcurrentSet : public UnitTest
+{
+   typedef custom::concurrent_unordered_set Set;
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+
+      // Insert
+      test_insert_standard();
+      test_insert_duplicate();
+      test_insert_collision();
+      test_insert_grow();
+      test_insert_growReclaims();
+
+      // Remove
+      test_erase_marksDeleted();
+      test_erase_missing();
+      test_erase_sweptOnGrow();
+
+      // Resize
+      test_resize_claimChunks();
+      test_resize_helpFinishes();
+      test_resize_lastOutReclaims();
+      test_resize_churnReclaims();
+
+      // Threads
+      test_threads_insertDisjoint();
+      test_threads_insertSame();
+      test_threads_insertErase();
+      test_threads_churnReclaims();
+
+      report("ConcurrentSet");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // create an empty concurrent set
+   void test_construct_default()
+   {  // setup
+      // exercise
+      Set cs;
+      // verify
+      Set::table* tab = cs.current.load();
+      assertUnit(cs.retired == nullptr);
+      assertUnit(cs.active == 0);
+      assertUnit(tab->numBuckets == 10);
+      assertUnit(tab->used == 0);
+      assertUnit(tab->next == nullptr);
+      assertUnit(cs.numElements == 0);
+      for (size_t i = 0; i < 10; i++)
+         assertUnit(Set::stateOf(tab->slots[i]) == Set::SLOT_EMPTY);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert the keys of the standard fixture
+   void test_insert_standard()
+   {  // setup
+      Set cs;
+      // exercise
+      bool b55 = cs.insert(55);
+      bool b67 = cs.insert(67);
+      bool b31 = cs.insert(31);
+      // verify
+      assertUnit(b55 && b67 && b31);
+      assertStandardFixture(cs);
+   }  // teardown
+
+   // inserting a key already there changes nothing
+   void test_insert_duplicate()
+   {  // setup
+      Set cs;
+      setupStandardFixture(cs);
+      // exercise
+      bool inserted = cs.insert(67);
+      // verify
+      assertUnit(!inserted);
+      assertStandardFixture(cs);
+   }  // teardown
+
+   // a key whose home bucket is taken goes in the next one
+   void test_insert_collision()
+   {  // setup
+      Set cs;
+      setupStandardFixture(cs);
+      // exercise
+      bool inserted = cs.insert(77);
+      // verify
+      //    +---+---+---+---+---+---+---+---+---+---+
+      //    |   |31 |   |   |   |55 |   |67 |77 |   |
+      //    +---+---+---+---+---+---+---+---+---+---+
+      Set::table* tab = cs.current.load();
+      assertUnit(inserted);
+      assertUnit(tab->slots[8] == Set::pack(Set::SLOT_FULL, 77));
+      assertUnit(tab->used == 4);
+      assertUnit(cs.size() == 4);
+   }  // teardown
+
+   // passing half full moves everything into a table twice the size
+   void test_insert_grow()
+   {  // setup
+      Set cs;
+      setupStandardFixture(cs);
+      cs.insert(12);
+      cs.insert(13);
+      Set::table* old = cs.current.load();
+      cs.active++;     // another thread is inside, so the old table stays
+      // exercise
+      cs.insert(14);   // six used buckets out of ten
+      // verify
+      Set::table* tab = cs.current.load();
+      assertUnit(tab != old);
+      assertUnit(old->next == tab);
+      assertUnit(cs.retired == old);
+      assertUnit(tab->numBuckets == 20);
+      assertUnit(tab->used == 6);
+      assertUnit(cs.size() == 6);
+      for (size_t i = 0; i < 10; i++)
+         assertUnit(Set::stateOf(old->slots[i]) == Set::SLOT_MOVED);
+      assertUnit(tab->slots[14] == Set::pack(Set::SLOT_FULL, 14));
+      assertUnit(tab->slots[15] == Set::pack(Set::SLOT_FULL, 55));
+      assertUnit(cs.contains(55) && cs.contains(67) && cs.contains(31));
+      assertUnit(cs.contains(12) && cs.contains(13) && cs.contains(14));
+      cs.active--;
+   }  // teardown
+
+   // the old table is freed as soon as no thread can be reading it
+   void test_insert_growReclaims()
+   {  // setup
+      Set cs;
+      setupStandardFixture(cs);
+      cs.insert(12);
+      cs.insert(13);
+      // exercise
+      cs.insert(14);   // six used buckets out of ten
+      // verify
+      assertUnit(cs.bucket_count() == 20);
+      assertUnit(cs.retired == nullptr);
+      assertUnit(cs.active == 0);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // erasing leaves a DELETED marker that probing passes over
+   void test_erase_marksDeleted()
+   {  // setup
+      Set cs;
+      setupStandardFixture(cs);
+      cs.insert(77);
+      // exercise
+      bool erased = cs.erase(67);
+      // verify
+      Set::table* tab = cs.current.load();
+      assertUnit(erased);
+      assertUnit(tab->slots[7] == Set::pack(Set::SLOT_DELETED, 67));
+      assertUnit(tab->used == 4);
+      assertUnit(cs.size() == 3);
+      assertUnit(!cs.contains(67));
+      assertUnit(cs.contains(77));
+   }  // teardown
+
+   // erasing a key that is not there changes nothing
+   void test_erase_missing()
+   {  // setup
+      Set cs;
+      setupStandardFixture(cs);
+      // exercise
+      bool erased = cs.erase(77);
+      // verify
+      assertUnit(!erased);
+      assertStandardFixture(cs);
+   }  // teardown
+
+   // DELETED markers are not copied when the table moves
+   void test_erase_sweptOnGrow()
+   {  // setup
+      Set cs;
+      setupStandardFixture(cs);
+      cs.insert(12);
+      cs.erase(55);
+      cs.erase(67);
+      // exercise
+      cs.insert(13);
+      cs.insert(14);   // six used buckets, but only four keys
+      // verify
+      Set::table* tab = cs.current.load();
+      assertUnit(tab->numBuckets == 20);
+      assertUnit(tab->used == 4);
+      assertUnit(cs.size() == 4);
+      assertUnit(!cs.contains(55) && !cs.contains(67));
+   }  // teardown
+
+   /***************************************
+    * RESIZE
+    ***************************************/
+
+   // each claim moves exactly one chunk and leaves the rest alone
+   void test_resize_claimChunks()
+   {  // setup
+      Set cs(4 * HASH_TRANSFER_CHUNK);
+      for (int i = 0; i < 1000; i++)
+         cs.insert(i * 4);   // spread over all four chunks
+      Set::table* tab = cs.current.load();
+      tab->next.store(new Set::table(8 * HASH_TRANSFER_CHUNK));
+      // exercise
+      bool first = cs.claim(tab);
+      bool second = cs.claim(tab);
+      // verify
+      assertUnit(first && second);
+      assertUnit(tab->chunksDone == 2);
+      assertUnit(cs.current.load() == tab);
+      size_t moved = 0;
+      size_t full = 0;
+      for (size_t i = 0; i < tab->numBuckets; i++)
+      {
+         uint32_t state = Set::stateOf(tab->slots[i]);
+         if (i < 2 * HASH_TRANSFER_CHUNK && state == Set::SLOT_MOVED)
+            moved++;
+         if (i >= 2 * HASH_TRANSFER_CHUNK && state == Set::SLOT_FULL)
+            full++;
+      }
+      assertUnit(moved == 2 * HASH_TRANSFER_CHUNK);
+      assertUnit(full == 488);   // keys 2048 through 3996
+      assertUnit(tab->next.load()->used == 512);
+   }  // teardown
+
+   // a thread that runs into a half-moved table finishes the move
+   void test_resize_helpFinishes()
+   {  // setup
+      Set cs(4 * HASH_TRANSFER_CHUNK);
+      for (int i = 0; i < 1000; i++)
+         cs.insert(i * 4);
+      Set::table* tab = cs.current.load();
+      Set::table* grown = new Set::table(8 * HASH_TRANSFER_CHUNK);
+      tab->next.store(grown);
+      cs.active++;     // this thread is still inside, holding tab
+      cs.claim(tab);
+      // exercise
+      std::thread helper([&cs]() { cs.insert(1); });
+      helper.join();
+      // verify
+      assertUnit(tab->chunksDone == 4);
+      assertUnit(cs.retired == tab);
+      assertUnit(cs.current.load() == grown);
+      assertUnit(grown->used == 1001);
+      assertUnit(cs.size() == 1001);
+      size_t missing = 0;
+      for (int i = 0; i < 1000; i++)
+         if (!cs.contains(i * 4))
+            missing++;
+      assertUnit(missing == 0);
+      assertUnit(cs.contains(1));
+      cs.active--;
+   }  // teardown
+
+   // the last thread out frees every table retired while it was in
+   void test_resize_lastOutReclaims()
+   {  // setup
+      Set cs;
+      cs.active++;     // hold the set open while it grows
+      for (int i = 0; i < 1000; i++)
+         cs.insert(i);
+      size_t retired = 0;
+      for (Set::table* tab = cs.retired; tab; tab = tab->nextRetired)
+         retired++;
+      cs.active--;
+      // exercise
+      bool found = cs.contains(500);
+      // verify
+      assertUnit(retired > 1);
+      assertUnit(found);
+      assertUnit(cs.retired == nullptr);
+      assertUnit(cs.active == 0);
+   }  // teardown
+
+   // erasing and inserting over and over keeps sweeping DELETED markers
+   // out with same size moves, and none of those tables pile up
+   void test_resize_churnReclaims()
+   {  // setup
+      Set cs;
+      for (int i = 0; i < 1000; i++)
+         cs.insert(i);
+      size_t buckets = cs.bucket_count();
+      // exercise
+      for (int i = 1000; i < 201000; i++)
+      {
+         cs.erase(i - 1000);
+         cs.insert(i);
+      }
+      // verify
+      assertUnit(cs.size() == 1000);
+      assertUnit(cs.bucket_count() <= buckets * 2);
+      assertUnit(cs.retired == nullptr);
+   }  // teardown
+
+   /***************************************
+    * THREADS
+    ***************************************/
+
+   // threads inserting different keys grow the table together
+   void test_threads_insertDisjoint()
+   {  // setup
+      Set cs;
+      std::vector<std::thread> threads;
+      // exercise
+      for (int t = 0; t < 4; t++)
+         threads.push_back(std::thread([&cs, t]()
+         {
+            for (int i = 0; i < 50000; i++)
+               cs.insert(i * 4 + t);
+         }));
+      for (std::thread& thread : threads)
+         thread.join();
+      // verify
+      assertUnit(cs.size() == 200000);
+      assertUnit(cs.bucket_count() >= 400000);
+      size_t missing = 0;
+      for (int i = 0; i < 200000; i++)
+         if (!cs.contains(i))
+            missing++;
+      assertUnit(missing == 0);
+   }  // teardown
+
+   // threads racing to insert the same keys: each goes in exactly once
+   void test_threads_insertSame()
+   {  // setup
+      Set cs;
+      std::atomic<size_t> inserted(0);
+      std::vector<std::thread> threads;
+      // exercise
+      for (int t = 0; t < 4; t++)
+         threads.push_back(std::thread([&cs, &inserted]()
+         {
+            for (int i = 0; i < 20000; i++)
+               if (cs.insert(i))
+                  inserted++;
+         }));
+      for (std::thread& thread : threads)
+         thread.join();
+      // verify
+      assertUnit(inserted == 20000);
+      assertUnit(cs.size() == 20000);
+   }  // teardown
+
+   // inserts and erases from several threads, right through the resizes
+   void test_threads_insertErase()
+   {  // setup
+      Set cs;
+      std::vector<std::thread> threads;
+      // exercise
+      for (int t = 0; t < 4; t++)
+         threads.push_back(std::thread([&cs, t]()
+         {
+            for (int i = 0; i < 20000; i++)
+            {
+               cs.insert(i * 4 + t);
+               if (i % 2 == 0)
+                  cs.erase(i * 4 + t);
+            }
+         }));
+      for (std::thread& thread : threads)
+         thread.join();
+      // verify
+      assertUnit(cs.size() == 40000);
+      size_t wrong = 0;
+      for (int i = 0; i < 80000; i++)
+         if (cs.contains(i) != ((i / 4) % 2 == 1))
+            wrong++;
+      assertUnit(wrong == 0);
+   }  // teardown
+
+   // threads churning through keys sweep the table many times over;
+   // once they have all left, every table they moved out of is freed
+   void test_threads_churnReclaims()
+   {  // setup
+      Set cs;
+      std::vector<std::thread> threads;
+      // exercise
+      for (int t = 0; t < 4; t++)
+         threads.push_back(std::thread([&cs, t]()
+         {
+            for (int i = 0; i < 250; i++)
+               cs.insert(i * 4 + t);
+            for (int i = 250; i < 50250; i++)
+            {
+               cs.erase((i - 250) * 4 + t);
+               cs.insert(i * 4 + t);
+            }
+         }));
+      for (std::thread& thread : threads)
+         thread.join();
+      // verify
+      assertUnit(cs.size() == 1000);
+      assertUnit(cs.retired == nullptr);
+      assertUnit(cs.active == 0);
+      size_t missing = 0;
+      for (int i = 50000 * 4; i < 50250 * 4; i++)
+         if (!cs.contains(i))
+            missing++;
+      assertUnit(missing == 0);
+   }  // teardown
+
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *   +---+---+---+---+---+---+---+---+---+---+
+    *   |   |31 |   |   |   |55 |   |67 |   |   |
+    *   +---+---+---+---+---+---+---+---+---+---+
+    *************************************************************/
+   void setupStandardFixture(Set& cs)
+   {
+      Set::table* tab = cs.current.load();
+      for (size_t i = 0; i < tab->numBuckets; i++)
+         tab->slots[i] = Set::pack(Set::SLOT_EMPTY, 0);
+      tab->slots[5] = Set::pack(Set::SLOT_FULL, 55);
+      tab->slots[7] = Set::pack(Set::SLOT_FULL, 67);
+      tab->slots[1] = Set::pack(Set::SLOT_FULL, 31);
+      tab->used = 3;
+      cs.numElements = 3;
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE
+    *************************************************************/
+   void assertStandardFixtureParameters(Set& cs, int line, const char* function)
+   {
+      Set::table* tab = cs.current.load();
+      assertIndirect(tab->numBuckets == 10);
+      assertIndirect(tab->used == 3);
+      assertIndirect(cs.numElements == 3);
+      for (size_t i = 0; i < 10; i++)
+      {
+         uint64_t expected = Set::pack(Set::SLOT_EMPTY, 0);
+         if (i == 1)
+            expected = Set::pack(Set::SLOT_FULL, 31);
+         else if (i == 5)
+            expected = Set::pack(Set::SLOT_FULL, 55);
+         else if (i == 7)
+            expected = Set::pack(Set::SLOT_FULL, 67);
+         assertIndirect(tab->slots[i] == expected);
+      }
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,271 @@
+/***********************************************************************
+ * Header:
+ *    TEST EXTERNAL DEDUP
+ * Summary:
+ *    Unit tests for deduping with spill-to-disk partitions
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "externalSet.h"
+#include "unitTest.h"
+
+#include <cstdio>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+
+class TestExternalDedup : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // In memory
+      test_memory_underBudget();
+      test_memory_emptyValue();
+
+      // Spill
+      test_spill_overBudget();
+      test_spill_blocks();
+      test_spill_splitAgain();
+      test_spill_emptyValue();
+      test_spill_namedRuns();
+      test_spill_cannotCreate();
+      test_spill_readTwice();
+
+      report("ExternalDedup");
+   }
+
+   /***************************************
+    * IN MEMORY
+    ***************************************/
+
+   // while the buckets fit, nothing touches the disk
+   void test_memory_underBudget()
+   {  // setup
+      custom::external_dedup ed(1 << 20);
+      std::vector<int> keys;
+      for (int i = 0; i < 3000; i++)
+         keys.push_back(i % 1000 - 500);
+      // exercise
+      ed.insert_batch(keys.data(), keys.size());
+      std::vector<int> distinct;
+      size_t count = ed.for_each_distinct([&distinct](int key) { distinct.push_back(key); });
+      // verify
+      assertUnit(!ed.spilled());
+      assertUnit(ed.spilled_keys() == 0);
+      assertUnit(count == 1000);
+      assertUnit(std::set<int>(distinct.begin(), distinct.end()) == expected(keys));
+      assertUnit(distinct.size() == 1000);
+   }  // teardown
+
+   // HASH_EMPTY_VALUE cannot go in the set, so it is kept on the side
+   void test_memory_emptyValue()
+   {  // setup
+      custom::external_dedup ed(1 << 20);
+      // exercise
+      ed.insert(HASH_EMPTY_VALUE);
+      ed.insert(55);
+      ed.insert(HASH_EMPTY_VALUE);
+      std::vector<int> distinct;
+      size_t count = ed.for_each_distinct([&distinct](int key) { distinct.push_back(key); });
+      // verify
+      assertUnit(count == 2);
+      assertUnit(std::set<int>(distinct.begin(), distinct.end()) ==
+                 std::set<int>({ 55, HASH_EMPTY_VALUE }));
+      assertUnit(ed.hasEmptyValue);
+      assertUnit(ed.set.size() == 1);
+   }  // teardown
+
+   /***************************************
+    * SPILL
+    ***************************************/
+
+   // past the budget every key, old and new, goes out to the runs
+   void test_spill_overBudget()
+   {  // setup
+      custom::external_dedup ed(64 * 1024, nullptr, 8);
+      std::vector<int> keys;
+      for (int i = 0; i < 200000; i++)
+         keys.push_back((i * 7919) % 50000);
+      // exercise
+      ed.insert_batch(keys.data(), keys.size());
+      std::vector<int> distinct;
+      size_t count = ed.for_each_distinct([&distinct](int key) { distinct.push_back(key); });
+      // verify
+      assertUnit(ed.spilled());
+      assertUnit(ed.runs.size() == 8);
+      assertUnit(ed.set.size() == 0);
+      assertUnit(count == 50000);
+      assertUnit(distinct.size() == 50000);
+      assertUnit(std::set<int>(distinct.begin(), distinct.end()) == expected(keys));
+   }  // teardown
+
+   // full blocks reach the writer and come back as spares
+   void test_spill_blocks()
+   {  // setup
+      custom::external_dedup ed(64 * 1024, nullptr, 4);
+      std::vector<int> keys;
+      for (int i = 0; i < 100000; i++)
+         keys.push_back(i);
+      // exercise
+      ed.insert_batch(keys.data(), keys.size());
+      ed.finish();
+      // verify
+      assertUnit(ed.blockSize == 1024);
+      assertUnit(ed.spilled_keys() > 90000);
+      assertUnit(ed.queue.empty());
+      assertUnit(ed.spare.size() == 4);
+      assertUnit(!ed.failed);
+      size_t written = 0;
+      for (FILE* run : ed.runs)
+      {
+         std::fflush(run);
+         std::fseek(run, 0, SEEK_END);
+         written += (size_t)std::ftell(run) / sizeof(int);
+      }
+      assertUnit(written == ed.spilled_keys());
+   }  // teardown
+
+   // with two partitions the runs are still too big, so they split again
+   void test_spill_splitAgain()
+   {  // setup
+      custom::external_dedup ed(16 * 1024, nullptr, 2);
+      std::vector<int> keys;
+      for (int i = 0; i < 60000; i++)
+         keys.push_back(i * 3 - 90000);
+      keys.insert(keys.end(), keys.begin(), keys.begin() + 20000);
+      // exercise
+      ed.insert_batch(keys.data(), keys.size());
+      std::vector<int> distinct;
+      size_t count = ed.for_each_distinct([&distinct](int key) { distinct.push_back(key); });
+      // verify
+      assertUnit(count == 60000);
+      assertUnit(distinct.size() == 60000);
+      assertUnit(std::set<int>(distinct.begin(), distinct.end()) == expected(keys));
+   }  // teardown
+
+   // HASH_EMPTY_VALUE never goes to a run, spilled or not
+   void test_spill_emptyValue()
+   {  // setup
+      custom::external_dedup ed(16 * 1024, nullptr, 4);
+      std::vector<int> keys;
+      for (int i = 0; i < 20000; i++)
+         keys.push_back(i);
+      keys.push_back(HASH_EMPTY_VALUE);
+      keys.push_back(HASH_EMPTY_VALUE);
+      // exercise
+      ed.insert_batch(keys.data(), keys.size());
+      size_t count = ed.for_each_distinct([](int) {});
+      // verify
+      assertUnit(ed.spilled());
+      assertUnit(count == 20001);
+   }  // teardown
+
+   // runs in a directory have names, and are gone once deduped
+   void test_spill_namedRuns()
+   {  // setup
+      std::vector<std::string> paths;
+      size_t count = 0;
+      {
+         custom::external_dedup ed(16 * 1024, ".", 4);
+         for (int i = 0; i < 20000; i++)
+            ed.insert(i % 15000);
+         paths = ed.paths;
+         // exercise
+         count = ed.for_each_distinct([](int) {});
+      }
+      // verify
+      assertUnit(paths.size() == 4);
+      assertUnit(count == 15000);
+      size_t left = 0;
+      for (const std::string& path : paths)
+      {
+         FILE* file = std::fopen(path.c_str(), "rb");
+         if (file)
+         {
+            left++;
+            std::fclose(file);
+         }
+      }
+      assertUnit(left == 0);
+   }  // teardown
+
+   // a spill that cannot open its runs leaves the keys in the set
+   void test_spill_cannotCreate()
+   {  // setup
+      custom::external_dedup ed(16 * 1024, "./no-such-directory", 4);
+      std::vector<int> keys;
+      for (int i = 0; i < 20000; i++)
+         keys.push_back(i);
+      bool threw = false;
+      // exercise
+      try
+      {
+         ed.insert_batch(keys.data(), keys.size());
+      }
+      catch (const std::runtime_error&)
+      {
+         threw = true;
+      }
+      // verify
+      assertUnit(threw);
+      assertUnit(!ed.spilled());
+      assertUnit(ed.paths.empty());
+      assertUnit(ed.active.empty());
+      assertUnit(ed.set.size() > 0);
+      assertUnit(ed.for_each_distinct([](int) {}) == ed.set.size());
+   }  // teardown
+
+   // the runs are read up by the first pass, so a second is refused
+   void test_spill_readTwice()
+   {  // setup
+      custom::external_dedup ed(16 * 1024, nullptr, 4);
+      for (int i = 0; i < 20000; i++)
+         ed.insert(i);
+      size_t count = ed.for_each_distinct([](int) {});
+      bool threwDistinct = false;
+      bool threwInsert = false;
+      // exercise
+      try
+      {
+         ed.for_each_distinct([](int) {});
+      }
+      catch (const std::logic_error&)
+      {
+         threwDistinct = true;
+      }
+      try
+      {
+         ed.insert(20000);
+      }
+      catch (const std::logic_error&)
+      {
+         threwInsert = true;
+      }
+      // verify
+      assertUnit(count == 20000);
+      assertUnit(threwDistinct);
+      assertUnit(threwInsert);
+   }  // teardown
+
+
+   /*************************************************************
+    * EXPECTED
+    * The distinct keys, the slow sure way
+    *************************************************************/
+   static std::set<int> expected(const std::vector<int>& keys)
+   {
+      return std::set<int>(keys.begin(), keys.end());
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,293 @@
+/***********************************************************************
+ * Header:
+ *    TEST GENERATION SET
+ * Summary:
+ *    Unit tests for the hash set with generation-tagged buckets
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "generationSet.h"
+#include "unitTest.h"
+
+#include <climits>
+#include <set>
+
+
+class TestGenerationSet : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+
+      // Insert
+      test_insert_standard();
+      test_insert_emptyValue();
+      test_insert_grow();
+
+      // Remove
+      test_clear_keepsBuckets();
+      test_clear_reuseStale();
+      test_clear_wrap();
+      test_erase_shiftStopsAtStale();
+
+      // Iterator
+      test_iterator_skipsStale();
+
+      // Performance
+      test_perf_clearLarge();
+
+      report("GenerationSet");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // ten buckets, none of them in the current generation
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::generation_unordered_set gs;
+      // verify
+      assertUnit(gs.numBuckets == 10);
+      assertUnit(gs.numElements == 0);
+      assertUnit(gs.generation == 1);
+      for (size_t i = 0; i < 10; i++)
+         assertUnit(!gs.filled(i));
+      assertUnit(gs.begin() == gs.end());
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // keys land where unordered_set would put them
+   void test_insert_standard()
+   {  // setup
+      custom::generation_unordered_set gs;
+      // exercise
+      setupStandardFixture(gs);
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertStandardFixture(gs);
+   }  // teardown
+
+   // with no sentinel, HASH_EMPTY_VALUE is a key like any other
+   void test_insert_emptyValue()
+   {  // setup
+      custom::generation_unordered_set gs;
+      // exercise
+      gs.insert(HASH_EMPTY_VALUE);
+      gs.insert(HASH_EMPTY_VALUE);
+      gs.insert(INT_MIN);
+      // verify
+      assertUnit(gs.size() == 2);
+      assertUnit(gs.slots[1].key == HASH_EMPTY_VALUE);
+      assertUnit(gs.filled(1));
+      assertUnit(*gs.find(HASH_EMPTY_VALUE) == HASH_EMPTY_VALUE);
+      assertUnit(*gs.find(INT_MIN) == INT_MIN);
+   }  // teardown
+
+   // growing carries only the current generation's keys across
+   void test_insert_grow()
+   {  // setup
+      custom::generation_unordered_set gs;
+      for (int i = 0; i < 4; i++)
+         gs.insert(i * 100);
+      gs.clear();
+      // exercise
+      for (int i = 0; i < 6; i++)
+         gs.insert(i * 7);
+      // verify
+      assertUnit(gs.bucket_count() == 20);
+      assertUnit(gs.size() == 6);
+      assertUnit(gs.generation == 1);
+      for (int i = 0; i < 6; i++)
+         assertUnit(gs.find(i * 7) != gs.end());
+      assertUnit(gs.find(100) == gs.end());
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // clear leaves the buckets alone: they are simply out of date
+   void test_clear_keepsBuckets()
+   {  // setup
+      custom::generation_unordered_set gs;
+      setupStandardFixture(gs);
+      // exercise
+      gs.clear();
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //         gen 1               gen 1     gen 1        now gen 2
+      assertUnit(gs.numElements == 0);
+      assertUnit(gs.generation == 2);
+      assertUnit(gs.slots[1].key == 31);
+      assertUnit(gs.slots[1].generation == 1);
+      for (size_t i = 0; i < 10; i++)
+         assertUnit(!gs.filled(i));
+      assertUnit(gs.find(31) == gs.end());
+      assertUnit(gs.begin() == gs.end());
+   }  // teardown
+
+   // a stale bucket is taken like an empty one, and ends probe runs
+   void test_clear_reuseStale()
+   {  // setup
+      custom::generation_unordered_set gs;
+      setupStandardFixture(gs);
+      gs.clear();
+      // exercise
+      gs.insert(75);
+      gs.insert(85);
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 75 | 85 | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //         stale               gen 2 gen 2 stale
+      assertUnit(gs.size() == 2);
+      assertUnit(gs.slots[5].key == 75);
+      assertUnit(gs.slots[6].key == 85);
+      assertUnit(gs.slots[7].key == 67);
+      assertUnit(!gs.filled(7));
+      assertUnit(gs.find(67) == gs.end());
+      assertUnit(gs.find(55) == gs.end());
+   }  // teardown
+
+   // once every 2^32 clears the tags are wiped for real
+   void test_clear_wrap()
+   {  // setup
+      custom::generation_unordered_set gs;
+      gs.generation = UINT32_MAX;
+      gs.insert(31);
+      // exercise
+      gs.clear();
+      // verify
+      assertUnit(gs.generation == 1);
+      assertUnit(gs.slots[1].generation == 0);
+      assertUnit(gs.find(31) == gs.end());
+      gs.insert(41);
+      assertUnit(gs.slots[1].key == 41);
+   }  // teardown
+
+   // erase shifts keys back, but not across a stale bucket
+   void test_erase_shiftStopsAtStale()
+   {  // setup
+      custom::generation_unordered_set gs;
+      gs.insert(5);
+      gs.insert(15);
+      gs.insert(25);
+      gs.clear();
+      gs.insert(5);
+      gs.insert(15);
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    |  5 | 15 | 25 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //                             gen 2 gen 2 stale
+      // exercise
+      size_t erased = gs.erase(5);
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    | 15 |    | 25 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      assertUnit(erased == 1);
+      assertUnit(gs.size() == 1);
+      assertUnit(gs.slots[5].key == 15);
+      assertUnit(gs.filled(5));
+      assertUnit(!gs.filled(6));
+      assertUnit(!gs.filled(7));
+      assertUnit(gs.find(25) == gs.end());
+      assertUnit(gs.erase(25) == 0);
+   }  // teardown
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // only the current generation's keys are visited
+   void test_iterator_skipsStale()
+   {  // setup
+      custom::generation_unordered_set gs;
+      setupStandardFixture(gs);
+      gs.clear();
+      gs.insert(12);
+      gs.insert(99);
+      std::multiset<int> seen;
+      // exercise
+      for (custom::generation_unordered_set::iterator it = gs.begin(); it != gs.end(); ++it)
+         seen.insert(*it);
+      // verify
+      assertUnit(seen == std::multiset<int>({ 12, 99 }));
+   }  // teardown
+
+   /***************************************
+    * PERFORMANCE
+    ***************************************/
+
+   // clearing a table of millions of buckets costs no more than a few
+   void test_perf_clearLarge()
+   {  // setup
+      custom::generation_unordered_set gs;
+      gs.reserve(2000000);
+      auto setup = [](size_t) {};
+      auto clearAll = [&gs](size_t n)
+      {
+         for (size_t i = 0; i < n; i++)
+         {
+            gs.insert((int)i);
+            gs.clear();
+         }
+      };
+      // exercise
+      assertThroughput(setup, clearAll, 100000, 1.0e6);
+      // verify
+      assertUnit(gs.bucket_count() == 4000000);
+      assertUnit(gs.empty());
+   }  // teardown
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *    +----+----+----+----+----+----+----+----+----+----+
+    *    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+    *    +----+----+----+----+----+----+----+----+----+----+
+    *      0    1    2    3    4    5    6    7    8    9
+    *************************************************************/
+   void setupStandardFixture(custom::generation_unordered_set& gs)
+   {
+      gs.insert(31);
+      gs.insert(55);
+      gs.insert(67);
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE
+    *************************************************************/
+   void assertStandardFixtureParameters(const custom::generation_unordered_set& gs,
+                                        int line, const char* function)
+   {
+      assertIndirect(gs.numBuckets == 10);
+      assertIndirect(gs.numElements == 3);
+      for (size_t i = 0; i < 10; i++)
+         assertIndirect(gs.filled(i) == (i == 1 || i == 5 || i == 7));
+      assertIndirect(gs.slots[1].key == 31);
+      assertIndirect(gs.slots[5].key == 55);
+      assertIndirect(gs.slots[7].key == 67);
+   }
+};
+
+#endif // DEBUG
@@ -2,7 +2,8 @@
  * Header:
  *    Test
  * Summary:
- *    Driver to test hash.h
+ *    Driver to test hash.h, and a tool for deduplicating streams of
+ *    integer keys
  * Author
  *    Br. Helfrich
  ************************************************************************/
@@ -12,19 +13,390 @@
 #endif
  //#undef DEBUG  // Remove this comment to disable unit tests
 
-#include "testHash.h"       // for the hash unit tests
+#include "testHash.h"          // for the hash unit tests
+#include "testMultiset.h"      // for the multiset unit tests
+#include "testSimd.h"          // for the vectorized kernel unit tests
+#include "testCompactSet.h"    // for the compact set unit tests
+#include "testPersistentSet.h" // for the persistent set unit tests
+#include "testConcurrentSet.h" // for the concurrent set unit tests
+#include "testBoundedSet.h"    // for the bounded set unit tests
+#include "testKeyFile.h"       // for the key file unit tests
+#include "testExternalDedup.h" // for the external dedup unit tests
+#include "testHyperLogLog.h"   // for the distinct count estimator unit tests
+#include "testHashAnalysis.h"  // for the hash distribution analyzer unit tests
+#include "testGenerationSet.h" // for the generation set unit tests
+#include "testHugePages.h"     // for the huge page resource unit tests
+#include "testNumaSet.h"       // for the NUMA set unit tests
+#include "testLookupScheduler.h" // for the interleaved lookup unit tests
+
+#include "hash.h"              // for custom::unordered_set
+#include "keyFile.h"           // for key_reader and key_writer
+#include "externalSet.h"       // for external_dedup
+#include "hyperLogLog.h"       // for hyper_log_log
+#include "hashAnalysis.h"      // for hash_analyzer
+
+#include <cstdio>              // for std::fprintf
+#include <cstdlib>             // for std::strtoul
+#include <cstring>             // for std::strcmp
+#include <vector>              // for std::vector
+
+/**********************************************************************
+ * KEY SET
+ * The set the driver dedups through. unordered_set cannot hold
+ * HASH_EMPTY_VALUE, which marks its empty buckets, so that one key
+ * is kept on the side.
+ ***********************************************************************/
+struct KeySet
+{
+   custom::unordered_set set;
+   bool hasEmptyValue = false;
+
+   size_t size() const
+   {
+      return set.size() + (hasEmptyValue ? 1 : 0);
+   }
+
+   // add one key; true if it was not there before
+   bool insert(int key)
+   {
+      if (key == HASH_EMPTY_VALUE)
+      {
+         bool added = !hasEmptyValue;
+         hasEmptyValue = true;
+         return added;
+      }
+      size_t before = set.size();
+      set.insert(key);
+      return set.size() != before;
+   }
+
+   // add a batch of keys
+   void insert(const int* keys, size_t n)
+   {
+      int kept[HASH_BATCH_SIZE];
+      for (size_t first = 0; first < n; first += HASH_BATCH_SIZE)
+      {
+         size_t count = 0;
+         for (size_t i = first; i < n && i < first + HASH_BATCH_SIZE; ++i)
+         {
+            if (keys[i] == HASH_EMPTY_VALUE)
+               hasEmptyValue = true;
+            else
+               kept[count++] = keys[i];
+         }
+         set.insert_batch(kept, count);
+      }
+   }
+
+   // look up a batch of keys
+   void find(const int* keys, size_t n, bool* found)
+   {
+      set.find_batch(keys, n, found);
+      for (size_t i = 0; i < n; ++i)
+         if (keys[i] == HASH_EMPTY_VALUE)
+            found[i] = hasEmptyValue;
+   }
+};
+
+/**********************************************************************
+ * USAGE
+ ***********************************************************************/
+static int usage(const char* program)
+{
+   std::fprintf(stderr,
+      "usage: %s [-b] [-e MB] distinct [FILE]\n"
+      "       %s [-b] [-e MB] count    [FILE]\n"
+      "       %s [-b] estimate [FILE]\n"
+      "       %s [-b] [-m] probe BUILD [FILE]\n"
+      "       %s [-b] [-n BUCKETS] analyze [FILE]\n"
+      "\n"
+      "  distinct  write each key the first time it is seen\n"
+      "  count     write the number of keys and of distinct keys\n"
+      "  estimate  count, with the distinct keys estimated to within about\n"
+      "            1%% in a few kilobytes of memory\n"
+      "  probe     load BUILD, then write each key of FILE followed by\n"
+      "            1 if BUILD has it and 0 if not\n"
+      "  analyze   report how evenly each candidate hash spreads the\n"
+      "            distinct keys, and what a lookup would cost\n"
+      "\n"
+      "  -b        keys are binary 32-bit ints instead of text\n"
+      "  -m        probe writes only the keys BUILD has, without 1 or 0\n"
+      "  -n N      analyze with N buckets instead of as many as\n"
+      "            unordered_set would grow to\n"
+      "  -e MB     dedup in at most about MB megabytes of memory, spilling\n"
+      "            to temporary files past that; distinct then writes the\n"
+      "            keys at the end, not as they are first seen\n"
+      "\n"
+      "FILE defaults to standard input, as does -. With no arguments\n"
+      "the unit tests are run instead.\n",
+      program, program, program, program, program);
+   return 2;
+}
+
+/**********************************************************************
+ * OPENED
+ * Whether reader has something to read; if not, say so
+ ***********************************************************************/
+static bool opened(custom::key_reader& reader, const char* path)
+{
+   if (reader.is_open())
+      return true;
+   std::fprintf(stderr, "cannot open %s\n", path);
+   return false;
+}
+
+/**********************************************************************
+ * DISTINCT
+ * Stream the keys through the set, writing each one that is new
+ ***********************************************************************/
+static void distinct(custom::key_reader& reader, custom::key_writer& writer)
+{
+   KeySet keys;
+   int batch[HASH_BATCH_SIZE];
+   for (size_t n; (n = reader.read(batch, HASH_BATCH_SIZE)) != 0; )
+      for (size_t i = 0; i < n; ++i)
+         if (keys.insert(batch[i]))
+            writer.write(batch[i]);
+}
+
+/**********************************************************************
+ * COUNT
+ * The number of keys read and the number of distinct keys
+ ***********************************************************************/
+static void count(custom::key_reader& reader)
+{
+   KeySet keys;
+   size_t total = 0;
+   int batch[HASH_BATCH_SIZE];
+   for (size_t n; (n = reader.read(batch, HASH_BATCH_SIZE)) != 0; )
+   {
+      total += n;
+      keys.insert(batch, n);
+   }
+   std::printf("%zu %zu\n", total, keys.size());
+}
+
+/**********************************************************************
+ * ESTIMATE
+ * The number of keys read and an estimate of the distinct keys,
+ * without keeping any of them
+ ***********************************************************************/
+static void estimate(custom::key_reader& reader)
+{
+   custom::hyper_log_log sketch;
+   size_t total = 0;
+   int batch[HASH_BATCH_SIZE];
+   for (size_t n; (n = reader.read(batch, HASH_BATCH_SIZE)) != 0; )
+   {
+      total += n;
+      sketch.insert_batch(batch, n);
+   }
+   std::printf("%zu %zu\n", total, sketch.count());
+}
+
+/**********************************************************************
+ * EXTERNAL
+ * distinct or count for streams whose distinct keys may not fit in
+ * memory
+ ***********************************************************************/
+static void external(custom::key_reader& reader, custom::key_writer& writer,
+                     size_t budget, bool writeKeys)
+{
+   custom::external_dedup dedup(budget);
+   size_t total = 0;
+   int batch[HASH_BATCH_SIZE];
+   for (size_t n; (n = reader.read(batch, HASH_BATCH_SIZE)) != 0; )
+   {
+      total += n;
+      dedup.insert_batch(batch, n);
+   }
+
+   if (writeKeys)
+      dedup.for_each_distinct([&writer](int key) { writer.write(key); });
+   else
+      std::printf("%zu %zu\n", total, dedup.for_each_distinct([](int) {}));
+}
+
+/**********************************************************************
+ * PROBE
+ * Load every key of build, then look up each key of probe in it: the
+ * probe side of a hash join
+ ***********************************************************************/
+static void probe(custom::key_reader& build, custom::key_reader& lookups,
+                  custom::key_writer& writer, bool matchesOnly)
+{
+   KeySet keys;
+   int batch[HASH_BATCH_SIZE];
+   for (size_t n; (n = build.read(batch, HASH_BATCH_SIZE)) != 0; )
+      keys.insert(batch, n);
+
+   bool found[HASH_BATCH_SIZE];
+   for (size_t n; (n = lookups.read(batch, HASH_BATCH_SIZE)) != 0; )
+   {
+      keys.find(batch, n, found);
+      for (size_t i = 0; i < n; ++i)
+      {
+         if (matchesOnly)
+         {
+            if (found[i])
+               writer.write(batch[i]);
+         }
+         else
+            writer.write(batch[i], found[i] ? "\t1" : "\t0");
+      }
+   }
+}
+
+/**********************************************************************
+ * ANALYZE
+ * Load every key, then compare how each candidate hash lays them out
+ ***********************************************************************/
+static void analyze(custom::key_reader& reader, size_t numBuckets)
+{
+   std::vector<int> keys;
+   int batch[HASH_BATCH_SIZE];
+   for (size_t n; (n = reader.read(batch, HASH_BATCH_SIZE)) != 0; )
+      keys.insert(keys.end(), batch, batch + n);
+
+   custom::hash_analyzer analyzer(keys.data(), keys.size());
+   if (numBuckets == 0)
+      numBuckets = analyzer.default_buckets();
+   if (numBuckets <= analyzer.size())
+   {
+      std::fprintf(stderr, "%zu distinct keys need more than %zu buckets\n",
+                   analyzer.size(), numBuckets);
+      return;
+   }
+
+   std::printf("%zu keys, %zu distinct, %zu buckets\n",
+               keys.size(), analyzer.size(), numBuckets);
+   std::printf("%-10s %10s %9s %9s %10s %11s %9s %9s\n", "policy", "variance",
+               "max home", "max probe", "hit probes", "miss probes", "avalanche", "bias");
+   for (int p = 0; p < custom::hash_analyzer::NUM_POLICIES; ++p)
+   {
+      custom::hash_analyzer::report r =
+         analyzer.analyze((custom::hash_analyzer::policy)p, numBuckets);
+      std::printf("%-10s %10.4f %9zu %9zu %10.3f %11.3f %9.3f %9.3f\n",
+                  custom::hash_analyzer::name(r.hasher), r.variance, r.maxHome,
+                  r.maxProbe, r.hitProbes, r.missProbes, r.avalanche, r.avalancheBias);
+   }
+}
 
 /**********************************************************************
  * MAIN
- * This is just a simple menu to launch a collection of tests
+ * With no arguments, run the unit tests. Otherwise this is a tool
+ * for deduplicating streams of integer keys.
  ***********************************************************************/
-int main()
+int main(int argc, char* argv[])
 {
+   if (argc == 1)
+   {
 #ifdef DEBUG
-   // unit tests
-   TestHash().run();
+      // unit tests
+      TestHash().run();
+      TestMultiset().run();
+      TestSimd().run();
+      TestCompactSet().run();
+      TestPersistentSet().run();
+      TestConcurrentSet().run();
+      TestBoundedSet().run();
+      TestKeyFile().run();
+      TestExternalDedup().run();
+      TestHyperLogLog().run();
+      TestHashAnalysis().run();
+      TestGenerationSet().run();
+      TestHugePages().run();
+      TestNumaSet().run();
+#ifdef HASH_HAVE_COROUTINES
+      TestLookupScheduler().run();
+#endif // HASH_HAVE_COROUTINES
 #endif // DEBUG
-   
+      return 0;
+   }
+
    // driver
+   custom::key_reader::format format = custom::key_reader::TEXT;
+   bool matchesOnly = false;
+   size_t budget = 0;
+   size_t numBuckets = 0;
+   int arg = 1;
+   for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0'; ++arg)
+   {
+      if (std::strcmp(argv[arg], "-b") == 0)
+         format = custom::key_reader::BINARY;
+      else if (std::strcmp(argv[arg], "-m") == 0)
+         matchesOnly = true;
+      else if (std::strcmp(argv[arg], "-n") == 0 && arg + 1 < argc &&
+               (numBuckets = std::strtoul(argv[arg + 1], nullptr, 10)) != 0)
+         ++arg;
+      else if (std::strcmp(argv[arg], "-e") == 0 && arg + 1 < argc &&
+               (budget = std::strtoul(argv[arg + 1], nullptr, 10) << 20) != 0)
+         ++arg;
+      else
+         return usage(argv[0]);
+   }
+   if (arg == argc)
+      return usage(argv[0]);
+
+   const char* mode = argv[arg++];
+   const char* files[2] = { "-", "-" };
+   int numFiles = argc - arg;
+   for (int i = 0; i < numFiles && i < 2; ++i)
+      files[i] = argv[arg + i];
+
+   custom::key_writer writer(stdout);
+   size_t skipped = 0;
+   if (std::strcmp(mode, "distinct") == 0 && numFiles <= 1)
+   {
+      custom::key_reader reader(files[0], format);
+      if (!opened(reader, files[0]))
+         return 1;
+      if (budget)
+         external(reader, writer, budget, true);
+      else
+         distinct(reader, writer);
+      skipped = reader.skipped();
+   }
+   else if (std::strcmp(mode, "count") == 0 && numFiles <= 1)
+   {
+      custom::key_reader reader(files[0], format);
+      if (!opened(reader, files[0]))
+         return 1;
+      if (budget)
+         external(reader, writer, budget, false);
+      else
+         count(reader);
+      skipped = reader.skipped();
+   }
+   else if (std::strcmp(mode, "estimate") == 0 && numFiles <= 1)
+   {
+      custom::key_reader reader(files[0], format);
+      if (!opened(reader, files[0]))
+         return 1;
+      estimate(reader);
+      skipped = reader.skipped();
+   }
+   else if (std::strcmp(mode, "probe") == 0 && numFiles >= 1 && numFiles <= 2)
+   {
+      custom::key_reader build(files[0], format);
+      custom::key_reader keys(files[1], format);
+      if (!opened(build, files[0]) || !opened(keys, files[1]))
+         return 1;
+      probe(build, keys, writer, matchesOnly);
+      skipped = build.skipped() + keys.skipped();
+   }
+   else if (std::strcmp(mode, "analyze") == 0 && numFiles <= 1)
+   {
+      custom::key_reader reader(files[0], format);
+      if (!opened(reader, files[0]))
+         return 1;
+      analyze(reader, numBuckets);
+      skipped = reader.skipped();
+   }
+   else
+      return usage(argv[0]);
+
+   if (skipped)
+      std::fprintf(stderr, "skipped %zu values that are not 32-bit keys\n", skipped);
    return 0;
 }
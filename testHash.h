@@ -15,13 +15,54 @@
 #include "unitTest.h"
 
 #include <cassert>
+#include <cstring>
 #include <memory>
 #include <functional>
 #include <vector>
+#include <random>
+#include <algorithm>
+#include <memory_resource>
+#include <type_traits>
 
 using std::cout;
 using std::endl;
 
+// builds a set in raw storage; std::allocator::construct is gone in C++20
+typedef std::allocator_traits<std::allocator<custom::unordered_set>> SetTraits;
+
+
+/*************************************************************
+ * COUNTING RESOURCE
+ * Hands out heap memory and keeps track of how much is still out.
+ * Once limit allocations have been made, the next ones throw.
+ *************************************************************/
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+   size_t allocations = 0;
+   size_t outstanding = 0;
+   size_t limit = SIZE_MAX;
+
+private:
+   void* do_allocate(size_t bytes, size_t alignment) override
+   {
+      if (allocations == limit)
+         throw std::bad_alloc();
+      allocations++;
+      outstanding += bytes;
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+   }
+   void do_deallocate(void* p, size_t bytes, size_t alignment) override
+   {
+      outstanding -= bytes;
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+   }
+   bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+   {
+      return this == &other;
+   }
+};
+
 
 class TestHash : public UnitTest
 {
@@ -34,19 +75,39 @@ public:
       // Construct
       test_construct_default();
       test_constructIterator_standard();
+      test_constructEstimate_standard();
+      test_constructEstimate_sizedOnce();
+      test_construct_arena();
+      test_construct_returnsEverything();
       test_constructCopy_empty();
       test_constructCopy_standard();
+      test_constructCopy_shares();
+      test_constructCopy_insertDetaches();
+      test_constructCopy_duplicateShares();
+      test_constructCopy_eraseDetaches();
+      test_constructCopy_clearDetaches();
+      test_constructCopy_growDetaches();
+      test_constructCopy_outlives();
+      test_constructCopy_otherResource();
+      test_constructCopy_allocatesNothing();
 
       // Assign
       test_assign_emptyEmpty();
       test_assign_emptyStandard();
       test_assign_standardEmpty();
+      test_assign_otherResourceFails();
       test_assignMove_emptyEmpty();
       test_assignMove_emptyStandard();
       test_assignMove_standardEmpty();
+      test_assignMove_otherResource();
+      test_assignMove_steals();
+      test_constructMove_steals();
+      test_movedFrom_usable();
+      test_movedFrom_vector();
       test_swapMember_emptyEmpty();
       test_swapMember_standardEmpty();
       test_swapMember_standardOther();
+      test_swapMember_resource();
       test_swapNonMember_emptyEmpty();
       test_swapNonMember_standardEmpty();
       test_swapNonMember_standardOther();
@@ -61,6 +122,7 @@ public:
       test_iterator_increment_nextBucket();
       test_iterator_increment_toEnd();
       test_iterator_dereference();
+      test_iterator_dereferenceConst();
 
       // Access
       test_bucket_empty0();
@@ -71,13 +133,20 @@ public:
       test_find_standardBack();
       test_find_standardMissingEmptyList();
       test_find_standardMissingFilledList();
+      test_hashBatch_standard();
+      test_findBatch_standard();
+      test_hashFunction_bucket();
+      test_find_precomputedHash();
 
       // Insert
       test_insert_emptyTrivial();
       test_insert_emptyValue();
       test_insert_standardNew();
-      test_insert_standardReplace();
+      test_insert_standardCollision();
       test_insert_standardDuplicate();
+      test_insertBatch_empty();
+      test_insertBatch_grow();
+      test_insert_precomputedHash();
 
       // Remove
       test_clear_empty();
@@ -86,6 +155,14 @@ public:
       test_erase_standardMissing();
       test_erase_standardAlone();
       test_erase_standardLast();
+      test_erase_precomputedHash();
+      test_erase_iteratorStandard();
+      test_erase_iteratorShift();
+      test_erase_rangeAll();
+      test_erase_rangeMiddle();
+      test_eraseIf_standard();
+      test_eraseIf_cluster();
+      test_eraseIf_large();
 
       // Status
       test_size_empty();
@@ -95,6 +172,43 @@ public:
       test_bucketSize_empty();
       test_bucketSize_standardEmpty();
       test_bucketSize_standardOne();
+      test_bucketSize_wrapped();
+      test_bucketSize_erase();
+      test_bucketSize_grow();
+      test_localIterator_standardEmpty();
+      test_localIterator_standardOne();
+      test_localIterator_wrapped();
+
+      // Sizing
+      test_shrinkToFit_drained();
+      test_shrinkToFit_empty();
+      test_minLoadFactor_off();
+      test_minLoadFactor_shrinks();
+      test_minLoadFactor_hysteresis();
+      test_minLoadFactor_eraseIf();
+      test_minLoadFactor_iteratorLoop();
+      test_minLoadFactor_eraseReturnsNext();
+
+      // Memory
+      test_memoryUsage_empty();
+      test_memoryUsage_standard();
+      test_memoryUsage_shrink();
+      test_totalMemoryUsage_live();
+      test_totalMemoryUsage_destroyed();
+
+      // Performance
+      test_perf_insertScales();
+      test_perf_findScales();
+      test_perf_eraseScales();
+      test_perf_denseNegativeScales();
+      test_perf_insertThroughput();
+
+      // Large
+      test_large_insert100k();
+      test_large_insert1m();
+      test_large_insert2m();
+      test_large_eraseHalf();
+      test_large_iterate();
 
       report("Hash");
    }
@@ -107,27 +221,47 @@ public:
    void test_construct_default()
    {  // setup
       std::allocator<custom::unordered_set> alloc;
-      custom::unordered_set us;
-      us.numElements = 99;
+      custom::unordered_set* pUs = alloc.allocate(1);
+      std::memset(static_cast<void*>(pUs), 99, sizeof(custom::unordered_set));
       // exercise
-      alloc.construct(&us);
+      SetTraits::construct(alloc, pUs);
       // verify
       //    +----+----+----+----+----+----+----+----+----+----+
       //    |    |    |    |    |    |    |    |    |    |    |
       //    +----+----+----+----+----+----+----+----+----+----+
       //      0    1    2    3    4    5    6    7    8    9
-      assertEmptyFixture(us);
-   }  // teardown
+      assertEmptyFixture(*pUs);
+      // teardown
+      SetTraits::destroy(alloc, pUs);
+      alloc.deallocate(pUs, 1);
+   }
 
    // create an unordered set from a vector iterator
    void test_constructIterator_standard()
    {  // setup
       std::vector<int> v{55, 67, 31};
       std::allocator<custom::unordered_set> alloc;
-      custom::unordered_set us;
-      us.numElements = 99;
+      custom::unordered_set* pUs = alloc.allocate(1);
+      std::memset(static_cast<void*>(pUs), 99, sizeof(custom::unordered_set));
+      // exercise
+      SetTraits::construct(alloc, pUs, v.begin(), v.end());
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertStandardFixture(*pUs);
+      // teardown
+      SetTraits::destroy(alloc, pUs);
+      alloc.deallocate(pUs, 1);
+   }
+
+   // a few keys fit the ten buckets, so estimating changes nothing
+   void test_constructEstimate_standard()
+   {  // setup
+      std::vector<int> v{55, 67, 31, 55};
       // exercise
-      alloc.construct(&us, v.begin(), v.end());
+      custom::unordered_set us(v.begin(), v.end(), custom::estimate_distinct);
       // verify
       //    +----+----+----+----+----+----+----+----+----+----+
       //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
@@ -136,6 +270,59 @@ public:
       assertStandardFixture(us);
    }  // teardown
 
+   // many keys: the buckets are sized from the estimate and never doubled
+   void test_constructEstimate_sizedOnce()
+   {  // setup
+      std::vector<int> v;
+      for (int i = 0; i < 200000; i++)
+         v.push_back((i * 7919) % 50000);
+      custom::hyper_log_log sketch(v.begin(), v.end());
+      size_t expected = (size_t)std::ceil((double)sketch.upper_bound() / 0.5);
+      // exercise
+      custom::unordered_set us(v.begin(), v.end(), custom::estimate_distinct);
+      // verify
+      assertUnit(us.size() == 50000);
+      assertUnit(us.bucket_count() == expected);
+      for (int i = 0; i < 50000; i++)
+         assertUnit(us.find(i) != us.end());
+   }  // teardown
+
+   // every table, including the ones outgrown, comes from the arena
+   void test_construct_arena()
+   {  // setup
+      static char buffer[1 << 16];
+      std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                                std::pmr::null_memory_resource());
+      // exercise
+      custom::unordered_set us(&arena);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      // verify
+      assertUnit(us.get_allocator().resource() == &arena);
+      assertUnit(us.size() == 1000);
+      assertUnit((char*)us.buckets >= buffer);
+      assertUnit((char*)(us.buckets + us.numBuckets) <= buffer + sizeof(buffer));
+   }  // teardown
+
+   // each table goes back to the resource it came from, whole
+   void test_construct_returnsEverything()
+   {  // setup
+      CountingResource counter;
+      {
+         custom::unordered_set us(&counter);
+         // exercise
+         for (int i = 0; i < 1000; i++)
+            us.insert(i);
+         us = { 55, 67, 31 };
+         custom::unordered_set copy(us, &counter);
+         copy.rehash(100);
+         // verify
+         assertUnit(counter.outstanding > 0);
+      }
+      assertUnit(counter.outstanding == 0);
+      assertUnit(counter.allocations > 2);
+   }  // teardown
+
    // copy an empty unordered set
    void test_constructCopy_empty()
    {  // setup
@@ -145,19 +332,22 @@ public:
       //    +----+----+----+----+----+----+----+----+----+----+
       //      0    1    2    3    4    5    6    7    8    9
       custom::unordered_set usSrc;
-      custom::unordered_set usDes;
       std::allocator<custom::unordered_set> alloc;
-      usDes.numElements = 99;
+      custom::unordered_set* pUsDes = alloc.allocate(1);
+      std::memset(static_cast<void*>(pUsDes), 99, sizeof(custom::unordered_set));
       // exercise
-      alloc.construct(&usDes, usSrc);
+      SetTraits::construct(alloc, pUsDes, usSrc);
       // verify
       //    +----+----+----+----+----+----+----+----+----+----+
       //    |    |    |    |    |    |    |    |    |    |    |
       //    +----+----+----+----+----+----+----+----+----+----+
       //      0    1    2    3    4    5    6    7    8    9
       assertEmptyFixture(usSrc);
-      assertEmptyFixture(usDes);
-   }  // teardown
+      assertEmptyFixture(*pUsDes);
+      // teardown
+      SetTraits::destroy(alloc, pUsDes);
+      alloc.deallocate(pUsDes, 1);
+   }
 
    // copy a standard set
    void test_constructCopy_standard()
@@ -179,6 +369,202 @@ public:
       assertStandardFixture(usDes);
    }  // teardown
 
+   // a copy shares the table rather than copying it
+   void test_constructCopy_shares()
+   {  // setup
+      custom::unordered_set usSrc;
+      for (int i = 0; i < 100000; i++)
+         usSrc.insert(i);
+      size_t tables = custom::unordered_set::total_memory_usage().keys;
+      // exercise
+      custom::unordered_set usDes(usSrc);
+      // verify
+      assertUnit(usDes.buckets == usSrc.buckets);
+      assertUnit(owners(usSrc) == 2);
+      assertUnit(usDes.size() == 100000);
+      assertUnit(usDes.find(99999) != usDes.end());
+      assertUnit(custom::unordered_set::total_memory_usage().keys == tables);
+   }  // teardown
+
+   // the first insert into a copy takes a table of its own
+   void test_constructCopy_insertDetaches()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set usSrc;
+      setupStandardFixture(usSrc);
+      custom::unordered_set usDes(usSrc);
+      // exercise
+      usDes.insert(49);
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    | 49 |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(usDes.buckets != usSrc.buckets);
+      assertUnit(owners(usSrc) == 1);
+      assertUnit(owners(usDes) == 1);
+      assertUnit(usDes.buckets[9] == 49);
+      assertUnit(usDes.bucket_size(9) == 1);
+      assertUnit(usDes.size() == 4);
+      assertStandardFixture(usSrc);
+   }  // teardown
+
+   // inserting what is already there writes nothing, so shares still
+   void test_constructCopy_duplicateShares()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set usSrc;
+      setupStandardFixture(usSrc);
+      custom::unordered_set usDes(usSrc);
+      // exercise
+      usDes.insert(55);
+      usDes.erase(49);
+      // verify
+      assertUnit(usDes.buckets == usSrc.buckets);
+      assertUnit(owners(usSrc) == 2);
+      assertStandardFixture(usDes);
+   }  // teardown
+
+   // erasing from the original leaves the copy as it was
+   void test_constructCopy_eraseDetaches()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set usSrc;
+      setupStandardFixture(usSrc);
+      custom::unordered_set usDes(usSrc);
+      // exercise
+      usSrc.erase(55);
+      erase_if(usDes, [](const int& key) { return key == 31; });
+      // verify
+      assertUnit(usSrc.buckets[5] == HASH_EMPTY_VALUE);
+      assertUnit(usSrc.buckets[1] == 31);
+      assertUnit(usDes.buckets[1] == HASH_EMPTY_VALUE);
+      assertUnit(usDes.buckets[5] == 55);
+      assertUnit(usSrc.size() == 2);
+      assertUnit(usDes.size() == 2);
+   }  // teardown
+
+   // clearing a copy hands it the empty table, allocating nothing,
+   // and leaves the rest alone
+   void test_constructCopy_clearDetaches()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set usSrc;
+      setupStandardFixture(usSrc);
+      custom::unordered_set usDes(usSrc);
+      // exercise
+      usDes.clear();
+      // verify
+      assertEmptyFixture(usDes);
+      assertStandardFixture(usSrc);
+      assertUnit(usDes.buckets == custom::unordered_set::emptyTable.keys);
+      assertUnit(noexcept(usDes.clear()));
+      assertUnit(owners(usSrc) == 1);
+   }  // teardown
+
+   // growing a copy builds a new table from the shared one
+   void test_constructCopy_growDetaches()
+   {  // setup
+      custom::unordered_set usSrc;
+      usSrc.insert({ 31, 55, 67, 49, 0 });
+      custom::unordered_set usDes(usSrc);
+      // exercise
+      usDes.insert(1);
+      // verify
+      assertUnit(usDes.bucket_count() > 10);
+      assertUnit(usSrc.bucket_count() == 10);
+      assertUnit(owners(usSrc) == 1);
+      assertUnit(usSrc.size() == 5);
+      assertUnit(usSrc.find(1) == usSrc.end());
+      assertUnit(usDes.size() == 6);
+      assertUnit(usDes.find(1) != usDes.end());
+   }  // teardown
+
+   // the table stays as long as any set holds it
+   void test_constructCopy_outlives()
+   {  // setup
+      custom::unordered_set* pSrc = new custom::unordered_set;
+      setupStandardFixture(*pSrc);
+      custom::unordered_set usDes(*pSrc);
+      // exercise
+      delete pSrc;
+      // verify
+      assertUnit(owners(usDes) == 1);
+      assertStandardFixture(usDes);
+   }  // teardown
+
+   // a copy into another resource cannot share, so it copies
+   void test_constructCopy_otherResource()
+   {  // setup
+      CountingResource counter;
+      custom::unordered_set usSrc;
+      setupStandardFixture(usSrc);
+      // exercise
+      custom::unordered_set usDes(usSrc, &counter);
+      // verify
+      assertUnit(usDes.buckets != usSrc.buckets);
+      assertUnit(owners(usSrc) == 1);
+      assertUnit(counter.outstanding > 0);
+      assertStandardFixture(usDes);
+   }  // teardown
+
+   // a copy that cannot get its buckets leaves the destination as it was
+   void test_assign_otherResourceFails()
+   {  // setup
+      CountingResource counter;
+      custom::unordered_set usSrc;
+      for (int i = 0; i < 1000; i++)
+         usSrc.insert(i);
+      custom::unordered_set usDes(&counter);
+      setupStandardFixture(usDes);
+      counter.limit = counter.allocations;
+      bool threw = false;
+      // exercise
+      try
+      {
+         usDes = usSrc;
+      }
+      catch (const std::bad_alloc&)
+      {
+         threw = true;
+      }
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(threw);
+      assertStandardFixture(usDes);
+      assertUnit(usSrc.size() == 1000);
+   }  // teardown
+
+   // a copy that shares never allocates a table just to free it
+   void test_constructCopy_allocatesNothing()
+   {  // setup
+      CountingResource counter;
+      custom::unordered_set usSrc(&counter);
+      setupStandardFixture(usSrc);
+      size_t allocations = counter.allocations;
+      // exercise
+      custom::unordered_set usDes(usSrc, &counter);
+      // verify
+      assertUnit(counter.allocations == allocations);
+      assertUnit(usDes.buckets == usSrc.buckets);
+      assertStandardFixture(usDes);
+   }  // teardown
+
    /***************************************
     * ASSIGN
     ***************************************/
@@ -328,6 +714,104 @@ public:
       assertStandardFixture(usDes);
       // teardown
    }
+
+   // moving between resources copies: a set keeps its resource for life
+   void test_assignMove_otherResource()
+   {  // setup
+      CountingResource counter;
+      {
+         custom::unordered_set usSrc;
+         setupStandardFixture(usSrc);
+         custom::unordered_set usDes(&counter);
+         // exercise
+         usDes = std::move(usSrc);
+         // verify
+         assertUnit(usDes.get_allocator().resource() == &counter);
+         assertUnit(usSrc.get_allocator().resource() == std::pmr::get_default_resource());
+         assertStandardFixture(usDes);
+         assertUnit(usSrc.numElements == 0);
+      }
+      assertUnit(counter.outstanding == 0);
+   }  // teardown
+
+   // move assignment takes the table itself and allocates nothing
+   void test_assignMove_steals()
+   {  // setup
+      CountingResource counter;
+      custom::unordered_set usSrc(&counter);
+      for (int i = 0; i < 1000; i++)
+         usSrc.insert(i);
+      custom::unordered_set usDes(&counter);
+      int* table = usSrc.buckets;
+      size_t allocations = counter.allocations;
+      // exercise
+      usDes = std::move(usSrc);
+      // verify
+      assertUnit(usDes.buckets == table);
+      assertUnit(usDes.size() == 1000);
+      assertUnit(counter.allocations == allocations);
+      assertUnit(usSrc.buckets == custom::unordered_set::emptyTable.keys);
+      assertUnit(usSrc.memory_usage().keys == 0);
+      assertEmptyFixture(usSrc);
+   }  // teardown
+
+   // move construction takes the table too, and the resource with it
+   void test_constructMove_steals()
+   {  // setup
+      CountingResource counter;
+      custom::unordered_set usSrc(&counter);
+      setupStandardFixture(usSrc);
+      int* table = usSrc.buckets;
+      size_t allocations = counter.allocations;
+      // exercise
+      custom::unordered_set usDes(std::move(usSrc));
+      // verify
+      assertUnit(usDes.buckets == table);
+      assertUnit(usDes.get_allocator().resource() == &counter);
+      assertUnit(counter.allocations == allocations);
+      assertStandardFixture(usDes);
+      assertEmptyFixture(usSrc);
+   }  // teardown
+
+   // a moved-from set works as an empty one, and first allocates on insert
+   void test_movedFrom_usable()
+   {  // setup
+      CountingResource counter;
+      custom::unordered_set usSrc(&counter);
+      setupStandardFixture(usSrc);
+      custom::unordered_set usDes(std::move(usSrc));
+      size_t allocations = counter.allocations;
+      // exercise
+      bool missing = (usSrc.find(31) == usSrc.end());
+      usSrc.clear();
+      size_t erased = erase_if(usSrc, [](const int&) { return true; });
+      usSrc.insert(49);
+      // verify
+      assertUnit(missing);
+      assertUnit(erased == 0);
+      assertUnit(counter.allocations == allocations + 1);
+      assertUnit(usSrc.size() == 1);
+      assertUnit(usSrc.buckets[9] == 49);
+      assertUnit(custom::unordered_set::emptyTable.keys[9] == HASH_EMPTY_VALUE);
+      assertStandardFixture(usDes);
+   }  // teardown
+
+   // a vector of sets relocates them without copying a bucket
+   void test_movedFrom_vector()
+   {  // setup
+      CountingResource counter;
+      std::vector<custom::unordered_set> sets;
+      // exercise
+      for (int i = 0; i < 100; i++)
+      {
+         sets.emplace_back(&counter);
+         sets.back().insert(i);
+      }
+      // verify
+      assertUnit(counter.allocations == 100);
+      for (int i = 0; i < 100; i++)
+         assertUnit(sets[i].size() == 1 && sets[i].find(i) != sets[i].end());
+   }  // teardown
    
    // swap empty hashes use member swap
    void test_swapMember_emptyEmpty()
@@ -397,6 +881,8 @@ public:
       us2.buckets[4] = 24;
       us2.buckets[7] = 27;
       us2.buckets[8] = 28;
+      for (size_t i : { 0, 3, 4, 7, 8 })
+         us2.homeCounts()[i] = 1;
       us2.numElements = 5;
       // exercise
       us1.swap(us2);
@@ -424,6 +910,24 @@ public:
       assertStandardFixture(us2);
    }  // teardown
    
+   // the resource goes along with the table it allocated
+   void test_swapMember_resource()
+   {  // setup
+      CountingResource counter;
+      {
+         custom::unordered_set us1(&counter);
+         setupStandardFixture(us1);
+         custom::unordered_set us2;
+         // exercise
+         us1.swap(us2);
+         // verify
+         assertUnit(us2.get_allocator().resource() == &counter);
+         assertUnit(us1.get_allocator().resource() == std::pmr::get_default_resource());
+         assertStandardFixture(us2);
+      }
+      assertUnit(counter.outstanding == 0);
+   }  // teardown
+
    // swap empty hashs using non-member swap
    void test_swapNonMember_emptyEmpty()
    {  // setup
@@ -492,6 +996,8 @@ public:
       us2.buckets[4] = 24;
       us2.buckets[7] = 27;
       us2.buckets[8] = 28;
+      for (size_t i : { 0, 3, 4, 7, 8 })
+         us2.homeCounts()[i] = 1;
       us2.numElements = 5;
       // exercise
       swap(us1, us2);
@@ -716,6 +1222,24 @@ public:
       assertStandardFixture(us);
       // teardown
    }
+
+   // keys are read-only through an iterator, so no one can write
+   // through it into a table a copy still shares
+   void test_iterator_dereferenceConst()
+   {  // setup
+      custom::unordered_set usSrc;
+      setupStandardFixture(usSrc);
+      custom::unordered_set usDes(usSrc);
+      // exercise
+      custom::unordered_set::iterator it = usDes.find(55);
+      custom::unordered_set::local_iterator itLocal = usDes.begin(5);
+      // verify
+      assertUnit((std::is_same<decltype(*it), const int&>::value));
+      assertUnit((std::is_same<decltype(*itLocal), const int&>::value));
+      assertUnit(*it == 55);
+      assertUnit(*itLocal == 55);
+      assertUnit(owners(usSrc) == 2);
+   }  // teardown
    
 
    /***************************************
@@ -905,6 +1429,82 @@ public:
       assertStandardFixture(us);
    }
 
+   // hash an array of keys at once, matching bucket()
+   void test_hashBatch_standard()
+   {  // setup
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      int keys[5] = { 31, 55, 67, -58, 0 };
+      uint32_t homes[5] = { 99, 99, 99, 99, 99 };
+      // exercise
+      us.hash_batch(keys, 5, homes);
+      // verify
+      assertUnit(homes[0] == 1);
+      assertUnit(homes[1] == 5);
+      assertUnit(homes[2] == 7);
+      assertUnit(homes[3] == 8);
+      assertUnit(homes[4] == 0);
+      assertStandardFixture(us);
+   }  // teardown
+
+   // look up an array of keys, some there and some not
+   void test_findBatch_standard()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      int keys[5] = { 31, 41, 55, 77, 67 };
+      bool found[5] = { false, true, false, true, false };
+      // exercise
+      size_t count = us.find_batch(keys, 5, found);
+      // verify
+      assertUnit(count == 3);
+      assertUnit(found[0] == true);
+      assertUnit(found[1] == false);
+      assertUnit(found[2] == true);
+      assertUnit(found[3] == false);
+      assertUnit(found[4] == true);
+      assertStandardFixture(us);
+   }  // teardown
+
+   // the bucket is the hash modulo the bucket count
+   void test_hashFunction_bucket()
+   {  // setup
+      custom::unordered_set us;
+      custom::unordered_set::hasher hash = us.hash_function();
+      // exercise and verify
+      assertUnit(hash(58) == 58);
+      assertUnit(hash(-58) == 58);
+      for (int key = -100; key <= 100; key += 7)
+         assertUnit(us.bucket(key) == hash(key) % us.bucket_count());
+   }  // teardown
+
+   // one hash serves sets of any size
+   void test_find_precomputedHash()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      custom::unordered_set usLarge;
+      usLarge.rehash(40);
+      usLarge.insert(67);
+      size_t hash = us.hash_function()(67);
+      // exercise
+      custom::unordered_set::iterator it = us.find(67, hash);
+      custom::unordered_set::iterator itLarge = usLarge.find(67, hash);
+      // verify
+      assertUnit(it.pBucket == us.buckets + 7);
+      assertUnit(itLarge.pBucket == usLarge.buckets + 27);
+      assertUnit(us.find(77, us.hash_function()(77)) == us.end());
+      assertStandardFixture(us);
+   }  // teardown
+
    /***************************************
     * INSERT
     ***************************************/
@@ -1015,8 +1615,8 @@ public:
       assertUnit(it.pBucketEnd == us.buckets + 10);
    }  // teardown
    
-   // test that we can insert 7 into the standard hash
-   void test_insert_standardReplace()
+   // test that inserting 77 probes past 67 instead of replacing it
+   void test_insert_standardCollision()
    {  // setup
       //      it
       //    +----+----+----+----+----+----+----+----+----+----+
@@ -1029,14 +1629,14 @@ public:
       it.pBucket = us.buckets;
       it.pBucketEnd = us.buckets + 10;
       // exercise
-      it = us.insert(77);  // 77 % 10 == 7
+      it = us.insert(77);  // 77 % 10 == 7, which is taken
       // verify
-      //                                         it
+      //                                              it
       //    +----+----+----+----+----+----+----+----+----+----+
-      //    |    | 31 |    |    |    | 55 |    | 77 |    |    |
+      //    |    | 31 |    |    |    | 55 |    | 67 | 77 |    |
       //    +----+----+----+----+----+----+----+----+----+----+
       //      0    1    2    3    4    5    6    7    8    9
-      assertUnit(us.numElements == 3);
+      assertUnit(us.numElements == 4);
       assertUnit(us.buckets[0] == HASH_EMPTY_VALUE);
       assertUnit(us.buckets[1] == 31); 
       assertUnit(us.buckets[2] == HASH_EMPTY_VALUE);
@@ -1044,10 +1644,10 @@ public:
       assertUnit(us.buckets[4] == HASH_EMPTY_VALUE);
       assertUnit(us.buckets[5] == 55);
       assertUnit(us.buckets[6] == HASH_EMPTY_VALUE);
-      assertUnit(us.buckets[7] == 77); 
-      assertUnit(us.buckets[8] == HASH_EMPTY_VALUE);
+      assertUnit(us.buckets[7] == 67); 
+      assertUnit(us.buckets[8] == 77);
       assertUnit(us.buckets[9] == HASH_EMPTY_VALUE); 
-      assertUnit(it.pBucket    == us.buckets + 7);
+      assertUnit(it.pBucket    == us.buckets + 8);
       assertUnit(it.pBucketEnd == us.buckets + 10);
    }  // teardown
    
@@ -1077,34 +1677,97 @@ public:
       assertUnit(it.pBucketEnd == us.buckets + 10);
    }  // teardown
 
-   /***************************************
-    * REMOVE
-    ***************************************/
-   
-   // clear an empty hash
-   void test_clear_empty()
+   // insert an array of keys into an empty hash
+   void test_insertBatch_empty()
    {  // setup
       //    +----+----+----+----+----+----+----+----+----+----+
       //    |    |    |    |    |    |    |    |    |    |    |
       //    +----+----+----+----+----+----+----+----+----+----+
       //      0    1    2    3    4    5    6    7    8    9
       custom::unordered_set us;
+      int keys[4] = { 55, 67, 31, 67 };
       // exercise
-      us.clear();
+      us.insert_batch(keys, 4);
       // verify
       //    +----+----+----+----+----+----+----+----+----+----+
-      //    |    |    |    |    |    |    |    |    |    |    |
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
       //    +----+----+----+----+----+----+----+----+----+----+
       //      0    1    2    3    4    5    6    7    8    9
-      assertEmptyFixture(us);
+      assertStandardFixture(us);
    }  // teardown
-   
-   // clear all the elements from the standard fixture
-   void test_clear_standard()
+
+   // insert more keys than fit in the standard hash
+   void test_insertBatch_grow()
    {  // setup
-      //    +----+----+----+----+----+----+----+----+----+----+
-      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
-      //    +----+----+----+----+----+----+----+----+----+----+
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      std::vector<int> keys;
+      for (int i = 0; i < 1000; i++)
+         keys.push_back(i * 10 + 7);   // every one collides with 67
+      // exercise
+      us.insert_batch(keys.data(), keys.size());
+      // verify
+      assertUnit(us.size() == 1002);   // 67 was already there
+      assertUnit(us.load_factor() <= us.max_load_factor());
+      assertUnit(us.find(31) != us.end());
+      assertUnit(us.find(55) != us.end());
+      for (int i = 0; i < 1000; i++)
+         if (us.find(i * 10 + 7) == us.end())
+            assertUnit(us.find(i * 10 + 7) != us.end());
+   }  // teardown
+
+   // insert with a hash computed before; it probes like insert(t)
+   void test_insert_precomputedHash()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      size_t hash = us.hash_function()(-65);
+      // exercise
+      custom::unordered_set::iterator it = us.insert(-65, hash);
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |-65 | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(it.pBucket == us.buckets + 6);
+      assertUnit(us.numElements == 4);
+      assertUnit(us.buckets[6] == -65);
+      assertUnit(us.insert(-65, hash).pBucket == us.buckets + 6);
+      assertUnit(us.numElements == 4);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+   
+   // clear an empty hash
+   void test_clear_empty()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    |    |    |    |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      // exercise
+      us.clear();
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    |    |    |    |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertEmptyFixture(us);
+   }  // teardown
+   
+   // clear all the elements from the standard fixture
+   void test_clear_standard()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
       //      0    1    2    3    4    5    6    7    8    9
       custom::unordered_set us;
       setupStandardFixture(us);
@@ -1244,6 +1907,205 @@ public:
    }  // teardown
 
    
+   // erase with a hash computed before
+   void test_erase_precomputedHash()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      size_t hash = us.hash_function()(55);
+      // exercise
+      custom::unordered_set::iterator it = us.erase(55, hash);
+      // verify
+      //                                         it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    |    |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(us.numElements == 2);
+      assertUnit(us.buckets[5] == HASH_EMPTY_VALUE);
+      assertUnit(it.pBucket == us.buckets + 7);
+      assertUnit(us.erase(55, hash) == us.end());
+   }  // teardown
+
+   // erase through an iterator, without looking the key up again
+   void test_erase_iteratorStandard()
+   {  // setup
+      //              it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      custom::unordered_set::iterator it = us.begin();
+      // exercise
+      it = us.erase(it);
+      // verify
+      //                                         it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(us.numElements == 2);
+      assertUnit(us.buckets[1] == HASH_EMPTY_VALUE);
+      assertUnit(us.bucket_size(1) == 0);
+      assertUnit(it.pBucket == us.buckets + 5);
+      assertUnit(us.erase(us.end()) == us.end());
+   }  // teardown
+
+   // erasing through an iterator shifts the cluster back, around the wrap
+   void test_erase_iteratorShift()
+   {  // setup
+      //                                                    it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    | 19 |  0 | 29 |    |    |    |    |    |    |  9 |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      us.insert({ 9, 19, 0, 29 });
+      custom::unordered_set::iterator it(us.buckets + 9, us.buckets + 10);
+      // exercise
+      it = us.erase(it);
+      // verify
+      //                                                    it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |  0 | 29 |    |    |    |    |    |    |    | 19 |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(us.numElements == 3);
+      assertUnit(us.buckets[0] == 0);
+      assertUnit(us.buckets[1] == 29);
+      assertUnit(us.buckets[2] == HASH_EMPTY_VALUE);
+      assertUnit(us.buckets[9] == 19);
+      assertUnit(it.pBucket == us.buckets + 9);
+      assertUnit(us.bucket_size(9) == 2);
+   }  // teardown
+
+   // erase from begin to end leaves nothing
+   void test_erase_rangeAll()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      // exercise
+      custom::unordered_set::iterator it = us.erase(us.begin(), us.end());
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    |    |    |    |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(it == us.end());
+      assertEmptyFixture(us);
+   }  // teardown
+
+   // erase part of the table; the range ends before the last element
+   void test_erase_rangeMiddle()
+   {  // setup
+      //              first                        last
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      custom::unordered_set::iterator first = us.find(31);
+      custom::unordered_set::iterator last = us.find(67);
+      // exercise
+      custom::unordered_set::iterator it = us.erase(first, last);
+      // verify
+      //                                         it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    |    |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(us.numElements == 1);
+      assertUnit(us.buckets[1] == HASH_EMPTY_VALUE);
+      assertUnit(us.buckets[5] == HASH_EMPTY_VALUE);
+      assertUnit(us.buckets[7] == 67);
+      assertUnit(it.pBucket == us.buckets + 7);
+      assertUnit(us.bucket_size(1) == 0);
+      assertUnit(us.bucket_size(7) == 1);
+   }  // teardown
+
+   // erase_if removes just what the predicate picks
+   void test_eraseIf_standard()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      // exercise
+      size_t num = erase_if(us, [](const int& key) { return key > 50; });
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    |    |    |    |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(num == 2);
+      assertUnit(us.numElements == 1);
+      assertUnit(us.buckets[1] == 31);
+      assertUnit(us.buckets[5] == HASH_EMPTY_VALUE);
+      assertUnit(us.buckets[7] == HASH_EMPTY_VALUE);
+   }  // teardown
+
+   // survivors behind a hole move straight to where they belong
+   void test_eraseIf_cluster()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    | 19 |  0 | 29 |    |    |    |    |    |    |  9 |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      us.insert({ 9, 19, 0, 29 });
+      // exercise
+      size_t num = erase_if(us, [](const int& key) { return key == 19; });
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |  0 | 29 |    |    |    |    |    |    |    |  9 |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(num == 1);
+      assertUnit(us.numElements == 3);
+      assertUnit(us.buckets[0] == 0);
+      assertUnit(us.buckets[1] == 29);
+      assertUnit(us.buckets[2] == HASH_EMPTY_VALUE);
+      assertUnit(us.buckets[9] == 9);
+      assertUnit(us.bucket_size(9) == 2);
+      assertUnit(us.bucket_size(0) == 1);
+   }  // teardown
+
+   // a big sweep: each key is asked about once, and what is left is findable
+   void test_eraseIf_large()
+   {  // setup
+      custom::unordered_set us;
+      std::vector<int> keys;
+      setupLargeFixture(us, keys, 100000, 46);
+      size_t asked = 0;
+      // exercise
+      size_t num = erase_if(us, [&asked](const int& key) { asked++; return key % 3 == 0; });
+      // verify
+      std::vector<int> kept;
+      for (int key : keys)
+         if (key % 3 != 0)
+            kept.push_back(key);
+      assertUnit(asked == keys.size());
+      assertUnit(num == keys.size() - kept.size());
+      assertLargeFixture(us, kept);
+      size_t total = 0;
+      for (size_t i = 0; i < us.bucket_count(); i++)
+         total += us.bucket_size(i);
+      assertUnit(total == kept.size());
+   }  // teardown
+
    /***************************************
     * SIZE EMPTY 
     ***************************************/
@@ -1395,6 +2257,572 @@ public:
       // teardown
    }
 
+   // elements from one home, some wrapped past the end, some not adjacent
+   void test_bucketSize_wrapped()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    | 19 |  0 | 29 |    |    |    |    |    |    |  9 |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      us.insert({ 9, 19, 0, 29 });
+      // exercise
+      size_t num9 = us.bucket_size(9);
+      size_t num0 = us.bucket_size(0);
+      size_t num1 = us.bucket_size(1);
+      // verify
+      assertUnit(num9 == 3);
+      assertUnit(num0 == 1);
+      assertUnit(num1 == 0);
+      assertUnit(us.buckets[1] == 0);
+   }  // teardown
+
+   // erasing takes the element out of its home's count, shifted or not
+   void test_bucketSize_erase()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    | 19 |  0 | 29 |    |    |    |    |    |    |  9 |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      us.insert({ 9, 19, 0, 29 });
+      // exercise
+      us.erase(19);
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |  0 | 29 |    |    |    |    |    |    |    |  9 |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(us.buckets[0] == 0);
+      assertUnit(us.buckets[1] == 29);
+      assertUnit(us.bucket_size(9) == 2);
+      assertUnit(us.bucket_size(0) == 1);
+      assertUnit(us.bucket_size(1) == 0);
+   }  // teardown
+
+   // growing recounts every home, and the counts add up to the size
+   void test_bucketSize_grow()
+   {  // setup
+      custom::unordered_set us;
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         us.insert(i * 7);
+      us.erase(7);
+      // verify
+      size_t total = 0;
+      for (size_t i = 0; i < us.bucket_count(); i++)
+      {
+         size_t walked = 0;
+         for (size_t j = i; us.buckets[j] != HASH_EMPTY_VALUE; j = us.next(j))
+            if (us.bucket(us.buckets[j]) == i)
+               walked++;
+         assertUnit(us.bucket_size(i) == walked);
+         total += us.bucket_size(i);
+      }
+      assertUnit(total == us.size());
+   }  // teardown
+
+   // a bucket nothing calls home has nothing to iterate
+   void test_localIterator_standardEmpty()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      // exercise
+      custom::unordered_set::local_iterator it = us.begin(3);
+      // verify
+      assertUnit(it == us.end(3));
+      assertStandardFixture(us);
+   }  // teardown
+
+   // one element at home: we see it, then the end
+   void test_localIterator_standardOne()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      // exercise
+      custom::unordered_set::local_iterator it = us.begin(5);
+      // verify
+      assertUnit(it != us.end(5));
+      assertUnit(*it == 55);
+      assertUnit(it.pBucket == us.buckets + 5);
+      ++it;
+      assertUnit(it == us.end(5));
+      assertStandardFixture(us);
+   }  // teardown
+
+   // a home's elements are found around the wrap, skipping the others
+   void test_localIterator_wrapped()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    | 19 |  0 | 29 |    |    |    |    |    |    |  9 |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      us.insert({ 9, 19, 0, 29 });
+      std::vector<int> home9;
+      std::vector<int> home0;
+      // exercise
+      for (custom::unordered_set::local_iterator it = us.begin(9); it != us.end(9); it++)
+         home9.push_back(*it);
+      for (custom::unordered_set::local_iterator it = us.begin(0); it != us.end(0); ++it)
+         home0.push_back(*it);
+      // verify
+      assertUnit(home9 == std::vector<int>({ 9, 19, 29 }));
+      assertUnit(home0 == std::vector<int>({ 0 }));
+   }  // teardown
+
+   /***************************************
+    * SIZING
+    ***************************************/
+
+   // after a burst drains, shrink_to_fit gives the buckets back
+   void test_shrinkToFit_drained()
+   {  // setup
+      custom::unordered_set us;
+      for (int i = 0; i < 10000; i++)
+         us.insert(i);
+      for (int i = 100; i < 10000; i++)
+         us.erase(i);
+      size_t peak = us.bucket_count();
+      // exercise
+      us.shrink_to_fit();
+      // verify
+      assertUnit(peak >= 20000);
+      assertUnit(us.bucket_count() < 300);
+      assertUnit(us.load_factor() <= us.max_load_factor());
+      assertUnit(us.size() == 100);
+      for (int i = 0; i < 100; i++)
+         assertUnit(us.find(i) != us.end());
+      assertUnit(us.find(100) == us.end());
+   }  // teardown
+
+   // an empty table shrinks back to where it started
+   void test_shrinkToFit_empty()
+   {  // setup
+      custom::unordered_set us;
+      us.reserve(1000);
+      // exercise
+      us.shrink_to_fit();
+      // verify
+      assertUnit(us.bucket_count() == 10);
+      assertEmptyFixture(us);
+   }  // teardown
+
+   // with no minimum load factor, erase never shrinks
+   void test_minLoadFactor_off()
+   {  // setup
+      custom::unordered_set us;
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      size_t peak = us.bucket_count();
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         us.erase(i);
+      // verify
+      assertUnit(us.min_load_factor() == 0.0f);
+      assertUnit(us.bucket_count() == peak);
+      assertUnit(us.empty());
+   }  // teardown
+
+   // erasing below the minimum rehashes to halfway between the limits
+   void test_minLoadFactor_shrinks()
+   {  // setup
+      custom::unordered_set us;
+      us.min_load_factor(0.1f);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      size_t peak = us.bucket_count();
+      // exercise
+      for (int i = 0; i < 990; i++)
+         us.erase(i);
+      // verify
+      assertUnit(us.bucket_count() < peak / 10);
+      assertUnit(us.load_factor() >= us.min_load_factor());
+      assertUnit(us.load_factor() <= us.max_load_factor());
+      assertUnit(us.size() == 10);
+      for (int i = 990; i < 1000; i++)
+         assertUnit(us.find(i) != us.end());
+   }  // teardown
+
+   // right after a shrink, one more insert or erase does not rehash
+   void test_minLoadFactor_hysteresis()
+   {  // setup
+      custom::unordered_set us;
+      us.min_load_factor(0.1f);
+      for (int i = 0; i < 10000; i++)
+         us.insert(i);
+      int i = 0;
+      size_t before = us.bucket_count();
+      while (us.bucket_count() == before)
+         us.erase(i++);
+      size_t shrunk = us.bucket_count();
+      // exercise
+      us.insert(0);
+      us.erase(0);
+      us.erase(i);
+      // verify
+      assertUnit(shrunk < before);
+      assertUnit(us.bucket_count() == shrunk);
+      assertUnit(us.load_factor() > us.min_load_factor() * 2.0f);
+   }  // teardown
+
+   // a sweep that leaves the table sparse shrinks it once, at the end
+   void test_minLoadFactor_eraseIf()
+   {  // setup
+      custom::unordered_set us;
+      us.min_load_factor(0.1f);
+      for (int i = 0; i < 10000; i++)
+         us.insert(i);
+      // exercise
+      size_t num = erase_if(us, [](const int& key) { return key >= 50; });
+      // verify
+      assertUnit(num == 9950);
+      assertUnit(us.size() == 50);
+      assertUnit(us.load_factor() >= us.min_load_factor());
+      for (int key = 0; key < 50; key++)
+         assertUnit(us.find(key) != us.end());
+   }  // teardown
+
+   // erasing through an iterator never shrinks, so the loop sees everything
+   void test_minLoadFactor_iteratorLoop()
+   {  // setup
+      custom::unordered_set us;
+      us.min_load_factor(0.1f);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      size_t peak = us.bucket_count();
+      size_t seen = 0;
+      // exercise
+      for (custom::unordered_set::iterator it = us.begin(); it != us.end(); )
+      {
+         seen++;
+         it = us.erase(it);
+      }
+      // verify
+      assertUnit(seen == 1000);
+      assertUnit(us.empty());
+      assertUnit(us.bucket_count() == peak);
+      us.shrink_to_fit();
+      assertUnit(us.bucket_count() == 10);
+   }  // teardown
+
+   // the erase that shrinks the table still returns a live element
+   void test_minLoadFactor_eraseReturnsNext()
+   {  // setup
+      custom::unordered_set us;
+      us.min_load_factor(0.1f);
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      int i = 0;
+      size_t before = us.bucket_count();
+      custom::unordered_set::iterator it;
+      // exercise
+      do
+         it = us.erase(i++);
+      while (us.bucket_count() == before);
+      // verify
+      assertUnit(us.bucket_count() < before);
+      assertUnit(it != us.end());
+      assertUnit(*it >= i);
+      assertUnit(us.find(*it) == it);
+   }  // teardown
+
+   /***************************************
+    * MEMORY
+    ***************************************/
+
+   // a new set is ten empty buckets and their counts, all of it waste
+   void test_memoryUsage_empty()
+   {  // setup
+      custom::unordered_set us;
+      // exercise
+      custom::unordered_set::memory_report report = us.memory_usage();
+      // verify
+      assertUnit(report.sets == 1);
+      assertUnit(report.keys == 10 * sizeof(int));
+      assertUnit(report.metadata == 10 * sizeof(uint32_t) + sizeof(std::atomic<uint32_t>));
+      assertUnit(report.nodes == 0);
+      assertUnit(report.object == sizeof(custom::unordered_set));
+      assertUnit(report.wasted == 10 * HASH_BUCKET_BYTES);
+      assertUnit(report.total() == report.keys + report.metadata + sizeof(custom::unordered_set));
+      assertEmptyFixture(us);
+   }  // teardown
+
+   // three filled buckets are not waste, the other seven are
+   void test_memoryUsage_standard()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      custom::unordered_set us;
+      setupStandardFixture(us);
+      // exercise
+      custom::unordered_set::memory_report report = us.memory_usage();
+      // verify
+      assertUnit(report.keys == 10 * sizeof(int));
+      assertUnit(report.wasted == 7 * HASH_BUCKET_BYTES);
+      assertStandardFixture(us);
+   }  // teardown
+
+   // draining leaves the bytes behind until the table shrinks
+   void test_memoryUsage_shrink()
+   {  // setup
+      custom::unordered_set us;
+      for (int i = 0; i < 1000; i++)
+         us.insert(i);
+      for (int i = 10; i < 1000; i++)
+         us.erase(i);
+      size_t drained = us.memory_usage().total();
+      size_t wasted = us.memory_usage().wasted;
+      // exercise
+      us.shrink_to_fit();
+      // verify
+      assertUnit(wasted > drained / 2);
+      assertUnit(us.memory_usage().total() < drained / 10);
+      assertUnit(us.memory_usage().wasted < wasted / 10);
+   }  // teardown
+
+   // the process-wide counts go up by what each live set holds
+   void test_totalMemoryUsage_live()
+   {  // setup
+      custom::unordered_set::memory_report before = custom::unordered_set::total_memory_usage();
+      custom::unordered_set us1;
+      custom::unordered_set us2;
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         us2.insert(i);
+      custom::unordered_set::memory_report after = custom::unordered_set::total_memory_usage();
+      // verify
+      assertUnit(after.sets == before.sets + 2);
+      assertUnit(after.keys - before.keys == us1.memory_usage().keys + us2.memory_usage().keys);
+      assertUnit(after.metadata - before.metadata ==
+                 us1.memory_usage().metadata + us2.memory_usage().metadata);
+      assertUnit(after.object - before.object == 2 * sizeof(custom::unordered_set));
+      assertUnit(after.wasted == 0);
+   }  // teardown
+
+   // sets that are gone, and tables outgrown, are not counted
+   void test_totalMemoryUsage_destroyed()
+   {  // setup
+      custom::unordered_set::memory_report before = custom::unordered_set::total_memory_usage();
+      // exercise
+      {
+         custom::unordered_set us;
+         for (int i = 0; i < 1000; i++)
+            us.insert(i);
+         custom::unordered_set copy(us);
+         custom::unordered_set moved(std::move(copy));
+      }
+      custom::unordered_set::memory_report after = custom::unordered_set::total_memory_usage();
+      // verify
+      assertUnit(after.sets == before.sets);
+      assertUnit(after.total() == before.total());
+   }  // teardown
+
+
+   /***************************************
+    * PERFORMANCE
+    * Most keys below end in 3, so in a ten bucket table they all
+    * want the same home bucket. A table that overwrites on collision
+    * loses them; one that never grows goes O(n) per operation.
+    ***************************************/
+
+   // inserting n keys costs O(1) each, and keeps all n keys
+   void test_perf_insertScales()
+   {  // setup
+      custom::unordered_set us;
+      auto setup = [&us](size_t) { us.clear(); };
+      auto insertAll = [&us](size_t n)
+      {
+         for (size_t i = 0; i < n; i++)
+            us.insert((int)(i * 10 + 3));
+      };
+      // exercise
+      assertScalesLinearly(setup, insertAll, perfSizes(), perfTolerance);
+      // verify
+      assertUnit(us.size() == perfSizes().back());
+   }  // teardown
+
+   // finding each of n keys costs O(1)
+   void test_perf_findScales()
+   {  // setup
+      custom::unordered_set us;
+      size_t found = 0;
+      auto setup = [&us, &found](size_t n)
+      {
+         us.clear();
+         found = 0;
+         for (size_t i = 0; i < n; i++)
+            us.insert((int)(i * 10 + 3));
+      };
+      auto findAll = [&us, &found](size_t n)
+      {
+         for (size_t i = 0; i < n; i++)
+            if (us.find((int)(i * 10 + 3)) != us.end())
+               found++;
+      };
+      // exercise
+      assertScalesLinearly(setup, findAll, perfSizes(), perfTolerance);
+      // verify
+      assertUnit(found == perfSizes().back());
+   }  // teardown
+
+   // erasing each of n keys costs O(1)
+   void test_perf_eraseScales()
+   {  // setup
+      custom::unordered_set us;
+      auto setup = [&us](size_t n)
+      {
+         us.clear();
+         for (size_t i = 0; i < n; i++)
+            us.insert((int)(i * 10 + 3));
+      };
+      auto eraseAll = [&us](size_t n)
+      {
+         for (size_t i = 0; i < n; i++)
+            us.erase((int)(i * 10 + 3));
+      };
+      // exercise
+      assertScalesLinearly(setup, eraseAll, perfSizes(), perfTolerance);
+      // verify
+      assertUnit(us.empty());
+   }  // teardown
+
+   // keys 0 through n-1, the way IDs come, then their negatives. Both
+   // have the same |key|, so each negative's home bucket is taken. If
+   // the dense keys sit side by side in one run of buckets, every
+   // lookup and insert of a negative probes to the end of that run.
+   // -1 is HASH_EMPTY_VALUE, so the negatives start at -2.
+   void test_perf_denseNegativeScales()
+   {  // setup
+      custom::unordered_set us;
+      size_t found = 0;
+      auto setup = [&us, &found](size_t n)
+      {
+         us.clear();
+         found = 0;
+         for (size_t i = 0; i < n; i++)
+            us.insert((int)i);
+      };
+      auto findThenInsert = [&us, &found](size_t n)
+      {
+         for (size_t i = 2; i < n; i++)
+            if (us.find(-(int)i) != us.end())
+               found++;
+         for (size_t i = 2; i < n; i++)
+            us.insert(-(int)i);
+      };
+      // exercise
+      assertScalesLinearly(setup, findThenInsert, perfSizes(), perfTolerance);
+      // verify
+      assertUnit(found == 0);
+      assertUnit(us.size() == perfSizes().back() * 2 - 2);
+   }  // teardown
+
+   // a hundred thousand inserts should not take a tenth of a second
+   void test_perf_insertThroughput()
+   {  // setup
+      custom::unordered_set us;
+      auto setup = [&us](size_t) { us.clear(); };
+      auto insertAll = [&us](size_t n)
+      {
+         for (size_t i = 0; i < n; i++)
+            us.insert((int)(i * 10 + 3));
+      };
+      // exercise and verify
+      assertThroughput(setup, insertAll, 100000, 1.0e6);
+   }  // teardown
+
+   /***************************************
+    * LARGE
+    ***************************************/
+
+   // insert a hundred thousand random keys
+   void test_large_insert100k()
+   {  // setup
+      custom::unordered_set us;
+      std::vector<int> keys;
+      // exercise
+      setupLargeFixture(us, keys, 100000, 1);
+      // verify
+      assertLargeFixture(us, keys);
+   }  // teardown
+
+   // insert a million random keys. This takes about a second in an
+   // unoptimized build, so it is given more room than most tests.
+   void test_large_insert1m()
+   {  // setup
+      expectSlow(4.0);
+      custom::unordered_set us;
+      std::vector<int> keys;
+      // exercise
+      setupLargeFixture(us, keys, 1000000, 2);
+      // verify
+      assertLargeFixture(us, keys);
+   }  // teardown
+
+   // insert two million random keys: one more doubling than the
+   // million key fixture. About three seconds unoptimized, so it too is
+   // given more room. Ten million keys would take some fifteen seconds
+   // there, too long for a suite run on every build, so stop at two.
+   void test_large_insert2m()
+   {  // setup
+      expectSlow(8.0);
+      custom::unordered_set us;
+      std::vector<int> keys;
+      // exercise
+      setupLargeFixture(us, keys, 2000000, 3);
+      // verify
+      assertLargeFixture(us, keys);
+   }  // teardown
+
+   // erase every other distinct key of a large fixture
+   void test_large_eraseHalf()
+   {  // setup
+      custom::unordered_set us;
+      std::vector<int> keys;
+      setupLargeFixture(us, keys, 100000, 4);
+      std::vector<int> kept;
+      // exercise
+      for (size_t i = 0; i < keys.size(); i++)
+         if (i % 2)
+            us.erase(keys[i]);
+         else
+            kept.push_back(keys[i]);
+      // verify
+      assertLargeFixture(us, kept);
+      for (size_t i = 1; i < keys.size(); i += 2)
+         assertUnit(us.find(keys[i]) == us.end());
+   }  // teardown
+
+   // iterating a large fixture visits every key exactly once
+   void test_large_iterate()
+   {  // setup
+      custom::unordered_set us;
+      std::vector<int> keys;
+      setupLargeFixture(us, keys, 100000, 5);
+      std::vector<int> visited;
+      // exercise
+      for (custom::unordered_set::iterator it = us.begin(); it != us.end(); ++it)
+         visited.push_back(*it);
+      // verify
+      std::sort(visited.begin(), visited.end());
+      assertUnit(visited == keys);
+   }  // teardown
+
+   // problem sizes for the scaling tests, and how much the cost of one
+   // operation may drift across them (cache misses alone account for some)
+   static std::vector<size_t> perfSizes() { return {1000, 10000, 100000}; }
+   static constexpr double perfTolerance = 10.0;
 
 
    /*************************************************************
@@ -1410,10 +2838,13 @@ public:
       for (int i = 0; i < 10; i++)
          us.buckets[i] = HASH_EMPTY_VALUE;
 
-      // set the values
+      // set the values, each in its home bucket
       us.buckets[1] = 31;
       us.buckets[7] = 67;
       us.buckets[5] = 55;
+      us.homeCounts()[1] = 1;
+      us.homeCounts()[7] = 1;
+      us.homeCounts()[5] = 1;
 
       // set the number of elements
       us.numElements = 3;
@@ -1421,6 +2852,86 @@ public:
 
 
 
+   /*************************************************************
+    * SETUP LARGE FIXTURE
+    * Insert n pseudo-random keys drawn from a fixed seed:
+    *    - about half spread over the whole int range, negatives included
+    *    - about a quarter that share a handful of home buckets
+    *    - about a quarter repeating a key inserted earlier
+    * keys receives the distinct keys, sorted.
+    *************************************************************/
+   void setupLargeFixture(custom::unordered_set& us, std::vector<int>& keys,
+                          size_t n, unsigned int seed)
+   {
+      std::mt19937 random(seed);
+      std::uniform_int_distribution<int> anyKey(-2000000000, 2000000000);
+      keys.clear();
+      keys.reserve(n);
+
+      for (size_t i = 0; i < n; i++)
+      {
+         int key;
+         switch (random() % 4)
+         {
+            case 0:
+               // colliding: a multiple of a large power of two plus 0..7
+               key = (int)(random() % 64) * (1 << 20) + (int)(random() % 8);
+               break;
+            case 1:
+               // duplicate of an earlier key, when there is one
+               key = keys.empty() ? 0 : keys[random() % keys.size()];
+               break;
+            default:
+               key = anyKey(random);
+               break;
+         }
+         if (key == HASH_EMPTY_VALUE)   // reserved for empty buckets
+            continue;
+
+         us.insert(key);
+         keys.push_back(key);
+      }
+
+      std::sort(keys.begin(), keys.end());
+      keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+   }
+
+   /*************************************************************
+    * VERIFY LARGE FIXTURE
+    * Every key is present, the count matches, and keys that were
+    * never inserted are not found
+    *************************************************************/
+   void assertLargeFixtureParameters(custom::unordered_set& us, const std::vector<int>& keys,
+                                     int line, const char* function)
+   {
+      assertIndirect(us.size() == keys.size());
+      assertIndirect(us.load_factor() <= us.max_load_factor());
+
+      size_t missing = 0;
+      for (int key : keys)
+         if (us.find(key) == us.end())
+            missing++;
+      assertIndirect(missing == 0);
+
+      // odd keys just past each inserted one, unless that is inserted too
+      size_t extra = 0;
+      for (int key : keys)
+         if (key < 2000000000 && key + 1 != HASH_EMPTY_VALUE &&
+             !std::binary_search(keys.begin(), keys.end(), key + 1) &&
+             us.find(key + 1) != us.end())
+            extra++;
+      assertIndirect(extra == 0);
+   }
+
+   /*************************************************************
+    * OWNERS
+    * How many sets share the table of us
+    *************************************************************/
+   uint32_t owners(const custom::unordered_set& us)
+   {
+      return custom::unordered_set::owners(us.buckets, us.numBuckets).load();
+   }
+
    /*************************************************************
     * VERIFY STANDARD FIXTURE
     *    +----+----+----+----+----+----+----+----+----+----+
@@ -1443,6 +2954,8 @@ public:
       assertIndirect(us.buckets[8] == HASH_EMPTY_VALUE);
       assertIndirect(us.buckets[9] == HASH_EMPTY_VALUE); 
 
+      for (size_t i = 0; i < 10; i++)
+         assertIndirect(us.homeCounts()[i] == ((i == 1 || i == 5 || i == 7) ? 1 : 0));
    }
 
    /*************************************************************
@@ -1467,6 +2980,9 @@ public:
       assertIndirect(us.buckets[7] == HASH_EMPTY_VALUE); 
       assertIndirect(us.buckets[8] == HASH_EMPTY_VALUE);
       assertIndirect(us.buckets[9] == HASH_EMPTY_VALUE); 
+
+      for (size_t i = 0; i < 10; i++)
+         assertIndirect(us.homeCounts()[i] == 0);
    }
 
 };
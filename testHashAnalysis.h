@@ -0,0 +1,219 @@
+/***********************************************************************
+ * Header:
+ *    TEST HASH ANALYSIS
+ * Summary:
+ *    Unit tests for the hash distribution analyzer
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "hashAnalysis.h"
+#include "hash.h"
+#include "unitTest.h"
+
+#include <cmath>
+#include <vector>
+
+
+class TestHashAnalysis : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_distinct();
+      test_defaultBuckets_growth();
+
+      // Policy
+      test_bucket_identity();
+      test_bucket_multiply();
+
+      // Analyze
+      test_analyze_standard();
+      test_analyze_sameDigit();
+      test_analyze_wrapAround();
+      test_analyze_denseRun();
+      test_avalanche_identity();
+      test_avalanche_scramble();
+
+      report("HashAnalysis");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // duplicates are dropped and the keys sorted
+   void test_construct_distinct()
+   {  // setup
+      int keys[6] = { 67, 55, 31, 55, 67, 55 };
+      // exercise
+      custom::hash_analyzer ha(keys, 6);
+      // verify
+      assertUnit(ha.size() == 3);
+      assertUnit(ha.keys == std::vector<int>({ 31, 55, 67 }));
+   }  // teardown
+
+   // the bucket count unordered_set would have after inserting the keys
+   void test_defaultBuckets_growth()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = 0; i < 11; i++)
+         keys.push_back(i);
+      // exercise and verify
+      assertUnit(custom::hash_analyzer(keys.data(), 5).default_buckets() == 10);
+      assertUnit(custom::hash_analyzer(keys.data(), 6).default_buckets() == 20);
+      assertUnit(custom::hash_analyzer(keys.data(), 11).default_buckets() == 40);
+   }  // teardown
+
+   /***************************************
+    * POLICY
+    ***************************************/
+
+   // identity is exactly unordered_set's bucket()
+   void test_bucket_identity()
+   {  // setup
+      custom::unordered_set us;
+      custom::hash_analyzer::policy p = custom::hash_analyzer::IDENTITY;
+      // exercise and verify
+      for (int key = -100; key <= 100; key += 3)
+         assertUnit(custom::hash_analyzer::bucket(p, custom::hash_analyzer::hash(p, key), 10)
+                    == us.bucket(key));
+   }  // teardown
+
+   // multiply scales the hash into the buckets rather than taking a remainder
+   void test_bucket_multiply()
+   {  // setup
+      custom::hash_analyzer::policy p = custom::hash_analyzer::MULTIPLY;
+      // exercise and verify
+      assertUnit(custom::hash_analyzer::hash(p, 1) == 0x9E3779B1u);
+      assertUnit(custom::hash_analyzer::bucket(p, 0x9E3779B1u, 10) == 6);
+      assertUnit(custom::hash_analyzer::bucket(p, 0xFFFFFFFFu, 10) == 9);
+      assertUnit(custom::hash_analyzer::bucket(p, 0u, 10) == 0);
+   }  // teardown
+
+   /***************************************
+    * ANALYZE
+    ***************************************/
+
+   // the standard fixture: three homes of one key each
+   void test_analyze_standard()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      int keys[3] = { 55, 67, 31 };
+      custom::hash_analyzer ha(keys, 3);
+      // exercise
+      custom::hash_analyzer::report r = ha.analyze(custom::hash_analyzer::IDENTITY);
+      // verify
+      assertUnit(r.numKeys == 3);
+      assertUnit(r.numBuckets == 10);
+      assertUnit(near(r.variance, 0.21));   // 3 of (1 - 0.3)^2, 7 of 0.3^2
+      assertUnit(r.maxHome == 1);
+      assertUnit(r.maxProbe == 1);
+      assertUnit(near(r.hitProbes, 1.0));
+      assertUnit(near(r.missProbes, 1.3)); // buckets 1, 5 and 7 take two
+   }  // teardown
+
+   // keys that agree modulo the bucket count share one home under identity
+   void test_analyze_sameDigit()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = 0; i < 100; i++)
+         keys.push_back(i * 1010 + 3);
+      custom::hash_analyzer ha(keys.data(), keys.size());
+      // exercise
+      custom::hash_analyzer::report identity = ha.analyze(custom::hash_analyzer::IDENTITY, 10 * 101);
+      custom::hash_analyzer::report scramble = ha.analyze(custom::hash_analyzer::SCRAMBLE, 10 * 101);
+      // verify
+      assertUnit(identity.maxHome == 100);
+      assertUnit(identity.maxProbe == 100);
+      assertUnit(near(identity.hitProbes, 50.5));
+      assertUnit(scramble.maxHome < 5);
+      assertUnit(scramble.hitProbes < 1.5);
+      assertUnit(scramble.variance < identity.variance / 50.0);
+   }  // teardown
+
+   // consecutive IDs form one run under identity; the prime spreads them
+   void test_analyze_denseRun()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = 0; i < 10000; i++)
+         keys.push_back(i);
+      custom::hash_analyzer ha(keys.data(), keys.size());
+      // exercise
+      custom::hash_analyzer::report identity = ha.analyze(custom::hash_analyzer::IDENTITY);
+      custom::hash_analyzer::report prime = ha.analyze(custom::hash_analyzer::PRIME);
+      // verify
+      assertUnit(identity.numBuckets == 20480);
+      assertUnit(identity.missProbes > 1000.0);
+      assertUnit(prime.maxHome == 1);
+      assertUnit(prime.missProbes < 2.0);
+   }  // teardown
+
+   // a run that wraps past the last bucket is still one run
+   void test_analyze_wrapAround()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    | 29 |    |    |    |    |    |    |    | 8  | 9  |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      int keys[3] = { 8, 9, 29 };
+      custom::hash_analyzer ha(keys, 3);
+      // exercise
+      custom::hash_analyzer::report r = ha.analyze(custom::hash_analyzer::IDENTITY);
+      // verify
+      assertUnit(r.maxHome == 2);
+      assertUnit(r.maxProbe == 2);
+      assertUnit(near(r.hitProbes, 4.0 / 3.0));
+      assertUnit(near(r.missProbes, 1.6)); // 8 takes 4, 9 takes 3, 0 takes 2
+   }  // teardown
+
+   // |key| barely changes when a low key bit does
+   void test_avalanche_identity()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = 0; i < 1000; i++)
+         keys.push_back(i * 37);
+      custom::hash_analyzer ha(keys.data(), keys.size());
+      // exercise
+      custom::hash_analyzer::report r = ha.analyze(custom::hash_analyzer::IDENTITY);
+      // verify
+      assertUnit(r.avalanche < 0.2);
+      assertUnit(r.avalancheBias > 0.45);
+   }  // teardown
+
+   // the MurmurHash3 finalizer flips about half the bits
+   void test_avalanche_scramble()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = 0; i < 1000; i++)
+         keys.push_back(i * 37);
+      custom::hash_analyzer ha(keys.data(), keys.size());
+      // exercise
+      custom::hash_analyzer::report r = ha.analyze(custom::hash_analyzer::SCRAMBLE);
+      // verify
+      assertUnit(std::fabs(r.avalanche - 0.5) < 0.01);
+      assertUnit(r.avalancheBias < 0.1);
+   }  // teardown
+
+   /*************************************************************
+    * NEAR
+    * Whether two statistics agree to rounding
+    *************************************************************/
+   bool near(double actual, double expected)
+   {
+      return std::fabs(actual - expected) < 1e-9;
+   }
+};
+
+#endif // DEBUG
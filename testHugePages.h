@@ -0,0 +1,169 @@
+/***********************************************************************
+ * Header:
+ *    TEST HUGE PAGES
+ * Summary:
+ *    Unit tests for the huge page memory resource
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "hugePages.h"
+#include "hash.h"
+#include "unitTest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+
+
+class TestHugePages : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Allocate
+      test_allocate_smallUpstream();
+      test_allocate_largeMapped();
+      test_deallocate_unmaps();
+
+      // Unordered set
+      test_set_reserve();
+      test_set_growReturnsOld();
+
+      report("HugePages");
+   }
+
+   /***************************************
+    * ALLOCATE
+    ***************************************/
+
+   // less than a huge page comes from upstream
+   void test_allocate_smallUpstream()
+   {  // setup
+      static char buffer[4096];
+      std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                                std::pmr::null_memory_resource());
+      custom::huge_page_resource huge(&arena);
+      // exercise
+      void* p = huge.allocate(1000, alignof(int));
+      // verify
+      assertUnit((char*)p >= buffer && (char*)p < buffer + sizeof(buffer));
+      assertUnit(huge.regions.empty());
+      assertUnit(huge.mapped_bytes() == 0);
+      assertUnit(huge.huge_bytes() == 0);
+      // teardown
+      huge.deallocate(p, 1000, alignof(int));
+   }
+
+   // a huge page or more is mapped in whole huge pages on a 2 MB boundary
+   void test_allocate_largeMapped()
+   {  // setup
+      custom::huge_page_resource huge;
+      size_t bytes = HASH_HUGE_PAGE * 3 + 100;
+      // exercise
+      char* p = (char*)huge.allocate(bytes, alignof(int));
+      // verify
+      std::memset(p, 0x5A, bytes);
+      assertUnit(p[bytes - 1] == 0x5A);
+#ifdef HASH_HAVE_HUGE_PAGES
+      assertUnit((uintptr_t)p % HASH_HUGE_PAGE == 0);
+      assertUnit(huge.regions.size() == 1);
+      assertUnit(huge.mapped_bytes() == HASH_HUGE_PAGE * 4);
+      assertUnit(huge.reserved_bytes() <= huge.mapped_bytes());
+      assertUnit(huge.huge_bytes() <= huge.mapped_bytes());
+#endif // HASH_HAVE_HUGE_PAGES
+      // teardown
+      huge.deallocate(p, bytes, alignof(int));
+   }
+
+   // giving a block back unmaps it
+   void test_deallocate_unmaps()
+   {  // setup
+      custom::huge_page_resource huge;
+      void* p1 = huge.allocate(HASH_HUGE_PAGE, alignof(int));
+      void* p2 = huge.allocate(HASH_HUGE_PAGE * 2, alignof(int));
+      // exercise
+      huge.deallocate(p1, HASH_HUGE_PAGE, alignof(int));
+      // verify
+#ifdef HASH_HAVE_HUGE_PAGES
+      assertUnit(huge.regions.size() == 1);
+      assertUnit(huge.regions[0].p == p2);
+      assertUnit(huge.mapped_bytes() == HASH_HUGE_PAGE * 2);
+#endif // HASH_HAVE_HUGE_PAGES
+      // teardown
+      huge.deallocate(p2, HASH_HUGE_PAGE * 2, alignof(int));
+      assertUnit(huge.mapped_bytes() == 0);
+   }
+
+   /***************************************
+    * UNORDERED SET
+    ***************************************/
+
+   // reserve maps the whole table at once and writes every bucket
+   void test_set_reserve()
+   {  // setup
+      custom::huge_page_resource huge;
+      custom::unordered_set us(&huge);
+      // exercise
+      us.reserve(1 << 20);
+      for (int i = 0; i < (1 << 20); i++)
+         us.insert(i * 3);
+      // verify
+      assertUnit(us.bucket_count() == 1 << 21);
+      assertUnit(us.size() == 1 << 20);
+      assertUnit(us.find(3 * 1000) != us.end());
+      assertUnit(us.find(3 * 1000 + 1) == us.end());
+#ifdef HASH_HAVE_HUGE_PAGES
+      assertUnit(huge.regions.size() == 1);
+      assertUnit((void*)&*us.begin() >= huge.regions[0].p);
+      assertUnit(huge.mapped_bytes() == roundToHugePages(tableBytes(us)));
+      assertUnit(huge.huge_bytes() <= huge.mapped_bytes());
+#endif // HASH_HAVE_HUGE_PAGES
+   }  // teardown
+
+   // as the table doubles, each outgrown table is unmapped
+   void test_set_growReturnsOld()
+   {  // setup
+      custom::huge_page_resource huge;
+      {
+         custom::unordered_set us(&huge);
+         // exercise
+         for (int i = 0; i < 2000000; i++)
+            us.insert(i);
+         // verify
+         assertUnit(us.size() == 2000000);
+#ifdef HASH_HAVE_HUGE_PAGES
+         assertUnit(huge.regions.size() == 1);
+         assertUnit(huge.mapped_bytes() == roundToHugePages(tableBytes(us)));
+#endif // HASH_HAVE_HUGE_PAGES
+      }
+      assertUnit(huge.mapped_bytes() == 0);
+   }  // teardown
+
+   /*************************************************************
+    * ROUND TO HUGE PAGES
+    *************************************************************/
+   size_t roundToHugePages(size_t bytes)
+   {
+      return (bytes + HASH_HUGE_PAGE - 1) / HASH_HUGE_PAGE * HASH_HUGE_PAGE;
+   }
+
+   /*************************************************************
+    * TABLE BYTES
+    * The one block a set's buckets and their metadata come in
+    *************************************************************/
+   size_t tableBytes(const custom::unordered_set& us)
+   {
+      custom::unordered_set::memory_report report = us.memory_usage();
+      return report.keys + report.metadata;
+   }
+};
+
+#endif // DEBUG
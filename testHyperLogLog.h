@@ -0,0 +1,249 @@
+/***********************************************************************
+ * Header:
+ *    TEST HYPER LOG LOG
+ * Summary:
+ *    Unit tests for the distinct count estimator
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "hyperLogLog.h"
+#include "unitTest.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+class TestHyperLogLog : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_construct_range();
+
+      // Insert
+      test_insert_register();
+      test_insert_duplicate();
+      test_insert_batch();
+      test_merge_union();
+
+      // Estimate
+      test_estimate_empty();
+      test_estimate_small();
+      test_estimate_dense();
+      test_estimate_random();
+      test_upperBound_covers();
+      test_clear_standard();
+
+      report("HyperLogLog");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // 2^14 registers, all zero
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::hyper_log_log hll;
+      // verify
+      assertUnit(hll.bits == 14);
+      assertUnit(hll.registers.size() == 16384);
+      assertUnit(countNonZero(hll) == 0);
+   }  // teardown
+
+   // the range constructor sketches every key in the range
+   void test_construct_range()
+   {  // setup
+      std::vector<int> keys{ 55, 67, 31, 55 };
+      custom::hyper_log_log expected(10);
+      for (int key : keys)
+         expected.insert(key);
+      // exercise
+      custom::hyper_log_log hll(keys.begin(), keys.end(), 10);
+      // verify
+      assertUnit(hll.bits == 10);
+      assertUnit(hll.registers == expected.registers);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // a key raises the register its top bits pick to its rank
+   void test_insert_register()
+   {  // setup
+      custom::hyper_log_log hll(4);
+      // find a key whose hash is 0101 then 001... : register 5, rank 3
+      int key = custom::simd::unscramble((int)0x52345678u);
+      // exercise
+      hll.insert(key);
+      // verify
+      assertUnit(hll.registers[5] == 3);
+      assertUnit(countNonZero(hll) == 1);
+   }  // teardown
+
+   // a register only ever grows, and a repeated key changes nothing
+   void test_insert_duplicate()
+   {  // setup
+      custom::hyper_log_log hll(4);
+      int key = custom::simd::unscramble((int)0x52345678u);
+      hll.insert(key);
+      std::vector<uint8_t> before = hll.registers;
+      // exercise
+      hll.insert(key);
+      hll.insert(custom::simd::unscramble((int)0x5F000000u));   // register 5, rank 1
+      // verify
+      assertUnit(hll.registers == before);
+   }  // teardown
+
+   // insert_batch is insert() for each key
+   void test_insert_batch()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = 0; i < 5000; i++)
+         keys.push_back(i * 7 - 10000);
+      custom::hyper_log_log one;
+      custom::hyper_log_log batch;
+      for (int key : keys)
+         one.insert(key);
+      // exercise
+      batch.insert_batch(keys.data(), keys.size());
+      // verify
+      assertUnit(batch.registers == one.registers);
+   }  // teardown
+
+   // merging two sketches is sketching both streams
+   void test_merge_union()
+   {  // setup
+      custom::hyper_log_log left;
+      custom::hyper_log_log right;
+      custom::hyper_log_log both;
+      for (int i = 0; i < 20000; i++)
+      {
+         (i % 3 ? left : right).insert(i);
+         both.insert(i);
+      }
+      // exercise
+      left.merge(right);
+      // verify
+      assertUnit(left.registers == both.registers);
+   }  // teardown
+
+   /***************************************
+    * ESTIMATE
+    ***************************************/
+
+   // nothing seen is an estimate of nothing
+   void test_estimate_empty()
+   {  // setup
+      custom::hyper_log_log hll;
+      // exercise and verify
+      assertUnit(hll.estimate() == 0.0);
+      assertUnit(hll.count() == 0);
+   }  // teardown
+
+   // a handful of keys is counted almost exactly by linear counting
+   void test_estimate_small()
+   {  // setup
+      custom::hyper_log_log hll;
+      // exercise
+      for (int i = 0; i < 3; i++)
+      {
+         hll.insert(55);
+         hll.insert(67);
+         hll.insert(31);
+      }
+      // verify
+      assertUnit(hll.count() == 3);
+   }  // teardown
+
+   // dense IDs, the worst case for |key|, are no trouble for the sketch
+   void test_estimate_dense()
+   {  // setup
+      custom::hyper_log_log hll;
+      // exercise
+      for (int i = 0; i < 1000000; i++)
+         hll.insert(i);
+      // verify
+      assertUnit(within(hll.estimate(), 1000000.0, 3.0 * hll.error()));
+   }  // teardown
+
+   // random keys with repeats are counted once each
+   void test_estimate_random()
+   {  // setup
+      std::mt19937 random(37);
+      std::vector<int> keys;
+      for (int i = 0; i < 200000; i++)
+         keys.push_back((int)random());
+      custom::hyper_log_log hll;
+      // exercise
+      for (int round = 0; round < 3; round++)
+         hll.insert(keys.begin(), keys.end());
+      // verify
+      assertUnit(within(hll.estimate(), 200000.0, 3.0 * hll.error()));
+   }  // teardown
+
+   // upper_bound() is above the true count across small and large streams
+   void test_upperBound_covers()
+   {  // setup
+      custom::hyper_log_log hll;
+      int key = 0;
+      // exercise and verify
+      for (int n = 10; n <= 1000000; n *= 10)
+      {
+         for (; key < n; key++)
+            hll.insert(key * 3);
+         assertUnit(hll.upper_bound() >= (size_t)n);
+      }
+   }  // teardown
+
+   // clear empties every register
+   void test_clear_standard()
+   {  // setup
+      custom::hyper_log_log hll;
+      for (int i = 0; i < 1000; i++)
+         hll.insert(i);
+      // exercise
+      hll.clear();
+      // verify
+      assertUnit(hll.registers.size() == 16384);
+      assertUnit(countNonZero(hll) == 0);
+      assertUnit(hll.count() == 0);
+   }  // teardown
+
+   /*************************************************************
+    * COUNT NON ZERO
+    * How many registers have seen a key
+    *************************************************************/
+   size_t countNonZero(const custom::hyper_log_log& hll)
+   {
+      size_t n = 0;
+      for (uint8_t reg : hll.registers)
+         if (reg != 0)
+            n++;
+      return n;
+   }
+
+   /*************************************************************
+    * WITHIN
+    * Whether estimate is within the relative error of actual
+    *************************************************************/
+   bool within(double estimate, double actual, double error)
+   {
+      return std::fabs(estimate - actual) <= actual * error;
+   }
+};
+
+#endif // DEBUG
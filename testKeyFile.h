@@ -0,0 +1,260 @@
+/***********************************************************************
+ * Header:
+ *    TEST KEY FILE
+ * Summary:
+ *    Unit tests for reading and writing streams of keys
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "keyFile.h"
+#include "unitTest.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+class TestKeyFile : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Text
+      test_text_lines();
+      test_text_separators();
+      test_text_outOfRange();
+      test_text_splitByBuffer();
+      test_text_longerThanBuffer();
+
+      // Binary
+      test_binary_standard();
+      test_binary_leftover();
+
+      // Files
+      test_file_mapped();
+      test_file_missing();
+
+      // Writer
+      test_writer_standard();
+
+      report("KeyFile");
+   }
+
+   /***************************************
+    * TEXT
+    ***************************************/
+
+   // one key per line
+   void test_text_lines()
+   {  // setup
+      FILE* file = setupFile("55\n67\n31\n");
+      custom::key_reader reader(file, custom::key_reader::TEXT);
+      // exercise
+      std::vector<int> keys = readAll(reader);
+      // verify
+      assertUnit(keys == std::vector<int>({ 55, 67, 31 }));
+      assertUnit(reader.skipped() == 0);
+      assertUnit(!reader.mapped());
+      // teardown
+      std::fclose(file);
+   }
+
+   // anything that is not part of a number separates numbers
+   void test_text_separators()
+   {  // setup
+      FILE* file = setupFile("12, -7;abc 3\t-\n--4 x-9");
+      custom::key_reader reader(file, custom::key_reader::TEXT);
+      // exercise
+      std::vector<int> keys = readAll(reader);
+      // verify
+      assertUnit(keys == std::vector<int>({ 12, -7, 3, -4, -9 }));
+      // teardown
+      std::fclose(file);
+   }
+
+   // numbers that do not fit in an int are skipped and counted
+   void test_text_outOfRange()
+   {  // setup
+      FILE* file = setupFile("2147483647 2147483648 -2147483648 -2147483649 "
+                             "99999999999999999999 5");
+      custom::key_reader reader(file, custom::key_reader::TEXT);
+      // exercise
+      std::vector<int> keys = readAll(reader);
+      // verify
+      assertUnit(keys == std::vector<int>({ 2147483647, -2147483647 - 1, 5 }));
+      assertUnit(reader.skipped() == 3);
+      // teardown
+      std::fclose(file);
+   }
+
+   // numbers cut in two by the end of the buffer come through whole
+   void test_text_splitByBuffer()
+   {  // setup
+      std::string text;
+      std::vector<int> expected;
+      for (int i = 0; i < 1000; i++)
+      {
+         int key = (i % 2) ? i * 7919 : -i * 104729;
+         expected.push_back(key);
+         text += std::to_string(key) + (i % 3 ? "\n" : " , ");
+      }
+      FILE* file = setupFile(text);
+      custom::key_reader reader(file, custom::key_reader::TEXT, 16);
+      // exercise
+      std::vector<int> keys = readAll(reader);
+      // verify
+      assertUnit(keys == expected);
+      assertUnit(reader.skipped() == 0);
+      // teardown
+      std::fclose(file);
+   }
+
+   // a single number longer than the whole buffer makes it grow
+   void test_text_longerThanBuffer()
+   {  // setup
+      FILE* file = setupFile("1 000000000000000000000000000000000042 2");
+      custom::key_reader reader(file, custom::key_reader::TEXT, 16);
+      // exercise
+      std::vector<int> keys = readAll(reader);
+      // verify
+      assertUnit(keys == std::vector<int>({ 1, 42, 2 }));
+      assertUnit(reader.buffer.size() > 16);
+      // teardown
+      std::fclose(file);
+   }
+
+   /***************************************
+    * BINARY
+    ***************************************/
+
+   // raw ints, read through a buffer smaller than the file
+   void test_binary_standard()
+   {  // setup
+      std::vector<int> expected;
+      for (int i = -500; i < 500; i++)
+         expected.push_back(i * 4099);
+      FILE* file = setupFile(std::string((const char*)expected.data(),
+                                         expected.size() * sizeof(int)));
+      custom::key_reader reader(file, custom::key_reader::BINARY, 18);
+      // exercise
+      std::vector<int> keys = readAll(reader);
+      // verify
+      assertUnit(keys == expected);
+      assertUnit(reader.skipped() == 0);
+      // teardown
+      std::fclose(file);
+   }
+
+   // a few bytes at the end that do not make up an int
+   void test_binary_leftover()
+   {  // setup
+      int values[2] = { 55, -67 };
+      FILE* file = setupFile(std::string((const char*)values, sizeof(values)) + "ab");
+      custom::key_reader reader(file, custom::key_reader::BINARY);
+      // exercise
+      std::vector<int> keys = readAll(reader);
+      // verify
+      assertUnit(keys == std::vector<int>({ 55, -67 }));
+      assertUnit(reader.skipped() == 1);
+      // teardown
+      std::fclose(file);
+   }
+
+   /***************************************
+    * FILES
+    ***************************************/
+
+   // a named file is mapped where the platform allows it
+   void test_file_mapped()
+   {  // setup
+      const char* path = "testKeyFile.tmp";
+      FILE* file = std::fopen(path, "wb");
+      std::fputs("55\n67\n31", file);
+      std::fclose(file);
+      std::vector<int> keys;
+      {
+         custom::key_reader reader(path, custom::key_reader::TEXT);
+         // exercise
+         keys = readAll(reader);
+         // verify
+#ifdef HASH_HAVE_MMAP
+         assertUnit(reader.mapped());
+#endif // HASH_HAVE_MMAP
+         assertUnit(reader.is_open());
+      }
+      assertUnit(keys == std::vector<int>({ 55, 67, 31 }));
+      // teardown
+      std::remove(path);
+   }
+
+   // a file that is not there cannot be read
+   void test_file_missing()
+   {  // setup
+      // exercise
+      custom::key_reader reader("testKeyFile.missing", custom::key_reader::TEXT);
+      // verify
+      assertUnit(!reader.is_open());
+      int key;
+      assertUnit(reader.read(&key, 1) == 0);
+   }  // teardown
+
+   /***************************************
+    * WRITER
+    ***************************************/
+
+   // keys come out as decimal text, one per line
+   void test_writer_standard()
+   {  // setup
+      FILE* file = std::tmpfile();
+      // exercise
+      {
+         custom::key_writer writer(file);
+         writer.write(-2147483647 - 1);
+         writer.write(0);
+         writer.write(42, "\t1");
+      }
+      // verify
+      std::rewind(file);
+      char text[64] = {};
+      size_t n = std::fread(text, 1, sizeof(text) - 1, file);
+      assertUnit(std::string(text, n) == "-2147483648\n0\n42\t1\n");
+      // teardown
+      std::fclose(file);
+   }
+
+
+   /*************************************************************
+    * SETUP FILE
+    * A temporary file holding text, ready to be read from the start
+    *************************************************************/
+   FILE* setupFile(const std::string& text)
+   {
+      FILE* file = std::tmpfile();
+      std::fwrite(text.data(), 1, text.size(), file);
+      std::rewind(file);
+      return file;
+   }
+
+   /*************************************************************
+    * READ ALL
+    * Every key left in reader, a few at a time
+    *************************************************************/
+   std::vector<int> readAll(custom::key_reader& reader)
+   {
+      std::vector<int> keys;
+      int batch[7];
+      for (size_t n; (n = reader.read(batch, 7)) != 0; )
+         keys.insert(keys.end(), batch, batch + n);
+      return keys;
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,275 @@
+/***********************************************************************
+ * Header:
+ *    TEST LOOKUP SCHEDULER
+ * Summary:
+ *    Unit tests for async_find() and the scheduler that interleaves
+ *    lookups. Built only where the compiler supports coroutines.
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#include "lookupScheduler.h"
+
+#if defined(DEBUG) && defined(HASH_HAVE_COROUTINES)
+
+#include "unitTest.h"
+
+#include <stdexcept>
+#include <vector>
+
+
+class TestLookupScheduler : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Async find
+      test_asyncFind_found();
+      test_asyncFind_missing();
+      test_asyncFind_suspends();
+      test_asyncFind_growsMeanwhile();
+
+      // Scheduler
+      test_spawn_lazy();
+      test_spawn_limit();
+      test_run_interleaved();
+      test_run_many();
+      test_run_exception();
+      test_destructor_unfinished();
+
+      report("LookupScheduler");
+   }
+
+   /***************************************
+    * ASYNC FIND
+    ***************************************/
+
+   // a key in the set is found
+   void test_asyncFind_found()
+   {  // setup
+      custom::unordered_set us;
+      us.insert({ 31, 49, 67 });
+      custom::lookup_scheduler scheduler;
+      bool found = false;
+      // exercise
+      scheduler.spawn(lookup(us, 49, found));
+      scheduler.run();
+      // verify
+      assertUnit(found);
+   }  // teardown
+
+   // a key not in the set is not
+   void test_asyncFind_missing()
+   {  // setup
+      custom::unordered_set us;
+      us.insert({ 31, 49, 67 });
+      custom::lookup_scheduler scheduler;
+      bool found = true;
+      // exercise
+      scheduler.spawn(lookup(us, 50, found));
+      scheduler.run();
+      // verify
+      assertUnit(!found);
+   }  // teardown
+
+   // co_await gives up the thread once, and only once
+   void test_asyncFind_suspends()
+   {  // setup
+      custom::unordered_set us;
+      us.insert({ 31 });
+      custom::lookup_scheduler scheduler;
+      bool found = false;
+      scheduler.spawn(lookup(us, 31, found));
+      // exercise
+      scheduler.step();   // runs up to the co_await
+      // verify
+      assertUnit(!found);
+      assertUnit(scheduler.ready.size() == 1);
+      assertUnit(scheduler.in_flight() == 1);
+      scheduler.step();   // the find itself
+      assertUnit(found);
+      assertUnit(scheduler.ready.empty());
+      assertUnit(scheduler.in_flight() == 0);
+   }  // teardown
+
+   // the set is rehashed between the prefetch and the find
+   void test_asyncFind_growsMeanwhile()
+   {  // setup
+      custom::unordered_set us;
+      us.insert({ 31 });
+      custom::lookup_scheduler scheduler;
+      bool found = false;
+      scheduler.spawn(lookup(us, 555, found));
+      scheduler.step();
+      // exercise
+      for (int i = 500; i < 600; i++)
+         us.insert(i);
+      scheduler.run();
+      // verify
+      assertUnit(us.bucket_count() > 10);
+      assertUnit(found);
+   }  // teardown
+
+   /***************************************
+    * SCHEDULER
+    ***************************************/
+
+   // nothing runs until the scheduler is run
+   void test_spawn_lazy()
+   {  // setup
+      custom::unordered_set us;
+      us.insert({ 31 });
+      custom::lookup_scheduler scheduler;
+      bool found = false;
+      // exercise
+      scheduler.spawn(lookup(us, 31, found));
+      // verify
+      assertUnit(!found);
+      assertUnit(scheduler.in_flight() == 1);
+      scheduler.run();
+      assertUnit(found);
+   }  // teardown
+
+   // spawning past the limit first runs what is there
+   void test_spawn_limit()
+   {  // setup
+      custom::unordered_set us;
+      us.insert({ 0, 1, 2, 3 });
+      custom::lookup_scheduler scheduler(2);
+      bool found[4] = { false, false, false, false };
+      // exercise
+      for (int i = 0; i < 4; i++)
+      {
+         scheduler.spawn(lookup(us, i, found[i]));
+         assertUnit(scheduler.in_flight() <= 2);
+      }
+      // verify
+      assertUnit(found[0]);
+      assertUnit(found[1]);
+      scheduler.run();
+      assertUnit(found[2]);
+      assertUnit(found[3]);
+   }  // teardown
+
+   // every task gets to its co_await before any gets past it
+   void test_run_interleaved()
+   {  // setup
+      custom::unordered_set us;
+      us.insert({ 31, 49, 67 });
+      custom::lookup_scheduler scheduler;
+      std::vector<int> order;
+      // exercise
+      for (int key : { 31, 49, 67 })
+         scheduler.spawn(trace(us, key, order));
+      scheduler.run();
+      // verify
+      assertUnit(order == std::vector<int>({ 31, 49, 67, -31, -49, -67 }));
+   }  // teardown
+
+   // many more lookups than are ever in flight
+   void test_run_many()
+   {  // setup
+      custom::unordered_set us;
+      for (int i = 0; i < 1000; i++)
+         us.insert(i * 2);
+      custom::lookup_scheduler scheduler;
+      size_t hits = 0;
+      // exercise
+      for (int i = 0; i < 2000; i++)
+         scheduler.spawn(count(us, i, hits));
+      scheduler.run();
+      // verify
+      assertUnit(hits == 1000);
+      assertUnit(scheduler.in_flight() == 0);
+   }  // teardown
+
+   // what a task throws comes out of run(), and the rest still finish
+   void test_run_exception()
+   {  // setup
+      custom::unordered_set us;
+      us.insert({ 31 });
+      custom::lookup_scheduler scheduler;
+      bool found = false;
+      bool thrown = false;
+      scheduler.spawn(fail(us));
+      scheduler.spawn(lookup(us, 31, found));
+      // exercise
+      try
+      {
+         scheduler.run();
+      }
+      catch (const std::runtime_error&)
+      {
+         thrown = true;
+      }
+      scheduler.run();
+      // verify
+      assertUnit(thrown);
+      assertUnit(found);
+      assertUnit(scheduler.in_flight() == 0);
+   }  // teardown
+
+   // tasks left suspended are destroyed with the scheduler
+   void test_destructor_unfinished()
+   {  // setup
+      custom::unordered_set us;
+      us.insert({ 31 });
+      bool found = false;
+      {
+         custom::lookup_scheduler scheduler;
+         scheduler.spawn(lookup(us, 31, found));
+         scheduler.step();
+         // exercise
+      }
+      // verify
+      assertUnit(!found);
+   }  // teardown
+
+   /*************************************************************
+    * LOOKUP
+    * Set found to whether key is in us
+    *************************************************************/
+   static custom::lookup_scheduler::task lookup(custom::unordered_set& us, int key, bool& found)
+   {
+      found = (co_await us.async_find(key) != us.end());
+   }
+
+   /*************************************************************
+    * COUNT
+    * Add one to hits if key is in us
+    *************************************************************/
+   static custom::lookup_scheduler::task count(custom::unordered_set& us, int key, size_t& hits)
+   {
+      custom::unordered_set::iterator it = co_await us.async_find(key);
+      if (it != us.end())
+         ++hits;
+   }
+
+   /*************************************************************
+    * TRACE
+    * Record key before the co_await and -key after it
+    *************************************************************/
+   static custom::lookup_scheduler::task trace(custom::unordered_set& us, int key, std::vector<int>& order)
+   {
+      order.push_back(key);
+      co_await us.async_find(key);
+      order.push_back(-key);
+   }
+
+   /*************************************************************
+    * FAIL
+    * Throw once the lookup comes back
+    *************************************************************/
+   static custom::lookup_scheduler::task fail(custom::unordered_set& us)
+   {
+      co_await us.async_find(31);
+      throw std::runtime_error("lookup failed");
+   }
+};
+
+#endif // DEBUG && HASH_HAVE_COROUTINES
@@ -0,0 +1,418 @@
+/***********************************************************************
+ * Header:
+ *    TEST MULTISET
+ * Summary:
+ *    Unit tests for the counting multiset
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "multiset.h"
+#include "unitTest.h"
+
+#include <vector>
+
+
+class TestMultiset : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_constructIterator_duplicates();
+      test_constructCopy_standard();
+
+      // Insert
+      test_insert_emptyValue();
+      test_insert_standardDuplicate();
+      test_insert_collision();
+      test_insert_grow();
+      test_insert_widenCounter();
+
+      // Access
+      test_count_missing();
+      test_count_standard();
+      test_iterator_distinct();
+
+      // Remove
+      test_erase_missing();
+      test_erase_decrement();
+      test_erase_lastOccurrence();
+      test_erase_shiftCollision();
+      test_clear_standard();
+
+      report("Multiset");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // create an empty multiset
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::unordered_multiset ms;
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    |    |    |    |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(ms.numBuckets == 10);
+      assertUnit(ms.numDistinct == 0);
+      assertUnit(ms.numElements == 0);
+      assertUnit(ms.countWidth == 1);
+      for (size_t i = 0; i < 10; i++)
+         assertUnit(ms.buckets[i] == HASH_EMPTY_VALUE);
+   }  // teardown
+
+   // build a multiset from a range holding duplicates
+   void test_constructIterator_duplicates()
+   {  // setup
+      std::vector<int> v{55, 67, 31, 67, 55, 67};
+      // exercise
+      custom::unordered_multiset ms(v.begin(), v.end());
+      // verify
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    |    | x1 |    |    |    | x2 |    | x3 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertStandardFixture(ms);
+   }  // teardown
+
+   // copy a standard multiset
+   void test_constructCopy_standard()
+   {  // setup
+      custom::unordered_multiset msSrc;
+      setupStandardFixture(msSrc);
+      // exercise
+      custom::unordered_multiset msDes(msSrc);
+      // verify
+      assertStandardFixture(msSrc);
+      assertStandardFixture(msDes);
+      assertUnit(msSrc.buckets != msDes.buckets);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert one key into an empty multiset
+   void test_insert_emptyValue()
+   {  // setup
+      custom::unordered_multiset ms;
+      // exercise
+      custom::unordered_multiset::iterator it = ms.insert(67);
+      // verify
+      //                                         it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    |    |    | 67 |    |    |
+      //    |    |    |    |    |    |    |    | x1 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(ms.numElements == 1);
+      assertUnit(ms.numDistinct == 1);
+      assertUnit(ms.buckets[7] == 67);
+      assertUnit(ms.getCount(7) == 1);
+      assertUnit(it.pBucket == ms.buckets + 7);
+      assertUnit(it.count() == 1);
+   }  // teardown
+
+   // insert a key already present: only the counter moves
+   void test_insert_standardDuplicate()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      custom::unordered_multiset::iterator it = ms.insert(31);
+      // verify
+      //           it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    |    | x2 |    |    |    | x2 |    | x3 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(ms.numElements == 7);
+      assertUnit(ms.numDistinct == 3);
+      assertUnit(ms.getCount(1) == 2);
+      assertUnit(it.pBucket == ms.buckets + 1);
+   }  // teardown
+
+   // insert a key whose home bucket is taken by another key
+   void test_insert_collision()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      custom::unordered_multiset::iterator it = ms.insert(77);
+      // verify
+      //                                              it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 | 77 |    |
+      //    |    | x1 |    |    |    | x2 |    | x3 | x1 |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(ms.numElements == 7);
+      assertUnit(ms.numDistinct == 4);
+      assertUnit(ms.buckets[7] == 67);
+      assertUnit(ms.getCount(7) == 3);
+      assertUnit(ms.buckets[8] == 77);
+      assertUnit(ms.getCount(8) == 1);
+      assertUnit(it.pBucket == ms.buckets + 8);
+   }  // teardown
+
+   // insert enough distinct keys to force the table to grow
+   void test_insert_grow()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      ms.insert(12);
+      ms.insert(13);
+      ms.insert(14);   // five distinct keys fit in ten buckets, six do not
+      // verify
+      assertUnit(ms.numBuckets == 20);
+      assertUnit(ms.numDistinct == 6);
+      assertUnit(ms.numElements == 9);
+      assertUnit(ms.count(31) == 1);
+      assertUnit(ms.count(55) == 2);
+      assertUnit(ms.count(67) == 3);
+      assertUnit(ms.count(12) == 1);
+      assertUnit(ms.count(13) == 1);
+      assertUnit(ms.count(14) == 1);
+   }  // teardown
+
+   // overflow a one-byte counter so every counter is widened
+   void test_insert_widenCounter()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      for (int i = 0; i < 300; i++)
+         ms.insert(31);
+      // verify
+      assertUnit(ms.countWidth == 2);
+      assertUnit(ms.count(31) == 301);
+      assertUnit(ms.count(55) == 2);
+      assertUnit(ms.count(67) == 3);
+      assertUnit(ms.numElements == 306);
+      assertUnit(ms.numDistinct == 3);
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // count a key that was never inserted
+   void test_count_missing()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      size_t count = ms.count(77);
+      // verify
+      assertUnit(count == 0);
+      assertStandardFixture(ms);
+   }  // teardown
+
+   // count every key of the standard fixture
+   void test_count_standard()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      size_t c31 = ms.count(31);
+      size_t c55 = ms.count(55);
+      size_t c67 = ms.count(67);
+      // verify
+      assertUnit(c31 == 1);
+      assertUnit(c55 == 2);
+      assertUnit(c67 == 3);
+      assertStandardFixture(ms);
+   }  // teardown
+
+   // iteration visits each distinct key once
+   void test_iterator_distinct()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      std::vector<int> keys;
+      size_t total = 0;
+      // exercise
+      for (custom::unordered_multiset::iterator it = ms.begin(); it != ms.end(); ++it)
+      {
+         keys.push_back(*it);
+         total += it.count();
+      }
+      // verify
+      assertUnit(keys.size() == 3);
+      assertUnit(keys.size() == 3 && keys[0] == 31);
+      assertUnit(keys.size() == 3 && keys[1] == 55);
+      assertUnit(keys.size() == 3 && keys[2] == 67);
+      assertUnit(total == 6);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // erase a key that is not there
+   void test_erase_missing()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      custom::unordered_multiset::iterator it = ms.erase(77);
+      // verify
+      assertUnit(it == ms.end());
+      assertStandardFixture(ms);
+   }  // teardown
+
+   // erase one of several occurrences
+   void test_erase_decrement()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      custom::unordered_multiset::iterator it = ms.erase(67);
+      // verify
+      //                                         it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+      //    |    | x1 |    |    |    | x2 |    | x2 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(ms.numElements == 5);
+      assertUnit(ms.numDistinct == 3);
+      assertUnit(ms.getCount(7) == 2);
+      assertUnit(it.pBucket == ms.buckets + 7);
+   }  // teardown
+
+   // erase the only occurrence of a key
+   void test_erase_lastOccurrence()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      custom::unordered_multiset::iterator it = ms.erase(31);
+      // verify
+      //                                  it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    |    |    |    |    | 55 |    | 67 |    |    |
+      //    |    |    |    |    |    | x2 |    | x3 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(ms.numElements == 5);
+      assertUnit(ms.numDistinct == 2);
+      assertUnit(ms.buckets[1] == HASH_EMPTY_VALUE);
+      assertUnit(ms.count(31) == 0);
+      assertUnit(it.pBucket == ms.buckets + 5);
+   }  // teardown
+
+   // erasing the head of a probe run pulls the collision back home
+   void test_erase_shiftCollision()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      ms.insert(77);
+      // exercise
+      custom::unordered_multiset::iterator it = ms.erase(67);
+      ms.erase(67);
+      it = ms.erase(67);
+      // verify
+      //                                         it
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    |    | 31 |    |    |    | 55 |    | 77 |    |    |
+      //    |    | x1 |    |    |    | x2 |    | x1 |    |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //      0    1    2    3    4    5    6    7    8    9
+      assertUnit(ms.numDistinct == 3);
+      assertUnit(ms.numElements == 4);
+      assertUnit(ms.buckets[7] == 77);
+      assertUnit(ms.getCount(7) == 1);
+      assertUnit(ms.buckets[8] == HASH_EMPTY_VALUE);
+      assertUnit(ms.count(77) == 1);
+      assertUnit(it.pBucket == ms.buckets + 7);
+   }  // teardown
+
+   // clear a standard multiset
+   void test_clear_standard()
+   {  // setup
+      custom::unordered_multiset ms;
+      setupStandardFixture(ms);
+      // exercise
+      ms.clear();
+      // verify
+      assertUnit(ms.numElements == 0);
+      assertUnit(ms.numDistinct == 0);
+      for (size_t i = 0; i < 10; i++)
+         assertUnit(ms.buckets[i] == HASH_EMPTY_VALUE);
+   }  // teardown
+
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *    +----+----+----+----+----+----+----+----+----+----+
+    *    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+    *    |    | x1 |    |    |    | x2 |    | x3 |    |    |
+    *    +----+----+----+----+----+----+----+----+----+----+
+    *      0    1    2    3    4    5    6    7    8    9
+    *************************************************************/
+   void setupStandardFixture(custom::unordered_multiset& ms)
+   {
+      // clear out whatever the default constructor created
+      for (size_t i = 0; i < ms.numBuckets; i++)
+         ms.buckets[i] = HASH_EMPTY_VALUE;
+
+      // set the values and their counts
+      ms.buckets[1] = 31;
+      ms.setCount(1, 1);
+      ms.buckets[5] = 55;
+      ms.setCount(5, 2);
+      ms.buckets[7] = 67;
+      ms.setCount(7, 3);
+
+      ms.numDistinct = 3;
+      ms.numElements = 6;
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE
+    *    +----+----+----+----+----+----+----+----+----+----+
+    *    |    | 31 |    |    |    | 55 |    | 67 |    |    |
+    *    |    | x1 |    |    |    | x2 |    | x3 |    |    |
+    *    +----+----+----+----+----+----+----+----+----+----+
+    *      0    1    2    3    4    5    6    7    8    9
+    *************************************************************/
+   void assertStandardFixtureParameters(custom::unordered_multiset& ms, int line, const char* function)
+   {
+      assertIndirect(ms.numBuckets == 10);
+      assertIndirect(ms.numDistinct == 3);
+      assertIndirect(ms.numElements == 6);
+
+      assertIndirect(ms.buckets[0] == HASH_EMPTY_VALUE);
+      assertIndirect(ms.buckets[1] == 31);
+      assertIndirect(ms.getCount(1) == 1);
+      assertIndirect(ms.buckets[2] == HASH_EMPTY_VALUE);
+      assertIndirect(ms.buckets[3] == HASH_EMPTY_VALUE);
+      assertIndirect(ms.buckets[4] == HASH_EMPTY_VALUE);
+      assertIndirect(ms.buckets[5] == 55);
+      assertIndirect(ms.getCount(5) == 2);
+      assertIndirect(ms.buckets[6] == HASH_EMPTY_VALUE);
+      assertIndirect(ms.buckets[7] == 67);
+      assertIndirect(ms.getCount(7) == 3);
+      assertIndirect(ms.buckets[8] == HASH_EMPTY_VALUE);
+      assertIndirect(ms.buckets[9] == HASH_EMPTY_VALUE);
+   }
+};
+
+#endif // DEBUG
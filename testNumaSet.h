@@ -0,0 +1,234 @@
+/***********************************************************************
+ * Header:
+ *    TEST NUMA SET
+ * Summary:
+ *    Unit tests for the NUMA-aware sharded set. Two-node cases use a
+ *    made-up topology, so they run the same on a one-node machine.
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "numaSet.h"
+#include "unitTest.h"
+
+#include <cstring>
+#include <vector>
+
+
+class TestNumaSet : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Topology
+      test_topology_parseList();
+      test_topology_detect();
+      test_topology_cpuNode();
+
+      // Resource
+      test_resource_pages();
+
+      // Sharded
+      test_sharded_singleNode();
+      test_sharded_split();
+      test_sharded_erase();
+      test_sharded_reserve();
+
+      // Replicated
+      test_replicated_everyShard();
+      test_replicated_erase();
+
+      report("NumaSet");
+   }
+
+   /***************************************
+    * TOPOLOGY
+    ***************************************/
+
+   // ranges and single CPUs, as sysfs writes them
+   void test_topology_parseList()
+   {  // setup
+      // exercise
+      std::vector<int> values = custom::numa_topology::parseList("0-3,8,10-11\n");
+      // verify
+      assertUnit(values == std::vector<int>({ 0, 1, 2, 3, 8, 10, 11 }));
+      assertUnit(custom::numa_topology::parseList("\n").empty());
+   }  // teardown
+
+   // whatever the machine, there is at least one node and we are on one
+   void test_topology_detect()
+   {  // setup
+      // exercise
+      custom::numa_topology topology = custom::numa_topology::detect();
+      // verify
+      assertUnit(topology.nodes() >= 1);
+      assertUnit(topology.current_node() < topology.nodes());
+   }  // teardown
+
+   // each CPU maps back to its node
+   void test_topology_cpuNode()
+   {  // setup
+      // exercise
+      custom::numa_topology topology({ { 0, 1 }, { 2, 3 } });
+      // verify
+      assertUnit(topology.nodes() == 2);
+      assertUnit(topology.id(1) == 1);
+      assertUnit(topology.node_of_cpu(1) == 0);
+      assertUnit(topology.node_of_cpu(3) == 1);
+      assertUnit(topology.node_of_cpu(99) == 0);
+   }  // teardown
+
+   /***************************************
+    * RESOURCE
+    ***************************************/
+
+   // blocks come back whole and writable, bound or not
+   void test_resource_pages()
+   {  // setup
+      custom::numa_node_resource resource(0);
+      // exercise
+      char* p = (char*)resource.allocate(10000, alignof(int));
+      // verify
+      std::memset(p, 0x5A, 10000);
+      assertUnit(p[9999] == 0x5A);
+      // teardown
+      resource.deallocate(p, 10000, alignof(int));
+   }
+
+   /***************************************
+    * SHARDED
+    ***************************************/
+
+   // one node: one shard on the ordinary heap
+   void test_sharded_singleNode()
+   {  // setup
+      custom::numa_unordered_set ns(custom::numa_unordered_set::SHARDED,
+                                    custom::numa_topology());
+      // exercise
+      bool first = ns.insert(55);
+      bool second = ns.insert(55);
+      // verify
+      assertUnit(first);
+      assertUnit(!second);
+      assertUnit(ns.node_count() == 1);
+      assertUnit(ns.resources.empty());
+      assertUnit(ns.size() == 1);
+      assertUnit(ns.contains(55));
+      assertUnit(ns.node_of(12345) == 0);
+   }  // teardown
+
+   // each key is in exactly the shard node_of() names
+   void test_sharded_split()
+   {  // setup
+      custom::numa_unordered_set ns(custom::numa_unordered_set::SHARDED,
+                                    twoNodes());
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         ns.insert(i);
+      // verify
+      assertUnit(ns.size() == 1000);
+      assertUnit(ns.shard(0).size() > 400);
+      assertUnit(ns.shard(1).size() > 400);
+      assertUnit(ns.shard(0).size() + ns.shard(1).size() == 1000);
+      for (int i = 0; i < 1000; i++)
+      {
+         custom::unordered_set& home = ns.shards[ns.node_of(i)];
+         custom::unordered_set& other = ns.shards[1 - ns.node_of(i)];
+         assertUnit(home.find(i) != home.end());
+         assertUnit(other.find(i) == other.end());
+      }
+   }  // teardown
+
+   // erase takes the key out of its shard only
+   void test_sharded_erase()
+   {  // setup
+      custom::numa_unordered_set ns(custom::numa_unordered_set::SHARDED,
+                                    twoNodes());
+      for (int i = 0; i < 100; i++)
+         ns.insert(i);
+      // exercise
+      size_t erased = ns.erase(42);
+      size_t missing = ns.erase(42);
+      // verify
+      assertUnit(erased == 1);
+      assertUnit(missing == 0);
+      assertUnit(ns.size() == 99);
+      assertUnit(!ns.contains(42));
+      assertUnit(ns.contains(43));
+   }  // teardown
+
+   // reserve gives each node its share, from a thread on that node
+   void test_sharded_reserve()
+   {  // setup
+      custom::numa_unordered_set ns(custom::numa_unordered_set::SHARDED,
+                                    twoNodes());
+      // exercise
+      ns.reserve(10000);
+      // verify
+      assertUnit(ns.shard(0).bucket_count() == 10000);
+      assertUnit(ns.shard(1).bucket_count() == 10000);
+      assertUnit(ns.shard(0).get_allocator().resource() == ns.resources[0].get());
+      assertUnit(ns.empty());
+   }  // teardown
+
+   /***************************************
+    * REPLICATED
+    ***************************************/
+
+   // every node has every key
+   void test_replicated_everyShard()
+   {  // setup
+      custom::numa_unordered_set ns(custom::numa_unordered_set::REPLICATED,
+                                    twoNodes());
+      // exercise
+      for (int i = 0; i < 100; i++)
+         ns.insert(i % 50);
+      // verify
+      assertUnit(ns.size() == 50);
+      assertUnit(ns.shard(0).size() == 50);
+      assertUnit(ns.shard(1).size() == 50);
+      assertUnit(ns.contains(49));
+      assertUnit(!ns.contains(50));
+   }  // teardown
+
+   // erase reaches every copy
+   void test_replicated_erase()
+   {  // setup
+      custom::numa_unordered_set ns(custom::numa_unordered_set::REPLICATED,
+                                    twoNodes());
+      ns.insert(31);
+      ns.insert(55);
+      // exercise
+      size_t erased = ns.erase(31);
+      // verify
+      assertUnit(erased == 1);
+      assertUnit(ns.size() == 1);
+      for (size_t node = 0; node < 2; node++)
+      {
+         custom::unordered_set& shard = ns.shards[node];
+         assertUnit(shard.find(31) == shard.end());
+         assertUnit(shard.find(55) != shard.end());
+      }
+   }  // teardown
+
+   /*************************************************************
+    * TWO NODES
+    * A made-up machine: every CPU on node 0, none on node 1
+    *************************************************************/
+   custom::numa_topology twoNodes()
+   {
+      std::vector<int> all;
+      for (int cpu = 0; cpu < 64; cpu++)
+         all.push_back(cpu);
+      return custom::numa_topology({ all, {} });
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,383 @@
+/***********************************************************************
+ * Header:
+ *    TEST PERSISTENT SET
+ * Summary:
+ *    Unit tests for the persistent HAMT set
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "persistentSet.h"
+#include "unitTest.h"
+
+#include <vector>
+#include <set>
+#include <random>
+#include <algorithm>
+
+
+class TestPersistentSet : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_default();
+      test_constructIterator_standard();
+      test_constructCopy_shares();
+
+      // Insert
+      test_insert_leavesOriginal();
+      test_insert_duplicate();
+      test_insert_split();
+      test_insert_collision();
+      test_insert_sharesSiblings();
+
+      // Access
+      test_contains_standard();
+      test_iterator_everyKey();
+
+      // Remove
+      test_erase_standard();
+      test_erase_missing();
+      test_erase_pullUp();
+      test_erase_collision();
+
+      // Versions
+      test_versions_random();
+
+      report("PersistentSet");
+   }
+
+   /***************************************
+    * CONSTRUCTOR
+    ***************************************/
+
+   // create an empty persistent set
+   void test_construct_default()
+   {  // setup
+      // exercise
+      custom::persistent_set ps;
+      // verify
+      assertUnit(ps.root == nullptr);
+      assertUnit(ps.numElements == 0);
+      assertUnit(ps.begin() == ps.end());
+   }  // teardown
+
+   // build the standard fixture from a range
+   void test_constructIterator_standard()
+   {  // setup
+      std::vector<int> v{ 55, 67, 31 };
+      // exercise
+      custom::persistent_set ps(v.begin(), v.end());
+      // verify
+      assertStandardFixture(ps);
+   }  // teardown
+
+   // a copy is a snapshot: it shares the root instead of copying it
+   void test_constructCopy_shares()
+   {  // setup
+      custom::persistent_set psSrc;
+      setupStandardFixture(psSrc);
+      // exercise
+      custom::persistent_set psDes(psSrc);
+      // verify
+      assertStandardFixture(psSrc);
+      assertStandardFixture(psDes);
+      assertUnit(psSrc.root == psDes.root);
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // inserting makes a new version and leaves the old one alone
+   void test_insert_leavesOriginal()
+   {  // setup
+      custom::persistent_set ps;
+      setupStandardFixture(ps);
+      // exercise
+      custom::persistent_set psNew = ps.insert(12);
+      // verify
+      //    keyMap   bits 3, 12, 23, 31
+      //    keys     [ 67, 12, 55, 31 ]
+      assertStandardFixture(ps);
+      assertUnit(psNew.numElements == 4);
+      assertUnit(psNew.root != ps.root);
+      assertUnit(psNew.root->keyMap == ((1u << 3) | (1u << 12) | (1u << 23) | (1u << 31)));
+      assertUnit(psNew.root->keys == std::vector<int>({ 67, 12, 55, 31 }));
+   }  // teardown
+
+   // inserting a key already there returns the same version
+   void test_insert_duplicate()
+   {  // setup
+      custom::persistent_set ps;
+      setupStandardFixture(ps);
+      // exercise
+      custom::persistent_set psNew = ps.insert(67);
+      // verify
+      assertStandardFixture(psNew);
+      assertUnit(psNew.root == ps.root);
+   }  // teardown
+
+   // two keys in one slot move down into a child using the next five bits
+   void test_insert_split()
+   {  // setup
+      custom::persistent_set ps;
+      setupStandardFixture(ps);
+      // exercise
+      ps = ps.insert(87);   // 87 = 2*32 + 23, 55 = 1*32 + 23
+      // verify
+      //    root     keys [ 67, 31 ]   children [ slot 23 -> ]
+      //    child    keyMap bits 1, 2  keys [ 55, 87 ]
+      assertUnit(ps.numElements == 4);
+      assertUnit(ps.root->keyMap == ((1u << 3) | (1u << 31)));
+      assertUnit(ps.root->childMap == (1u << 23));
+      assertUnit(ps.root->keys == std::vector<int>({ 67, 31 }));
+      assertUnit(ps.root->children.size() == 1);
+      if (ps.root->children.size() == 1)
+      {
+         assertUnit(ps.root->children[0]->keyMap == ((1u << 1) | (1u << 2)));
+         assertUnit(ps.root->children[0]->keys == std::vector<int>({ 55, 87 }));
+      }
+      assertUnit(ps.contains(55));
+      assertUnit(ps.contains(87));
+   }  // teardown
+
+   // t and -t hash alike, so they end up sharing a collision node
+   void test_insert_collision()
+   {  // setup
+      custom::persistent_set ps;
+      setupStandardFixture(ps);
+      // exercise
+      ps = ps.insert(-55);
+      // verify
+      assertUnit(ps.numElements == 4);
+      assertUnit(ps.contains(55));
+      assertUnit(ps.contains(-55));
+      const custom::persistent_set::node* p = ps.root.get();
+      size_t depth = 0;
+      while (!p->isCollision() && !p->children.empty())
+      {
+         p = p->children[0].get();
+         depth++;
+      }
+      assertUnit(depth == 7);   // one level per five bits of a 32-bit hash
+      assertUnit(p->isCollision());
+      assertUnit(p->keys.size() == 2);
+   }  // teardown
+
+   // an update copies only the path to the key; every other subtree is shared
+   void test_insert_sharesSiblings()
+   {  // setup
+      custom::persistent_set ps;
+      for (int i = 0; i < 1024; i++)
+         ps = ps.insert(i);   // 32 keys under each of the 32 root slots
+      // exercise
+      custom::persistent_set psNew = ps.insert(2048);   // lands under slot 0
+      // verify
+      assertUnit(psNew.size() == 1025);
+      assertUnit(ps.size() == 1024);
+      assertUnit(ps.root->children.size() == 32);
+      assertUnit(psNew.root->children.size() == 32);
+      if (ps.root->children.size() == 32 && psNew.root->children.size() == 32)
+      {
+         assertUnit(psNew.root->children[0] != ps.root->children[0]);
+         size_t shared = 0;
+         for (size_t i = 1; i < 32; i++)
+            if (psNew.root->children[i] == ps.root->children[i])
+               shared++;
+         assertUnit(shared == 31);
+      }
+      assertUnit(!ps.contains(2048));
+      assertUnit(psNew.contains(2048));
+   }  // teardown
+
+   /***************************************
+    * ACCESS
+    ***************************************/
+
+   // look up the keys of the standard fixture and a few that are not there
+   void test_contains_standard()
+   {  // setup
+      custom::persistent_set ps;
+      setupStandardFixture(ps);
+      // exercise and verify
+      assertUnit(ps.contains(55));
+      assertUnit(ps.contains(67));
+      assertUnit(ps.contains(31));
+      assertUnit(!ps.contains(87));   // same slot as 55
+      assertUnit(!ps.contains(-55));  // same hash as 55
+      assertUnit(!ps.contains(12));   // an open slot
+      assertUnit(ps.count(55) == 1);
+      assertUnit(ps.count(12) == 0);
+   }  // teardown
+
+   // iteration visits every key exactly once, however deep
+   void test_iterator_everyKey()
+   {  // setup
+      custom::persistent_set ps;
+      std::vector<int> expected;
+      for (int i = -500; i < 500; i++)
+      {
+         ps = ps.insert(i * 37);
+         expected.push_back(i * 37);
+      }
+      std::vector<int> visited;
+      // exercise
+      for (int key : ps)
+         visited.push_back(key);
+      // verify
+      std::sort(visited.begin(), visited.end());
+      assertUnit(visited == expected);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // erasing makes a new version and leaves the old one alone
+   void test_erase_standard()
+   {  // setup
+      custom::persistent_set ps;
+      setupStandardFixture(ps);
+      // exercise
+      custom::persistent_set psNew = ps.erase(55);
+      // verify
+      assertStandardFixture(ps);
+      assertUnit(psNew.numElements == 2);
+      assertUnit(psNew.root->keyMap == ((1u << 3) | (1u << 31)));
+      assertUnit(psNew.root->keys == std::vector<int>({ 67, 31 }));
+      assertUnit(!psNew.contains(55));
+   }  // teardown
+
+   // erasing a key that is not there returns the same version
+   void test_erase_missing()
+   {  // setup
+      custom::persistent_set ps;
+      setupStandardFixture(ps);
+      // exercise
+      custom::persistent_set psNew = ps.erase(87);
+      // verify
+      assertStandardFixture(psNew);
+      assertUnit(psNew.root == ps.root);
+   }  // teardown
+
+   // a child left with a single key folds back into its parent
+   void test_erase_pullUp()
+   {  // setup
+      custom::persistent_set ps;
+      setupStandardFixture(ps);
+      ps = ps.insert(87);
+      // exercise
+      ps = ps.erase(87);
+      // verify
+      assertStandardFixture(ps);
+   }  // teardown
+
+   // erasing one of two colliding keys keeps the other
+   void test_erase_collision()
+   {  // setup
+      custom::persistent_set ps;
+      setupStandardFixture(ps);
+      ps = ps.insert(-55);
+      // exercise
+      custom::persistent_set psNeg = ps.erase(55);
+      custom::persistent_set psPos = ps.erase(-55);
+      // verify
+      assertUnit(psNeg.size() == 3);
+      assertUnit(psNeg.contains(-55));
+      assertUnit(!psNeg.contains(55));
+      assertStandardFixture(psPos);
+   }  // teardown
+
+   /***************************************
+    * VERSIONS
+    ***************************************/
+
+   // random updates against std::set, checking old snapshots never change
+   void test_versions_random()
+   {  // setup
+      std::mt19937 rng(32);
+      std::uniform_int_distribution<int> key(-2000, 2000);
+      custom::persistent_set ps;
+      std::set<int> reference;
+      std::vector<custom::persistent_set> versions;
+      std::vector<std::set<int>> expected;
+      // exercise
+      for (int i = 0; i < 4000; i++)
+      {
+         int t = key(rng);
+         if (rng() % 3 == 0)
+         {
+            ps = ps.erase(t);
+            reference.erase(t);
+         }
+         else
+         {
+            ps = ps.insert(t);
+            reference.insert(t);
+         }
+         if (i % 100 == 0)
+         {
+            versions.push_back(ps);
+            expected.push_back(reference);
+         }
+      }
+      // verify
+      size_t wrong = 0;
+      for (size_t v = 0; v < versions.size(); v++)
+      {
+         std::vector<int> keys;
+         for (int k : versions[v])
+            keys.push_back(k);
+         std::sort(keys.begin(), keys.end());
+         if (versions[v].size() != expected[v].size() ||
+             keys != std::vector<int>(expected[v].begin(), expected[v].end()))
+            wrong++;
+      }
+      assertUnit(wrong == 0);
+   }  // teardown
+
+
+   /*************************************************************
+    * SETUP STANDARD FIXTURE
+    *    keyMap   bits 3, 23, 31
+    *    childMap none
+    *    keys     [ 67, 55, 31 ]
+    *************************************************************/
+   void setupStandardFixture(custom::persistent_set& ps)
+   {
+      std::shared_ptr<custom::persistent_set::node> root =
+         std::make_shared<custom::persistent_set::node>();
+      root->keyMap = (1u << 3) | (1u << 23) | (1u << 31);
+      root->keys = { 67, 55, 31 };
+      ps.root = root;
+      ps.numElements = 3;
+   }
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE
+    *************************************************************/
+   void assertStandardFixtureParameters(custom::persistent_set& ps, int line, const char* function)
+   {
+      assertIndirect(ps.numElements == 3);
+      assertIndirect(ps.root != nullptr);
+      if (ps.root)
+      {
+         assertIndirect(ps.root->keyMap == ((1u << 3) | (1u << 23) | (1u << 31)));
+         assertIndirect(ps.root->childMap == 0);
+         assertIndirect(ps.root->keys == std::vector<int>({ 67, 55, 31 }));
+         assertIndirect(ps.root->children.empty());
+      }
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,279 @@
+/***********************************************************************
+ * Header:
+ *    TEST SIMD
+ * Summary:
+ *    Unit tests for the vectorized kernels. Every kernel this CPU can
+ *    run must agree with the scalar one.
+ * Author
+ *    Savanna W, Isabel W, Jenna R
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "simd.h"
+#include "unitTest.h"
+
+#include <vector>
+#include <climits>
+
+
+class TestSimd : public UnitTest
+{
+
+public:
+   void run()
+   {
+      reset();
+
+      // Probe
+      test_probe_empty();
+      test_probe_keyFirst();
+      test_probe_emptyFirst();
+      test_probe_notFound();
+      test_probe_everyPosition();
+      test_probe_dispatch();
+
+      // Batch
+      test_bucketBatch_standard();
+      test_bucketBatch_extremes();
+      test_bucketBatch_divisors();
+      test_partitionBatch_range();
+      test_partitionBatch_agree();
+
+      // Scramble
+      test_scramble_inverse();
+      test_scramble_spreads();
+
+      report("Simd");
+   }
+
+   /***************************************
+    * PROBE
+    ***************************************/
+
+   // probing zero buckets finds nothing
+   void test_probe_empty()
+   {  // setup
+      int buckets[1] = { 7 };
+      // exercise and verify
+      for (custom::simd::probeFunction kernel : kernels())
+         assertUnit(kernel(buckets, 0, 7) == 0);
+   }  // teardown
+
+   // the key comes before any empty bucket
+   void test_probe_keyFirst()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    | 10 | 20 | 30 |    | 50 | 60 | 70 | 80 | 90 |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      int buckets[10] = { 10, 20, 30, -1, 50, 60, 70, 80, 90, -1 };
+      // exercise and verify
+      for (custom::simd::probeFunction kernel : kernels())
+         assertUnit(kernel(buckets, 10, 20) == 1);
+   }  // teardown
+
+   // an empty bucket comes before the key, so the key is not there
+   void test_probe_emptyFirst()
+   {  // setup
+      //    +----+----+----+----+----+----+----+----+----+----+
+      //    | 10 | 20 | 30 |    | 50 | 60 | 70 | 80 | 90 |    |
+      //    +----+----+----+----+----+----+----+----+----+----+
+      int buckets[10] = { 10, 20, 30, -1, 50, 60, 70, 80, 90, -1 };
+      // exercise and verify
+      for (custom::simd::probeFunction kernel : kernels())
+         assertUnit(kernel(buckets, 10, 90) == 3);
+   }  // teardown
+
+   // a full run without the key reports n
+   void test_probe_notFound()
+   {  // setup
+      std::vector<int> buckets(37);
+      for (size_t i = 0; i < buckets.size(); i++)
+         buckets[i] = (int)i + 100;
+      // exercise and verify
+      for (custom::simd::probeFunction kernel : kernels())
+         assertUnit(kernel(buckets.data(), buckets.size(), 5) == buckets.size());
+   }  // teardown
+
+   // the key is found wherever it sits, including the scalar tail
+   void test_probe_everyPosition()
+   {  // setup
+      std::vector<int> buckets(37);
+      for (size_t i = 0; i < buckets.size(); i++)
+         buckets[i] = (int)i + 100;
+      // exercise and verify
+      for (custom::simd::probeFunction kernel : kernels())
+         for (size_t i = 0; i < buckets.size(); i++)
+            assertUnit(kernel(buckets.data(), buckets.size(), (int)i + 100) == i);
+   }  // teardown
+
+   // the dispatched kernel behaves like the scalar one
+   void test_probe_dispatch()
+   {  // setup
+      int buckets[10] = { 10, 20, 30, -1, 50, 60, 70, 80, 90, -1 };
+      // exercise and verify
+      for (int key = 0; key <= 100; key += 10)
+         assertUnit(custom::simd::probe(buckets, 10, key) ==
+                    custom::simd::probeScalar(buckets, 10, key));
+   }  // teardown
+
+   /***************************************
+    * BATCH
+    ***************************************/
+
+   // the standard fixture keys land where the ten bucket table puts them
+   void test_bucketBatch_standard()
+   {  // setup
+      int keys[3] = { 31, 55, 67 };
+      uint32_t out[3] = { 99, 99, 99 };
+      // exercise
+      custom::simd::bucketBatch(keys, 3, 10, out);
+      // verify
+      assertUnit(out[0] == 1);
+      assertUnit(out[1] == 5);
+      assertUnit(out[2] == 7);
+   }  // teardown
+
+   // negative keys, INT_MIN and INT_MAX all fold the way scalar code does
+   void test_bucketBatch_extremes()
+   {  // setup
+      std::vector<int> keys{ INT_MIN, INT_MAX, -1, 0, 1, -58, 58, -7,
+                             INT_MIN + 1, -2147483000, 2147483000 };
+      // exercise and verify
+      for (batch kernel : bucketKernels())
+         for (uint32_t d : { 1u, 2u, 10u, 4294967295u })
+         {
+            std::vector<uint32_t> out(keys.size());
+            kernel(keys.data(), keys.size(), d, out.data());
+            for (size_t i = 0; i < keys.size(); i++)
+               assertUnit(out[i] == custom::simd::fold(keys[i]) % d);
+         }
+   }  // teardown
+
+   // every kernel agrees with % for a spread of keys and divisors
+   void test_bucketBatch_divisors()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = -500; i < 500; i++)
+         keys.push_back(i * 2654435 + 17);
+      // exercise and verify
+      for (batch kernel : bucketKernels())
+         for (uint32_t d : { 3u, 7u, 10u, 20u, 640u, 1000003u, 2147483648u })
+         {
+            std::vector<uint32_t> out(keys.size());
+            kernel(keys.data(), keys.size(), d, out.data());
+            size_t wrong = 0;
+            for (size_t i = 0; i < keys.size(); i++)
+               if (out[i] != custom::simd::fold(keys[i]) % d)
+                  wrong++;
+            assertUnit(wrong == 0);
+         }
+   }  // teardown
+
+   // partitions are always in range and use every partition
+   void test_partitionBatch_range()
+   {  // setup
+      std::vector<int> keys;
+      for (int i = 0; i < 1000; i++)
+         keys.push_back(i);
+      std::vector<uint32_t> out(keys.size());
+      std::vector<size_t> used(7, 0);
+      // exercise
+      custom::simd::partitionBatch(keys.data(), keys.size(), 7, out.data());
+      // verify
+      for (uint32_t part : out)
+         if (part < 7)
+            used[part]++;
+         else
+            assertUnit(part < 7);
+      for (size_t count : used)
+         assertUnit(count > 100);
+   }  // teardown
+
+   // every partition kernel agrees with the scalar one
+   void test_partitionBatch_agree()
+   {  // setup
+      std::vector<int> keys{ INT_MIN, INT_MAX, -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+      std::vector<uint32_t> expected(keys.size());
+      custom::simd::partitionBatchScalar(keys.data(), keys.size(), 16, expected.data());
+      // exercise and verify
+      for (batch kernel : partitionKernels())
+      {
+         std::vector<uint32_t> out(keys.size());
+         kernel(keys.data(), keys.size(), 16, out.data());
+         assertUnit(out == expected);
+      }
+   }  // teardown
+
+   /***************************************
+    * SCRAMBLE
+    ***************************************/
+
+   // unscramble undoes scramble for every kind of key
+   void test_scramble_inverse()
+   {  // setup
+      std::vector<int> keys{ INT_MIN, INT_MAX, -1, 0, 1, 55, 67, 31 };
+      for (int i = 0; i < 10000; i++)
+         keys.push_back((int)((uint32_t)i * 429497u));   // all over the range
+      // exercise
+      size_t wrong = 0;
+      for (int key : keys)
+         if (custom::simd::unscramble(custom::simd::scramble(key)) != key)
+            wrong++;
+      // verify
+      assertUnit(wrong == 0);
+      assertUnit(custom::simd::scramble(0) == 0);
+   }  // teardown
+
+   // a dense run of keys comes out spread over the whole range
+   void test_scramble_spreads()
+   {  // setup
+      size_t counts[16] = {};
+      // exercise
+      for (int key = 1000000; key < 1016000; key++)
+         counts[(uint32_t)custom::simd::scramble(key) >> 28]++;
+      // verify
+      size_t fewest = 16000;
+      for (size_t count : counts)
+         fewest = (count < fewest) ? count : fewest;
+      assertUnit(fewest > 800);   // 1000 each if perfectly even
+   }  // teardown
+
+   // every batch kernel this CPU can run
+   typedef custom::simd::batchFunction batch;
+   static std::vector<batch> bucketKernels()
+   {
+      std::vector<batch> all{ custom::simd::bucketBatchScalar, custom::simd::bucketBatch };
+#ifdef HASH_SIMD_X86
+      if (custom::simd::hasAvx2())
+         all.push_back(custom::simd::bucketBatchAvx2);
+#endif
+      return all;
+   }
+   static std::vector<batch> partitionKernels()
+   {
+      std::vector<batch> all{ custom::simd::partitionBatchScalar, custom::simd::partitionBatch };
+#ifdef HASH_SIMD_X86
+      if (custom::simd::hasAvx2())
+         all.push_back(custom::simd::partitionBatchAvx2);
+#endif
+      return all;
+   }
+
+   // every probe kernel this CPU can run
+   static std::vector<custom::simd::probeFunction> kernels()
+   {
+      std::vector<custom::simd::probeFunction> all;
+      all.push_back(custom::simd::probeScalar);
+#ifdef HASH_SIMD_X86
+      all.push_back(custom::simd::probeSse2);
+      if (custom::simd::hasAvx2())
+         all.push_back(custom::simd::probeAvx2);
+#endif
+      return all;
+   }
+};
+
+#endif // DEBUG
@@ -15,6 +15,10 @@
 #undef assertComplexFixture
 #undef assertStandardFixture
 #undef assertEmptyFixture
+#undef assertLargeFixture
+#undef assertThroughput
+#undef assertScalesLinearly
+#undef expectSlow
 
 
 #define assertUnit(condition)     assertUnitParameters(condition, #condition, __LINE__, __FUNCTION__)
@@ -22,11 +26,20 @@
 #define assertComplexFixture(x)   assertComplexFixtureParameters( x, __LINE__, __FUNCTION__)
 #define assertStandardFixture(x)  assertStandardFixtureParameters(x, __LINE__, __FUNCTION__)
 #define assertEmptyFixture(x)     assertEmptyFixtureParameters(   x, __LINE__, __FUNCTION__)
+#define assertLargeFixture(x, k)  assertLargeFixtureParameters(   x, k, __LINE__, __FUNCTION__)
+#define assertThroughput(setup, exercise, n, minPerSecond) \
+   assertThroughputParameters(setup, exercise, n, minPerSecond, #exercise, __LINE__, __FUNCTION__)
+#define assertScalesLinearly(setup, exercise, sizes, tolerance) \
+   assertScalesLinearlyParameters(setup, exercise, sizes, tolerance, #exercise, __LINE__, __FUNCTION__)
+#define expectSlow(seconds)       expectSlowParameters(seconds, __FUNCTION__)
 
 #include <iostream>  // for std::cerr
 #include <string>    // for std::string
 #include <vector>    // for std::vector
 #include <map>       // for std::map
+#include <cassert>   // for assert()
+#include <chrono>    // for std::chrono::steady_clock
+#include <sstream>   // for std::ostringstream
 
 
 class UnitTest
@@ -45,7 +58,15 @@ private:
    // each test has a name (the key) and the list of failures(value).
    std::map<std::string, std::vector<Failure>> tests;
 
+   // wall-clock seconds spent in each test, and when the last assert ran
+   std::map<std::string, double> seconds;
+   std::map<std::string, double> expected;   // tests allowed past slowThreshold
+   std::chrono::steady_clock::time_point lastMark;
+
 protected:
+   // tests slower than this are named in the report even when they pass
+   double slowThreshold = 1.0;
+
    /*************************************************************
     * RESET
     * Reset the statistics
@@ -53,6 +74,23 @@ protected:
    void reset()
    {
       tests.clear();
+      seconds.clear();
+      expected.clear();
+      lastMark = std::chrono::steady_clock::now();
+   }
+
+   /*************************************************************
+    * MARK
+    * Charge the time since the previous assert to this test. Tests
+    * run one after another and each does its work before asserting,
+    * so this adds up to the wall-clock time of every test without
+    * the tests having to time themselves.
+    *************************************************************/
+   void mark(const std::string& sFunc)
+   {
+      auto now = std::chrono::steady_clock::now();
+      seconds[sFunc] += std::chrono::duration<double>(now - lastMark).count();
+      lastMark = now;
    }
    
    /*************************************************************
@@ -61,15 +99,25 @@ protected:
     *************************************************************/
    void report(const char * name)
    {    
-      // enumerate the failures, if there are any
+      std::cerr.setf(std::ios::fixed | std::ios::showpoint);
+      std::cerr.precision(3);
+
+      // enumerate the failures and the slow tests, if there are any
+      double total = 0.0;
       for (auto & test : tests)
+      {
+         double time = seconds[test.first];
+         total += time;
          if (!test.second.empty())
          {
-            std::cerr << "\t" << test.first << "()\n";
+            std::cerr << "\t" << test.first << "()\t" << time << "s\n";
             for (auto & failure : test.second)
                std::cerr << "\t\tline:"   << failure.lineNumber
                          << " condition:" << failure.failure << "\n";
          }
+         else if (time > (expected.count(test.first) ? expected[test.first] : slowThreshold))
+            std::cerr << "\t" << test.first << "()\t" << time << "s slow\n";
+      }
 
       // Name the test case
       std::cerr << name << ":\t";
@@ -93,10 +141,22 @@ protected:
       std::cerr << "There were "
          << tests.size()
          << " tests run for a success rate of: "
-         << (successRate * 100.0) << "%\n";
+         << (successRate * 100.0) << "%";
+      std::cerr.precision(3);
+      std::cerr << " in " << total << "s\n";
 
    }
    
+   /*************************************************************
+    * EXPECT SLOW PARAMETERS
+    * A test that is big on purpose names how long it may take before
+    * the report calls it slow
+    *************************************************************/
+   void expectSlowParameters(double limit, const char* func)
+   {
+      expected[std::string(func)] = limit;
+   }
+
    /*************************************************************
     * ASSERT UNIT PARAMETERS
     * Custom assert code so we can see all the errors at once
@@ -105,6 +165,7 @@ protected:
                              int line, const char* func)
    {
       std::string sFunc(func);
+      mark(sFunc);
 
       if (!condition)
       {
@@ -130,6 +191,7 @@ protected:
                                      int lineCheck, const char* funcCheck)
    {
       std::string sFunc(funcOriginal);
+      mark(sFunc);
       
       if (!condition)
       {
@@ -143,6 +205,82 @@ protected:
          tests[sFunc];
       }
    }
+
+   /*************************************************************
+    * TIME PER OPERATION
+    * Run setup(n) untimed, then exercise(n) timed. The best of a
+    * few runs is kept so one unlucky context switch does not count.
+    * Both are template parameters so the timed call is direct rather
+    * than through std::function. Returns nanoseconds per operation.
+    *************************************************************/
+   template <class Setup, class Exercise>
+   double timePerOperation(Setup& setup, Exercise& exercise, size_t n)
+   {
+      double best = -1.0;
+      for (int run = 0; run < 3; run++)
+      {
+         setup(n);
+         auto begin = std::chrono::steady_clock::now();
+         exercise(n);
+         auto end = std::chrono::steady_clock::now();
+         double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+         if (best < 0.0 || ns < best)
+            best = ns;
+      }
+      return best / (double)(n ? n : 1);
+   }
+
+   /*************************************************************
+    * ASSERT THROUGHPUT PARAMETERS
+    * Fail when exercise(n) performs fewer than minPerSecond
+    * operations per second
+    *************************************************************/
+   template <class Setup, class Exercise>
+   void assertThroughputParameters(Setup&& setup, Exercise&& exercise,
+                                   size_t n, double minPerSecond,
+                                   const char* exerciseString,
+                                   int line, const char* func)
+   {
+      double ns = timePerOperation(setup, exercise, n);
+      double perSecond = (ns > 0.0) ? 1.0e9 / ns : 1.0e18;
+
+      std::ostringstream condition;
+      condition << exerciseString << " ran " << perSecond
+                << " ops/s, wanted at least " << minPerSecond;
+      assertUnitParameters(perSecond >= minPerSecond, condition.str().c_str(), line, func);
+   }
+
+   /*************************************************************
+    * ASSERT SCALES LINEARLY PARAMETERS
+    * Time exercise(n) at each size. The total time should grow with
+    * n, so the cost of one operation must stay (roughly) flat. Fail
+    * when the per-operation cost at any size is more than tolerance
+    * times the cost at the smallest size: that is the signature of
+    * an O(1) operation going O(n).
+    *************************************************************/
+   template <class Setup, class Exercise>
+   void assertScalesLinearlyParameters(Setup&& setup, Exercise&& exercise,
+                                       const std::vector<size_t>& sizes, double tolerance,
+                                       const char* exerciseString,
+                                       int line, const char* func)
+   {
+      assert(!sizes.empty());
+      std::vector<double> ns;
+      for (size_t n : sizes)
+         ns.push_back(timePerOperation(setup, exercise, n));
+
+      // a 1ns floor keeps an unmeasurably fast smallest size from
+      // turning ordinary noise into a huge ratio
+      double baseline = (ns[0] > 1.0) ? ns[0] : 1.0;
+      for (size_t i = 1; i < sizes.size(); i++)
+      {
+         std::ostringstream condition;
+         condition << exerciseString << " took " << ns[0] << "ns/op at n="
+                   << sizes[0] << " but " << ns[i] << "ns/op at n=" << sizes[i];
+         assertUnitParameters(ns[i] <= baseline * tolerance,
+                              condition.str().c_str(), line, func);
+      }
+   }
 };
 
 #endif // DEBUG